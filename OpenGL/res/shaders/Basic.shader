@@ -1,31 +1,79 @@
+#keywords TEXTURED VERTEX_COLOR
+
 #shader vertex
 #version 330 core
 
 layout(location = 0) in vec4 position;
 layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 vertexColor;
 
+// Stages compiled to SPIR-V separately are matched by location rather than by name
+#ifdef GL_SPIRV
+layout(location = 0) out vec2 v_TexCoord;
+layout(location = 1) out vec4 v_Color;
+#else
 out vec2 v_TexCoord;
+out vec4 v_Color;
+#endif
 
-uniform mat4 u_MVP;
+// GL_SPIRV is defined when compiling to SPIR-V, which has no block names to bind at runtime
+#ifdef GL_SPIRV
+layout(std140, binding = 0) uniform Camera
+#else
+layout(std140) uniform Camera
+#endif
+{
+    mat4 u_ViewProjection;
+};
+
+#ifdef GL_SPIRV
+layout(std140, binding = 1) uniform Draw
+#else
+layout(std140) uniform Draw
+#endif
+{
+    mat4 u_Model;
+    vec4 u_Color;
+};
 
 void main()
 {
-    gl_Position = u_MVP * position;
+    gl_Position = u_ViewProjection * u_Model * position;
     v_TexCoord = texCoord;
-};
+    v_Color = VERTEX_COLOR ? vertexColor : vec4(1.0);
+}
 
 #shader fragment
 #version 330 core
 
 layout(location = 0) out vec4 color;
 
+#ifdef GL_SPIRV
+layout(location = 0) in vec2 v_TexCoord;
+layout(location = 1) in vec4 v_Color;
+#else
 in vec2 v_TexCoord;
+in vec4 v_Color;
+#endif
+
+#ifdef GL_SPIRV
+layout(std140, binding = 1) uniform Draw
+#else
+layout(std140) uniform Draw
+#endif
+{
+    mat4 u_Model;
+    vec4 u_Color;
+};
 
-uniform vec4 u_Color;
+#ifdef GL_SPIRV
+layout(binding = 0) uniform sampler2D u_Texture;
+#else
 uniform sampler2D u_Texture;
+#endif
 
 void main()
 {
-    vec4 texColor = texture(u_Texture, v_TexCoord);
-    color = texColor;
-};
\ No newline at end of file
+    vec4 texColor = TEXTURED ? texture(u_Texture, v_TexCoord) : u_Color;
+    color = texColor * v_Color;
+}
@@ -0,0 +1,56 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in float layer;
+
+// Stages compiled to SPIR-V separately are matched by location rather than by name
+#ifdef GL_SPIRV
+layout(location = 0) out vec2 v_TexCoord;
+layout(location = 1) flat out float v_Layer;
+#else
+out vec2 v_TexCoord;
+flat out float v_Layer;
+#endif
+
+#ifdef GL_SPIRV
+layout(std140, binding = 0) uniform Camera
+#else
+layout(std140) uniform Camera
+#endif
+{
+    mat4 u_ViewProjection;
+};
+
+void main()
+{
+    gl_Position = u_ViewProjection * position;
+    v_TexCoord = texCoord;
+    v_Layer = layer;
+}
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+#ifdef GL_SPIRV
+layout(location = 0) in vec2 v_TexCoord;
+layout(location = 1) flat in float v_Layer;
+#else
+in vec2 v_TexCoord;
+flat in float v_Layer;
+#endif
+
+// Every sprite in a batch samples the same array, each picks its own layer
+#ifdef GL_SPIRV
+layout(binding = 0) uniform sampler2DArray u_Textures;
+#else
+uniform sampler2DArray u_Textures;
+#endif
+
+void main()
+{
+    color = texture(u_Textures, vec3(v_TexCoord, v_Layer));
+}
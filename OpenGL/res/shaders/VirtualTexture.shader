@@ -0,0 +1,89 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 texCoord;
+
+// Stages compiled to SPIR-V separately are matched by location rather than by name
+#ifdef GL_SPIRV
+layout(location = 0) out vec2 v_TexCoord;
+#else
+out vec2 v_TexCoord;
+#endif
+
+#ifdef GL_SPIRV
+layout(std140, binding = 0) uniform Camera
+#else
+layout(std140) uniform Camera
+#endif
+{
+    mat4 u_ViewProjection;
+};
+
+void main()
+{
+    gl_Position = u_ViewProjection * position;
+    v_TexCoord = texCoord;
+}
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+#ifdef GL_SPIRV
+layout(location = 0) in vec2 v_TexCoord;
+#else
+in vec2 v_TexCoord;
+#endif
+
+// Bound by VirtualTexture::Bind
+#ifdef GL_SPIRV
+layout(std140, binding = 2) uniform VirtualTexture
+#else
+layout(std140) uniform VirtualTexture
+#endif
+{
+    vec4 u_ImageInfo;    // Level 0 width and height, tile size, border
+    vec4 u_PhysicalInfo; // Physical texture size, pages per side, level count
+};
+
+#ifdef GL_SPIRV
+layout(binding = 0) uniform sampler2D u_Physical;
+layout(binding = 1) uniform sampler2D u_Indirection;
+#else
+uniform sampler2D u_Physical;    // Tile pages, bilinear
+uniform sampler2D u_Indirection; // Page + 1 per tile in RG, one mip per pyramid level
+#endif
+
+void main()
+{
+    ivec2 imageSize = ivec2(u_ImageInfo.xy);
+    float tileSize = u_ImageInfo.z;
+    float border = u_ImageInfo.w;
+    int levelCount = int(u_PhysicalInfo.z);
+
+    // Same choice as VirtualTexture::GetLevel, the level with at least one texel per pixel
+    vec2 texel = v_TexCoord * vec2(imageSize);
+    float footprint = max(length(dFdx(texel)), length(dFdy(texel)));
+    int level = min(int(floor(log2(max(footprint, 1.0)))), levelCount - 1);
+
+    // Falls back to coarser levels until a resident tile covers this pixel, the top level always is
+    for (; level < levelCount; level++) {
+        ivec2 levelSize = max(imageSize >> level, ivec2(1));
+        vec2 levelTexel = v_TexCoord * vec2(levelSize);
+        ivec2 tiles = (levelSize + int(tileSize) - 1) / int(tileSize);
+        ivec2 tile = clamp(ivec2(levelTexel / tileSize), ivec2(0), tiles - 1);
+        vec2 entry = texelFetch(u_Indirection, tile, level).rg;
+        int page = int(entry.r * 255.0 + 0.5) + int(entry.g * 255.0 + 0.5) * 256 - 1;
+        if (page >= 0) {
+            int pagesPerSide = int(u_PhysicalInfo.y);
+            vec2 pageOrigin = vec2(page % pagesPerSide, page / pagesPerSide) * (tileSize + 2.0 * border);
+            vec2 inTile = clamp(levelTexel - vec2(tile) * tileSize, 0.0, tileSize);
+            // The physical texture has the one level, and implicit derivatives are undefined in this non-uniform loop
+            color = textureLod(u_Physical, (pageOrigin + border + inTile) / u_PhysicalInfo.x, 0.0);
+            return;
+        }
+    }
+    color = vec4(0.0, 0.0, 0.0, 1.0);
+}
@@ -0,0 +1,199 @@
+#include "AtlasBuilder.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+// Private copy, ImGui compiles its own the same way
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imgui/stb_rect_pack.h"
+
+// Images are packed in cells of at least this many texels, which is what keeps them on the block grid
+static const int MIN_CELL_SIZE = 4;
+
+struct AtlasBuilder::Page {
+    stbrp_context Context;
+    std::vector<stbrp_node> Nodes;
+    std::vector<unsigned char> Pixels;
+    std::vector<AtlasBuilder::Rect> DirtyRects;
+};
+
+// Copies the image to (x, y) and repeats its edge texels padding wide around it, so filtering and mips
+// near the edge see more of the same image rather than its neighbour
+static void BlitWithGutter(unsigned char* page, int pageSize, int x, int y, int width, int height, int padding, const unsigned char* rgba) {
+    for (int row = -padding; row < height + padding; row++) {
+        const unsigned char* source = rgba + (size_t)std::min(std::max(row, 0), height - 1) * width * 4;
+        unsigned char* destination = page + ((size_t)(y + row) * pageSize + x - padding) * 4;
+        for (int i = 0; i < padding; i++) {
+            memcpy(destination + i * 4, source, 4);
+            memcpy(destination + (padding + width + i) * 4, source + (width - 1) * 4, 4);
+        }
+        memcpy(destination + padding * 4, source, (size_t)width * 4);
+    }
+}
+
+static int GetCells(int size, int padding, int cellSize) {
+    return (size + 2 * padding + cellSize - 1) / cellSize;
+}
+
+AtlasBuilder::AtlasBuilder(int pageSize, int padding)
+    : m_PageSize(0), m_Padding((std::max(0, padding) + MIN_CELL_SIZE - 1) / MIN_CELL_SIZE * MIN_CELL_SIZE), m_MipCount(1), m_CellSize(0) {
+    // A texel of level n covers 2^n texels of the base, once that's wider than the gutter an image's edge
+    // texels take in its neighbour
+    while ((1 << m_MipCount) <= m_Padding) {
+        m_MipCount++;
+    }
+    // Cells as wide as a texel of the last level keep every image's rect whole at every level
+    m_CellSize = std::max(MIN_CELL_SIZE, 1 << (m_MipCount - 1));
+    m_PageSize = (pageSize + m_CellSize - 1) / m_CellSize * m_CellSize;
+}
+
+AtlasBuilder::~AtlasBuilder() {
+}
+
+int AtlasBuilder::Add(int width, int height, const unsigned char* rgba) {
+    return Add(std::vector<int>{ width }, std::vector<int>{ height }, std::vector<const unsigned char*>{ rgba })[0];
+}
+
+std::vector<int> AtlasBuilder::Add(const std::vector<int>& widths, const std::vector<int>& heights, const std::vector<const unsigned char*>& images) {
+    std::vector<int> regions(images.size(), -1);
+    std::vector<int> pending;
+    int pageCells = m_PageSize / m_CellSize;
+    for (int i = 0; i < (int)images.size(); i++) {
+        if (widths[i] <= 0 || heights[i] <= 0 || GetCells(widths[i], m_Padding, m_CellSize) > pageCells ||
+            GetCells(heights[i], m_Padding, m_CellSize) > pageCells) {
+            std::cout << "Image " << widths[i] << "x" << heights[i] << " doesn't fit on a " << m_PageSize << " atlas page" << std::endl;
+            continue;
+        }
+        pending.push_back(i);
+    }
+
+    for (int page = 0; page < (int)m_Pages.size() && !pending.empty(); page++) {
+        PackIntoPage(page, pending, widths, heights, images, regions);
+    }
+    while (!pending.empty()) {
+        std::unique_ptr<Page> page = std::make_unique<Page>();
+        page->Nodes.resize(pageCells);
+        page->Pixels.resize((size_t)m_PageSize * m_PageSize * 4, 0);
+        stbrp_init_target(&page->Context, pageCells, pageCells, page->Nodes.data(), (int)page->Nodes.size());
+        m_Pages.push_back(std::move(page));
+
+        if (PackIntoPage((int)m_Pages.size() - 1, pending, widths, heights, images, regions) == 0) {
+            break; // Can't happen since everything pending fits on an empty page
+        }
+    }
+    return regions;
+}
+
+int AtlasBuilder::PackIntoPage(int page, std::vector<int>& pending, const std::vector<int>& widths, const std::vector<int>& heights,
+                               const std::vector<const unsigned char*>& images, std::vector<int>& regions) {
+    std::vector<stbrp_rect> rects(pending.size());
+    for (size_t i = 0; i < pending.size(); i++) {
+        rects[i].id = pending[i];
+        rects[i].w = (stbrp_coord)GetCells(widths[pending[i]], m_Padding, m_CellSize);
+        rects[i].h = (stbrp_coord)GetCells(heights[pending[i]], m_Padding, m_CellSize);
+    }
+    // Sorts by height internally, so a batch goes in tallest first
+    Page& target = *m_Pages[page];
+    stbrp_pack_rects(&target.Context, rects.data(), (int)rects.size());
+
+    int packed = 0;
+    pending.clear();
+    for (const stbrp_rect& rect : rects) {
+        if (!rect.was_packed) {
+            pending.push_back(rect.id);
+            continue;
+        }
+        Region region;
+        region.Page = page;
+        region.X = rect.x * m_CellSize + m_Padding;
+        region.Y = rect.y * m_CellSize + m_Padding;
+        region.Width = widths[rect.id];
+        region.Height = heights[rect.id];
+        ComputeUVs(region, m_PageSize);
+        BlitWithGutter(target.Pixels.data(), m_PageSize, region.X, region.Y, region.Width, region.Height, m_Padding, images[rect.id]);
+        target.DirtyRects.push_back({ rect.x * m_CellSize, rect.y * m_CellSize, rect.w * m_CellSize, rect.h * m_CellSize });
+
+        regions[rect.id] = (int)m_Regions.size();
+        m_Regions.push_back(region);
+        packed++;
+    }
+    return packed;
+}
+
+const unsigned char* AtlasBuilder::GetPage(int page) const {
+    return m_Pages[page]->Pixels.data();
+}
+
+const std::vector<AtlasBuilder::Rect>& AtlasBuilder::GetDirtyRects(int page) const {
+    return m_Pages[page]->DirtyRects;
+}
+
+void AtlasBuilder::ClearDirty() {
+    for (std::unique_ptr<Page>& page : m_Pages) {
+        page->DirtyRects.clear();
+    }
+}
+
+void AtlasBuilder::ComputeUVs(Region& region, int pageSize) {
+    region.U0 = (float)region.X / pageSize;
+    region.V0 = (float)region.Y / pageSize;
+    region.U1 = (float)(region.X + region.Width) / pageSize;
+    region.V1 = (float)(region.Y + region.Height) / pageSize;
+}
+
+// atlas <page size>
+// page <file>, one per page in order
+// region <page> <x> <y> <width> <height> <name>, the name runs to the end of the line
+bool AtlasBuilder::WriteTable(const std::string& path, const Table& table) {
+    std::ofstream stream(path);
+    stream << "atlas " << table.PageSize << "\n";
+    for (const std::string& file : table.PageFiles) {
+        stream << "page " << file << "\n";
+    }
+    for (size_t i = 0; i < table.Regions.size(); i++) {
+        const Region& region = table.Regions[i];
+        stream << "region " << region.Page << " " << region.X << " " << region.Y << " " << region.Width << " " << region.Height
+               << " " << table.Names[i] << "\n";
+    }
+    return (bool)stream;
+}
+
+bool AtlasBuilder::ReadTable(const std::string& path, Table& table) {
+    std::ifstream stream(path);
+    table = Table();
+    std::string line;
+    if (!std::getline(stream, line) || sscanf(line.c_str(), "atlas %d", &table.PageSize) != 1) {
+        std::cout << "Failed to load atlas table " << path << std::endl;
+        return false;
+    }
+    while (std::getline(stream, line)) {
+        std::stringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        if (kind == "page") {
+            std::string file;
+            fields >> std::ws;
+            std::getline(fields, file);
+            table.PageFiles.push_back(file);
+        }
+        else if (kind == "region") {
+            Region region;
+            std::string name;
+            if (!(fields >> region.Page >> region.X >> region.Y >> region.Width >> region.Height)) {
+                std::cout << "Bad region in atlas table " << path << ": " << line << std::endl;
+                return false;
+            }
+            fields >> std::ws;
+            std::getline(fields, name);
+            ComputeUVs(region, table.PageSize);
+            table.Names.push_back(name);
+            table.Regions.push_back(region);
+        }
+    }
+    return true;
+}
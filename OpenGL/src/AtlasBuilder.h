@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+
+// Packs many small images into square RGBA8 atlas pages with stb_rect_pack, so they can be drawn from a
+// handful of textures instead of one each. No GL here, TextureCooker packs with it offline and SpriteAtlas
+// at runtime.
+// Every image gets a gutter of its own edge texels repeated Padding wide, and sits on a 4 texel grid so
+// block compression never mixes two images in one block. A gutter only keeps mips down to log2(Padding)
+// from bleeding, pages should stop at GetMipCount levels. Wider padding packs on a coarser grid to match.
+// Pages are stored bottom row first like everything passed to GL.
+class AtlasBuilder {
+public:
+	struct Region {
+		int Page;
+		int X, Y, Width, Height; // Texels, without the gutter
+		float U0, V0, U1, V1;
+	};
+
+	struct Rect {
+		int X, Y, Width, Height;
+	};
+
+	// Written by TextureCooker --atlas next to the cooked pages, maps sprite names to regions
+	struct Table {
+		int PageSize;
+		std::vector<std::string> PageFiles;
+		std::vector<std::string> Names;
+		std::vector<Region> Regions; // Same order as Names
+	};
+private:
+	struct Page;
+
+	int m_PageSize;
+	int m_Padding;
+	int m_MipCount;
+	int m_CellSize; // Images are packed on a grid of this many texels
+	std::vector<std::unique_ptr<Page>> m_Pages;
+	std::vector<Region> m_Regions;
+public:
+	// padding is rounded up to a multiple of 4, pageSize to a multiple of the packing grid
+	AtlasBuilder(int pageSize = 1024, int padding = 4);
+	~AtlasBuilder();
+
+	// rgba is width * height RGBA8 texels with the bottom row first. Returns the region index, or -1 if the
+	// image doesn't fit on a page. Packs into the existing pages first and opens a new one only when it has to
+	int Add(int width, int height, const unsigned char* rgba);
+	// Same for a batch, packed largest first which fills pages tighter than adding one at a time.
+	// images[i] is width * height RGBA8 texels, returns a region index (or -1) per image
+	std::vector<int> Add(const std::vector<int>& widths, const std::vector<int>& heights, const std::vector<const unsigned char*>& images);
+
+	inline const Region& GetRegion(int index) const { return m_Regions[index]; }
+	inline const std::vector<Region>& GetRegions() const { return m_Regions; }
+	inline int GetPageSize() const { return m_PageSize; }
+	inline int GetPageCount() const { return (int)m_Pages.size(); }
+	// Levels whose texels along an image's edge stay within its gutter, base level included
+	inline int GetMipCount() const { return m_MipCount; }
+	// PageSize * PageSize RGBA8 texels
+	const unsigned char* GetPage(int page) const;
+	// Areas of the page written to since the last ClearDirty, the cells of each image packed since. Every side
+	// is a multiple of 2^(GetMipCount() - 1), so each mip level of a rect can be built and uploaded on its own
+	const std::vector<Rect>& GetDirtyRects(int page) const;
+	void ClearDirty();
+
+	static bool WriteTable(const std::string& path, const Table& table);
+	static bool ReadTable(const std::string& path, Table& table);
+private:
+	// Packs what it can of the rects into one page and blits them, returns how many it placed
+	int PackIntoPage(int page, std::vector<int>& pending, const std::vector<int>& widths, const std::vector<int>& heights,
+					 const std::vector<const unsigned char*>& images, std::vector<int>& regions);
+	static void ComputeUVs(Region& region, int pageSize);
+};
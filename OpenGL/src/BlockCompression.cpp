@@ -0,0 +1,716 @@
+#include "BlockCompression.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <GL/glew.h>
+#include "ThreadPool.h"
+
+// SSE2 is guaranteed on x64 and is MSVC's default for x86
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define BLOCK_COMPRESSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace BlockCompression {
+    namespace {
+        struct Color {
+            float r, g, b;
+        };
+
+        struct ColorBlock {
+            Color Colors[16];
+#ifdef BLOCK_COMPRESSION_SSE2
+            alignas(16) float R[16], G[16], B[16]; // Colors again split by channel, 4 texels per register
+#endif
+            bool Transparent[16], Used[16];
+            bool AnyTransparent;
+        };
+
+        unsigned short PackRGB565(const Color& c) {
+            // Truncating x + 0.5 rounds like lround for everything the clamp doesn't catch, without the libm call
+            int r = std::min(31, std::max(0, (int)(c.r * (31.0f / 255.0f) + 0.5f)));
+            int g = std::min(63, std::max(0, (int)(c.g * (63.0f / 255.0f) + 0.5f)));
+            int b = std::min(31, std::max(0, (int)(c.b * (31.0f / 255.0f) + 0.5f)));
+            return (unsigned short)((r << 11) | (g << 5) | b);
+        }
+
+        Color UnpackRGB565(unsigned short packed) {
+            // Bit replication, the same expansion the hardware decoder does
+            int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+            return { (float)((r << 3) | (r >> 2)), (float)((g << 2) | (g >> 4)), (float)((b << 3) | (b >> 2)) };
+        }
+
+        float DistanceSquared(const Color& a, const Color& b) {
+            float dr = a.r - b.r, dg = a.g - b.g, db = a.b - b.b;
+            return dr * dr + dg * dg + db * db;
+        }
+
+        Color Lerp(const Color& a, const Color& b, float t) {
+            return { a.r + (b.r - a.r) * t, a.g + (b.g - a.g) * t, a.b + (b.b - a.b) * t };
+        }
+
+        // Principal axis of the block's colors through power iteration on the covariance matrix,
+        // endpoints are the extremes of the projection onto it, pulled in slightly to reduce error
+        void FindEndpoints(const Color* colors, const bool* used, Color& low, Color& high) {
+            Color mean = { 0, 0, 0 };
+            int count = 0;
+            for (int i = 0; i < 16; i++) {
+                if (used[i]) {
+                    mean.r += colors[i].r; mean.g += colors[i].g; mean.b += colors[i].b;
+                    count++;
+                }
+            }
+            if (count == 0) {
+                low = high = { 0, 0, 0 };
+                return;
+            }
+            mean = { mean.r / count, mean.g / count, mean.b / count };
+
+            float cov[6] = { 0, 0, 0, 0, 0, 0 };
+            for (int i = 0; i < 16; i++) {
+                if (!used[i]) {
+                    continue;
+                }
+                float r = colors[i].r - mean.r, g = colors[i].g - mean.g, b = colors[i].b - mean.b;
+                cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+                cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+            }
+
+            Color axis = { 1.0f, 1.0f, 1.0f };
+            for (int iteration = 0; iteration < 4; iteration++) {
+                Color next = {
+                    axis.r * cov[0] + axis.g * cov[1] + axis.b * cov[2],
+                    axis.r * cov[1] + axis.g * cov[3] + axis.b * cov[4],
+                    axis.r * cov[2] + axis.g * cov[4] + axis.b * cov[5]
+                };
+                float length = std::max(std::max(std::fabs(next.r), std::fabs(next.g)), std::fabs(next.b));
+                if (length < 1e-6f) {
+                    break;
+                }
+                axis = { next.r / length, next.g / length, next.b / length };
+            }
+
+            float minT = 1e30f, maxT = -1e30f;
+            for (int i = 0; i < 16; i++) {
+                if (!used[i]) {
+                    continue;
+                }
+                float t = (colors[i].r - mean.r) * axis.r + (colors[i].g - mean.g) * axis.g + (colors[i].b - mean.b) * axis.b;
+                minT = std::min(minT, t);
+                maxT = std::max(maxT, t);
+            }
+            float axisLengthSquared = axis.r * axis.r + axis.g * axis.g + axis.b * axis.b;
+            if (axisLengthSquared > 0.0f) {
+                minT /= axisLengthSquared;
+                maxT /= axisLengthSquared;
+            }
+            float inset = (maxT - minT) / 32.0f;
+            minT += inset;
+            maxT -= inset;
+
+            low = { mean.r + axis.r * minT, mean.g + axis.g * minT, mean.b + axis.b * minT };
+            high = { mean.r + axis.r * maxT, mean.g + axis.g * maxT, mean.b + axis.b * maxT };
+            low = { std::min(255.0f, std::max(0.0f, low.r)), std::min(255.0f, std::max(0.0f, low.g)), std::min(255.0f, std::max(0.0f, low.b)) };
+            high = { std::min(255.0f, std::max(0.0f, high.r)), std::min(255.0f, std::max(0.0f, high.g)), std::min(255.0f, std::max(0.0f, high.b)) };
+        }
+
+        // Picks indices for a given endpoint pair and returns the total error
+        float ChooseIndices(const ColorBlock& block, unsigned short c0, unsigned short c1, bool threeColor, unsigned int& indices) {
+            Color palette[4];
+            palette[0] = UnpackRGB565(c0);
+            palette[1] = UnpackRGB565(c1);
+            int paletteSize;
+            if (threeColor) {
+                palette[2] = Lerp(palette[0], palette[1], 0.5f);
+                paletteSize = 3;
+            }
+            else {
+                palette[2] = Lerp(palette[0], palette[1], 1.0f / 3.0f);
+                palette[3] = Lerp(palette[0], palette[1], 2.0f / 3.0f);
+                paletteSize = 4;
+            }
+
+            indices = 0;
+#ifdef BLOCK_COMPRESSION_SSE2
+            // 4 color mode is every block without punch-through and where nearly all the time goes
+            if (!threeColor) {
+                __m128 error = _mm_setzero_ps();
+                for (int i = 0; i < 16; i += 4) {
+                    __m128 r = _mm_load_ps(block.R + i), g = _mm_load_ps(block.G + i), b = _mm_load_ps(block.B + i);
+                    __m128 bestDistance = _mm_set1_ps(1e30f);
+                    __m128i best = _mm_setzero_si128();
+                    for (int p = 0; p < 4; p++) {
+                        __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[p].r));
+                        __m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[p].g));
+                        __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[p].b));
+                        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+                        // Strictly closer only, so ties keep the lower index like the scalar loop
+                        __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, bestDistance));
+                        bestDistance = _mm_min_ps(distance, bestDistance);
+                        best = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, best));
+                    }
+                    error = _mm_add_ps(error, bestDistance);
+
+                    alignas(16) int lanes[4];
+                    _mm_store_si128((__m128i*)lanes, best);
+                    for (int j = 0; j < 4; j++) {
+                        indices |= (unsigned int)lanes[j] << ((i + j) * 2);
+                    }
+                }
+                alignas(16) float sums[4];
+                _mm_store_ps(sums, error);
+                return sums[0] + sums[1] + sums[2] + sums[3];
+            }
+#endif
+
+            const Color* colors = block.Colors;
+            float error = 0.0f;
+            for (int i = 0; i < 16; i++) {
+                unsigned int best = 0;
+                if (threeColor && block.Transparent[i]) {
+                    best = 3;
+                }
+                else {
+                    float bestDistance = 1e30f;
+                    for (int p = 0; p < paletteSize; p++) {
+                        float distance = DistanceSquared(colors[i], palette[p]);
+                        if (distance < bestDistance) {
+                            bestDistance = distance;
+                            best = p;
+                        }
+                    }
+                    error += bestDistance;
+                }
+                indices |= best << (i * 2);
+            }
+            return error;
+        }
+
+        // Least squares endpoints for the current index assignment (4 color mode only)
+        bool RefitEndpoints(const Color* colors, unsigned int indices, Color& low, Color& high) {
+            static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+            float aa = 0, ab = 0, bb = 0;
+            Color ax = { 0, 0, 0 }, bx = { 0, 0, 0 };
+            for (int i = 0; i < 16; i++) {
+                float a = weights[(indices >> (i * 2)) & 3], b = 1.0f - a;
+                aa += a * a; ab += a * b; bb += b * b;
+                ax.r += a * colors[i].r; ax.g += a * colors[i].g; ax.b += a * colors[i].b;
+                bx.r += b * colors[i].r; bx.g += b * colors[i].g; bx.b += b * colors[i].b;
+            }
+            float determinant = aa * bb - ab * ab;
+            if (std::fabs(determinant) < 1e-6f) {
+                return false;
+            }
+            float inverse = 1.0f / determinant;
+            high = { (bb * ax.r - ab * bx.r) * inverse, (bb * ax.g - ab * bx.g) * inverse, (bb * ax.b - ab * bx.b) * inverse };
+            low = { (aa * bx.r - ab * ax.r) * inverse, (aa * bx.g - ab * ax.g) * inverse, (aa * bx.b - ab * ax.b) * inverse };
+            return true;
+        }
+
+        // Packs the pair in 4 color mode order (c0 > c1) and picks its indices, returns the total error.
+        // A pair that packs to a single color decodes in 3 color mode, where index 0 still means c0.
+        float EncodeColorEndpoints(const ColorBlock& block, const Color& low, const Color& high, unsigned short& c0, unsigned short& c1,
+                                   unsigned int& indices) {
+            c0 = PackRGB565(high);
+            c1 = PackRGB565(low);
+            if (c0 < c1) {
+                std::swap(c0, c1);
+            }
+            // For a flat block every palette entry is c0 and ties keep index 0
+            return ChooseIndices(block, c0, c1, false, indices);
+        }
+
+        void WriteColorBlock(unsigned short c0, unsigned short c1, unsigned int indices, unsigned char* out) {
+            out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+            out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+            out[4] = indices & 0xFF; out[5] = (indices >> 8) & 0xFF;
+            out[6] = (indices >> 16) & 0xFF; out[7] = (indices >> 24) & 0xFF;
+        }
+
+        // Fast path endpoints: the corners of the block's bounding box, inset by a sixteenth of the range.
+        // The box diagonal only follows the colors when every channel rises together, so a channel that
+        // falls against the widest one gets its ends swapped.
+        void FindBoundingBoxEndpoints(const unsigned char* rgba, Color& low, Color& high) {
+            int minimum[3], maximum[3];
+#ifdef BLOCK_COMPRESSION_SSE2
+            __m128i rows[4];
+            for (int i = 0; i < 4; i++) {
+                rows[i] = _mm_loadu_si128((const __m128i*)(rgba + i * 16));
+            }
+            __m128i lowest = _mm_min_epu8(_mm_min_epu8(rows[0], rows[1]), _mm_min_epu8(rows[2], rows[3]));
+            __m128i highest = _mm_max_epu8(_mm_max_epu8(rows[0], rows[1]), _mm_max_epu8(rows[2], rows[3]));
+            // Fold the 4 texels per register down to one
+            lowest = _mm_min_epu8(lowest, _mm_shuffle_epi32(lowest, _MM_SHUFFLE(1, 0, 3, 2)));
+            lowest = _mm_min_epu8(lowest, _mm_shuffle_epi32(lowest, _MM_SHUFFLE(2, 3, 0, 1)));
+            highest = _mm_max_epu8(highest, _mm_shuffle_epi32(highest, _MM_SHUFFLE(1, 0, 3, 2)));
+            highest = _mm_max_epu8(highest, _mm_shuffle_epi32(highest, _MM_SHUFFLE(2, 3, 0, 1)));
+            int lowPacked = _mm_cvtsi128_si32(lowest), highPacked = _mm_cvtsi128_si32(highest);
+            for (int c = 0; c < 3; c++) {
+                minimum[c] = (lowPacked >> (c * 8)) & 0xFF;
+                maximum[c] = (highPacked >> (c * 8)) & 0xFF;
+            }
+#else
+            for (int c = 0; c < 3; c++) {
+                minimum[c] = 255;
+                maximum[c] = 0;
+                for (int i = 0; i < 16; i++) {
+                    minimum[c] = std::min(minimum[c], (int)rgba[i * 4 + c]);
+                    maximum[c] = std::max(maximum[c], (int)rgba[i * 4 + c]);
+                }
+            }
+#endif
+
+            int widest = 0;
+            for (int c = 1; c < 3; c++) {
+                if (maximum[c] - minimum[c] > maximum[widest] - minimum[widest]) {
+                    widest = c;
+                }
+            }
+            float lowValues[3], highValues[3];
+            for (int c = 0; c < 3; c++) {
+                float inset = (maximum[c] - minimum[c]) / 16.0f;
+                lowValues[c] = minimum[c] + inset;
+                highValues[c] = maximum[c] - inset;
+                if (c == widest) {
+                    continue;
+                }
+                int covariance = 0;
+                int widestCenter = (minimum[widest] + maximum[widest]) / 2, center = (minimum[c] + maximum[c]) / 2;
+                for (int i = 0; i < 16; i++) {
+                    covariance += (rgba[i * 4 + widest] - widestCenter) * (rgba[i * 4 + c] - center);
+                }
+                if (covariance < 0) {
+                    std::swap(lowValues[c], highValues[c]);
+                }
+            }
+            low = { lowValues[0], lowValues[1], lowValues[2] };
+            high = { highValues[0], highValues[1], highValues[2] };
+        }
+
+        void CompressColorBlock(const unsigned char* rgba, unsigned char* out, bool allowPunchThrough, Quality quality) {
+            ColorBlock block;
+            block.AnyTransparent = false;
+            for (int i = 0; i < 16; i++) {
+                block.Colors[i] = { (float)rgba[i * 4 + 0], (float)rgba[i * 4 + 1], (float)rgba[i * 4 + 2] };
+#ifdef BLOCK_COMPRESSION_SSE2
+                block.R[i] = block.Colors[i].r;
+                block.G[i] = block.Colors[i].g;
+                block.B[i] = block.Colors[i].b;
+#endif
+                block.Transparent[i] = allowPunchThrough && rgba[i * 4 + 3] < 128;
+                block.Used[i] = !block.Transparent[i];
+                block.AnyTransparent = block.AnyTransparent || block.Transparent[i];
+            }
+
+            Color low, high;
+            if (block.AnyTransparent) {
+                // The bounding box can't leave transparent texels out, those blocks always take the principal axis.
+                // 3 color mode is selected by c0 <= c1, index 3 decodes as transparent black
+                FindEndpoints(block.Colors, block.Used, low, high);
+                unsigned short c0 = PackRGB565(high), c1 = PackRGB565(low);
+                if (c0 > c1) {
+                    std::swap(c0, c1);
+                }
+                unsigned int indices;
+                ChooseIndices(block, c0, c1, true, indices);
+                WriteColorBlock(c0, c1, indices, out);
+                return;
+            }
+
+            // Every step past Fast starts from the best pair so far and only keeps a pair that lowers the
+            // squared error, so raising the quality never makes a block worse
+            FindBoundingBoxEndpoints(rgba, low, high);
+            unsigned short c0, c1;
+            unsigned int indices;
+            float error = EncodeColorEndpoints(block, low, high, c0, c1, indices);
+            if (quality == Quality::Fast) {
+                WriteColorBlock(c0, c1, indices, out);
+                return;
+            }
+
+            FindEndpoints(block.Colors, block.Used, low, high);
+            unsigned short a0, a1;
+            unsigned int axisIndices;
+            float axisError = EncodeColorEndpoints(block, low, high, a0, a1, axisIndices);
+            if (axisError < error) {
+                c0 = a0; c1 = a1; indices = axisIndices; error = axisError;
+            }
+
+            // Normal refits once, High keeps refitting while it helps
+            int refits = quality == Quality::Normal ? 1 : 4;
+            for (int refit = 0; refit < refits && c0 != c1 && RefitEndpoints(block.Colors, indices, low, high); refit++) {
+                unsigned short r0, r1;
+                unsigned int refitIndices;
+                float refitError = EncodeColorEndpoints(block, low, high, r0, r1, refitIndices);
+                if (refitError >= error) {
+                    break;
+                }
+                c0 = r0; c1 = r1; indices = refitIndices; error = refitError;
+            }
+            WriteColorBlock(c0, c1, indices, out);
+        }
+
+        // Nearest of the 8 value palette for each of the 16 values, returns the summed squared error
+        unsigned int ChooseAlphaIndices(const unsigned char* values, int high, int low, unsigned long long& indices) {
+            // 8 value mode (a0 > a1): index 0 is a0, 1 is a1, 2-7 step from a0 towards a1 in sevenths
+            int palette[8];
+            palette[0] = high;
+            palette[1] = low;
+            for (int i = 2; i < 8; i++) {
+                palette[i] = ((8 - i) * high + (i - 1) * low + 3) / 7;
+            }
+
+            unsigned char best[16];
+            unsigned int error = 0;
+#ifdef BLOCK_COMPRESSION_SSE2
+            // All 16 values fit one register as bytes, |a - b| is the OR of both saturating differences
+            __m128i block = _mm_loadu_si128((const __m128i*)values);
+            __m128i bestDistance = _mm_set1_epi8((char)0xFF);
+            __m128i bestIndex = _mm_setzero_si128();
+            for (int p = 0; p < 8; p++) {
+                __m128i entry = _mm_set1_epi8((char)palette[p]);
+                __m128i distance = _mm_or_si128(_mm_subs_epu8(block, entry), _mm_subs_epu8(entry, block));
+                // Strictly closer is "the minimum moved", matches the scalar tie-break
+                __m128i smaller = _mm_min_epu8(distance, bestDistance);
+                __m128i closer = _mm_andnot_si128(_mm_cmpeq_epi8(smaller, bestDistance), _mm_set1_epi8((char)0xFF));
+                bestDistance = smaller;
+                bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi8((char)p)), _mm_andnot_si128(closer, bestIndex));
+            }
+            _mm_storeu_si128((__m128i*)best, bestIndex);
+            // Widen to 16 bits so madd can square and pair up the distances
+            __m128i lowHalf = _mm_unpacklo_epi8(bestDistance, _mm_setzero_si128());
+            __m128i highHalf = _mm_unpackhi_epi8(bestDistance, _mm_setzero_si128());
+            __m128i sums = _mm_add_epi32(_mm_madd_epi16(lowHalf, lowHalf), _mm_madd_epi16(highHalf, highHalf));
+            sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(1, 0, 3, 2)));
+            sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(2, 3, 0, 1)));
+            error = (unsigned int)_mm_cvtsi128_si32(sums);
+#else
+            for (int i = 0; i < 16; i++) {
+                int bestDistance = 256;
+                for (int p = 0; p < 8; p++) {
+                    int distance = std::abs(values[i] - palette[p]);
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best[i] = (unsigned char)p;
+                    }
+                }
+                error += bestDistance * bestDistance;
+            }
+#endif
+
+            indices = 0;
+            for (int i = 0; i < 16; i++) {
+                indices |= (unsigned long long)best[i] << (i * 3);
+            }
+            return error;
+        }
+
+        // Least squares endpoints for the current 8 value mode indices, false if they don't stay a0 > a1
+        bool RefitAlphaEndpoints(const unsigned char* values, unsigned long long indices, int& high, int& low) {
+            float aa = 0, ab = 0, bb = 0, ax = 0, bx = 0;
+            for (int i = 0; i < 16; i++) {
+                unsigned int index = (unsigned int)(indices >> (i * 3)) & 7;
+                float a = index == 0 ? 1.0f : index == 1 ? 0.0f : (8 - index) / 7.0f, b = 1.0f - a;
+                aa += a * a; ab += a * b; bb += b * b;
+                ax += a * values[i]; bx += b * values[i];
+            }
+            float determinant = aa * bb - ab * ab;
+            if (std::fabs(determinant) < 1e-6f) {
+                return false;
+            }
+            float inverse = 1.0f / determinant;
+            high = std::min(255, std::max(0, (int)((bb * ax - ab * bx) * inverse + 0.5f)));
+            low = std::min(255, std::max(0, (int)((aa * bx - ab * ax) * inverse + 0.5f)));
+            return high > low;
+        }
+
+        // Refits while it lowers the squared error, at most refits times
+        void RefineAlphaEndpoints(const unsigned char* values, int refits, int& a0, int& a1, unsigned long long& indices, unsigned int& error) {
+            for (int refit = 0; refit < refits; refit++) {
+                int r0, r1;
+                if (!RefitAlphaEndpoints(values, indices, r0, r1) || (r0 == a0 && r1 == a1)) {
+                    return;
+                }
+                unsigned long long candidate;
+                unsigned int candidateError = ChooseAlphaIndices(values, r0, r1, candidate);
+                if (candidateError >= error) {
+                    return;
+                }
+                a0 = r0; a1 = r1; indices = candidate; error = candidateError;
+            }
+        }
+
+        // Packs up to 128 bits least significant bit first, the order every BCn format uses
+        struct BitWriter {
+            unsigned char* Out;
+            unsigned int Position;
+
+            void Write(unsigned int value, unsigned int bits) {
+                for (unsigned int i = 0; i < bits; i++, Position++) {
+                    if (value & (1u << i)) {
+                        Out[Position >> 3] |= (unsigned char)(1u << (Position & 7));
+                    }
+                }
+            }
+        };
+    }
+
+    unsigned int GetBlockSize(Format format) {
+        return (format == Format::BC1 || format == Format::BC4) ? 8 : 16;
+    }
+
+    unsigned int GetGLFormat(Format format) {
+        switch (format) {
+            case Format::BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            case Format::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case Format::BC4: return GL_COMPRESSED_RED_RGTC1;
+            case Format::BC5: return GL_COMPRESSED_RG_RGTC2;
+            case Format::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        }
+        return 0;
+    }
+
+    void CompressBlockBC1(const unsigned char* rgba, unsigned char* out, Quality quality) {
+        CompressColorBlock(rgba, out, true, quality);
+    }
+
+    void CompressBlockBC3(const unsigned char* rgba, unsigned char* out, Quality quality) {
+        CompressBlockBC4(rgba, out, 3, quality);
+        // BC3 always decodes its color block in 4 color mode, there's no punch-through
+        CompressColorBlock(rgba, out + 8, false, quality);
+    }
+
+    void CompressBlockBC4(const unsigned char* rgba, unsigned char* out, unsigned int channel, Quality quality) {
+        unsigned char values[16];
+        int low = 255, high = 0;
+        for (int i = 0; i < 16; i++) {
+            values[i] = rgba[i * 4 + channel];
+            low = std::min(low, (int)values[i]);
+            high = std::max(high, (int)values[i]);
+        }
+
+        memset(out, 0, 8);
+        out[0] = (unsigned char)high;
+        out[1] = (unsigned char)low;
+        if (high == low) {
+            return;
+        }
+
+        // As with the color block, each step only keeps endpoints that lower the squared error and High
+        // starts from Normal's result, so raising the quality never makes a block worse
+        int a0 = high, a1 = low;
+        unsigned long long indices;
+        unsigned int error = ChooseAlphaIndices(values, a0, a1, indices);
+        if (quality != Quality::Fast) {
+            RefineAlphaEndpoints(values, 1, a0, a1, indices, error);
+        }
+        if (quality == Quality::High) {
+            // Outliers stretch the min / max palette, pulling either end in a few steps often fits the rest better
+            for (int highInset = 0; highInset < 4; highInset++) {
+                for (int lowInset = 0; lowInset < 4; lowInset++) {
+                    int c0 = high - highInset, c1 = low + lowInset;
+                    if ((highInset == 0 && lowInset == 0) || c0 <= c1) {
+                        continue;
+                    }
+                    unsigned long long candidate;
+                    unsigned int candidateError = ChooseAlphaIndices(values, c0, c1, candidate);
+                    if (candidateError < error) {
+                        a0 = c0; a1 = c1; indices = candidate; error = candidateError;
+                    }
+                }
+            }
+            RefineAlphaEndpoints(values, 4, a0, a1, indices, error);
+        }
+        out[0] = (unsigned char)a0;
+        out[1] = (unsigned char)a1;
+        for (int i = 0; i < 6; i++) {
+            out[2 + i] = (unsigned char)(indices >> (i * 8));
+        }
+    }
+
+    void CompressBlockBC5(const unsigned char* rgba, unsigned char* out, Quality quality) {
+        CompressBlockBC4(rgba, out, 0, quality);
+        CompressBlockBC4(rgba, out + 8, 1, quality);
+    }
+
+    void CompressBlockBC7(const unsigned char* rgba, unsigned char* out) {
+        static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        // Principal axis in RGBA, same power iteration as the BC1 path with alpha as a fourth dimension
+        float mean[4] = { 0, 0, 0, 0 };
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 4; c++) {
+                mean[c] += rgba[i * 4 + c] / 16.0f;
+            }
+        }
+        float cov[4][4] = {};
+        for (int i = 0; i < 16; i++) {
+            for (int a = 0; a < 4; a++) {
+                for (int b = 0; b < 4; b++) {
+                    cov[a][b] += (rgba[i * 4 + a] - mean[a]) * (rgba[i * 4 + b] - mean[b]);
+                }
+            }
+        }
+        float axis[4] = { 1, 1, 1, 1 };
+        for (int iteration = 0; iteration < 4; iteration++) {
+            float next[4] = { 0, 0, 0, 0 };
+            float length = 0.0f;
+            for (int a = 0; a < 4; a++) {
+                for (int b = 0; b < 4; b++) {
+                    next[a] += cov[a][b] * axis[b];
+                }
+                length = std::max(length, std::fabs(next[a]));
+            }
+            if (length < 1e-6f) {
+                break;
+            }
+            for (int a = 0; a < 4; a++) {
+                axis[a] = next[a] / length;
+            }
+        }
+        float minT = 1e30f, maxT = -1e30f, axisLengthSquared = 0.0f;
+        for (int a = 0; a < 4; a++) {
+            axisLengthSquared += axis[a] * axis[a];
+        }
+        for (int i = 0; i < 16; i++) {
+            float t = 0.0f;
+            for (int c = 0; c < 4; c++) {
+                t += (rgba[i * 4 + c] - mean[c]) * axis[c];
+            }
+            minT = std::min(minT, t / axisLengthSquared);
+            maxT = std::max(maxT, t / axisLengthSquared);
+        }
+
+        // Endpoints are 7 bits per channel plus a shared p-bit per endpoint, pick the p-bit that lands closer
+        int endpoints[2][4];
+        int pbits[2];
+        for (int e = 0; e < 2; e++) {
+            float t = e == 0 ? minT : maxT;
+            float target[4];
+            for (int c = 0; c < 4; c++) {
+                target[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * t));
+            }
+            float bestError = 1e30f;
+            for (int p = 0; p < 2; p++) {
+                int quantized[4];
+                float error = 0.0f;
+                for (int c = 0; c < 4; c++) {
+                    quantized[c] = std::min(127, std::max(0, (int)std::lround((target[c] - p) / 2.0f)));
+                    float difference = (float)((quantized[c] << 1) | p) - target[c];
+                    error += difference * difference;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    pbits[e] = p;
+                    memcpy(endpoints[e], quantized, sizeof(quantized));
+                }
+            }
+        }
+
+        int expanded[2][4];
+        for (int e = 0; e < 2; e++) {
+            for (int c = 0; c < 4; c++) {
+                expanded[e][c] = (endpoints[e][c] << 1) | pbits[e];
+            }
+        }
+        int palette[16][4];
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 4; c++) {
+                palette[i][c] = ((64 - weights[i]) * expanded[0][c] + weights[i] * expanded[1][c] + 32) >> 6;
+            }
+        }
+
+        int indices[16];
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestDistance = 1 << 30;
+            for (int p = 0; p < 16; p++) {
+                int distance = 0;
+                for (int c = 0; c < 4; c++) {
+                    int difference = rgba[i * 4 + c] - palette[p][c];
+                    distance += difference * difference;
+                }
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices[i] = best;
+        }
+
+        // Texel 0's index is stored with its top bit implied zero, swapping the endpoints guarantees that
+        if (indices[0] >= 8) {
+            std::swap(endpoints[0], endpoints[1]);
+            std::swap(pbits[0], pbits[1]);
+            for (int i = 0; i < 16; i++) {
+                indices[i] = 15 - indices[i];
+            }
+        }
+
+        memset(out, 0, 16);
+        BitWriter writer = { out, 0 };
+        writer.Write(1 << 6, 7); // Mode 6
+        for (int c = 0; c < 4; c++) {
+            writer.Write(endpoints[0][c], 7);
+            writer.Write(endpoints[1][c], 7);
+        }
+        writer.Write(pbits[0], 1);
+        writer.Write(pbits[1], 1);
+        writer.Write(indices[0], 3);
+        for (int i = 1; i < 16; i++) {
+            writer.Write(indices[i], 4);
+        }
+    }
+
+    void CompressBlock(Format format, const unsigned char* rgba, unsigned char* out, Quality quality) {
+        switch (format) {
+            case Format::BC1: CompressBlockBC1(rgba, out, quality); break;
+            case Format::BC3: CompressBlockBC3(rgba, out, quality); break;
+            case Format::BC4: CompressBlockBC4(rgba, out, 0, quality); break;
+            case Format::BC5: CompressBlockBC5(rgba, out, quality); break;
+            case Format::BC7: CompressBlockBC7(rgba, out); break;
+        }
+    }
+
+    unsigned int GetCompressedSize(Format format, int width, int height) {
+        return ((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+    }
+
+    void CompressBlockRows(Format format, const unsigned char* rgba, int width, int height, unsigned int firstRow, unsigned int lastRow,
+                           unsigned char* out, Quality quality) {
+        unsigned int blockSize = GetBlockSize(format);
+        out += (size_t)firstRow * ((width + 3) / 4) * blockSize;
+        unsigned char block[64];
+        for (int by = firstRow * 4; by < (int)lastRow * 4; by += 4) {
+            for (int bx = 0; bx < width; bx += 4) {
+                if (bx + 4 <= width && by + 4 <= height) {
+                    for (int y = 0; y < 4; y++) {
+                        memcpy(&block[y * 16], &rgba[((size_t)(by + y) * width + bx) * 4], 16);
+                    }
+                }
+                else {
+                    for (int y = 0; y < 4; y++) {
+                        int sy = std::min(by + y, height - 1);
+                        for (int x = 0; x < 4; x++) {
+                            int sx = std::min(bx + x, width - 1);
+                            memcpy(&block[(y * 4 + x) * 4], &rgba[((size_t)sy * width + sx) * 4], 4);
+                        }
+                    }
+                }
+                CompressBlock(format, block, out, quality);
+                out += blockSize;
+            }
+        }
+    }
+
+    void CompressImage(Format format, const unsigned char* rgba, int width, int height, unsigned char* out, Quality quality) {
+        CompressBlockRows(format, rgba, width, height, 0, (height + 3) / 4, out, quality);
+    }
+
+    void CompressImageParallel(Format format, const unsigned char* rgba, int width, int height, unsigned char* out, Quality quality) {
+        // Block rows write disjoint ranges of out, so the chunks need no synchronisation
+        ThreadPool::Get().ParallelFor((height + 3) / 4, [&](unsigned int begin, unsigned int end) {
+            CompressBlockRows(format, rgba, width, height, begin, end, out, quality);
+        });
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+// Block compression encoders. Every function takes one 4x4 block of RGBA8 texels (64 bytes, row by row)
+// and writes one compressed block. Block sizes: BC1 and BC4 are 8 bytes, BC3, BC5 and BC7 are 16.
+namespace BlockCompression {
+	enum class Format {
+		BC1, // RGB + 1 bit alpha, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+		BC3, // RGBA, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+		BC4, // R only, GL_COMPRESSED_RED_RGTC1
+		BC5, // RG for normal maps, GL_COMPRESSED_RG_RGTC2
+		BC7  // RGBA high quality, GL_COMPRESSED_RGBA_BPTC_UNORM
+	};
+
+	// Speed / quality trade-off for BC1, BC3, BC4 and BC5. BC7 only has the one encoder.
+	// Each level starts from the one below and only keeps changes that lower the squared error.
+	enum class Quality {
+		Fast,   // Bounding box endpoints, no refinement. For content compressed at runtime
+		Normal, // Also tries principal axis endpoints, then one least squares refit
+		High    // Refits until the error stops dropping, BC4 also tries pulling its endpoints in
+	};
+
+	unsigned int GetBlockSize(Format format);
+	unsigned int GetGLFormat(Format format);
+
+	void CompressBlockBC1(const unsigned char* rgba, unsigned char* out, Quality quality = Quality::Normal);
+	void CompressBlockBC3(const unsigned char* rgba, unsigned char* out, Quality quality = Quality::Normal);
+	// channel picks which of R, G, B, A (0-3) gets encoded
+	void CompressBlockBC4(const unsigned char* rgba, unsigned char* out, unsigned int channel = 0, Quality quality = Quality::Normal);
+	void CompressBlockBC5(const unsigned char* rgba, unsigned char* out, Quality quality = Quality::Normal);
+	// Mode 6 only (single subset, 4 bit indices), a fraction of what a full BC7 search does but far cheaper
+	void CompressBlockBC7(const unsigned char* rgba, unsigned char* out);
+
+	void CompressBlock(Format format, const unsigned char* rgba, unsigned char* out, Quality quality = Quality::Normal);
+
+	// Compresses a whole image, edges are padded by repeating the last row / column.
+	// out must hold GetCompressedSize(format, width, height) bytes.
+	unsigned int GetCompressedSize(Format format, int width, int height);
+	void CompressImage(Format format, const unsigned char* rgba, int width, int height, unsigned char* out, Quality quality = Quality::Normal);
+	// Compresses block rows [firstRow, lastRow) of the image into their place in out
+	void CompressBlockRows(Format format, const unsigned char* rgba, int width, int height, unsigned int firstRow, unsigned int lastRow,
+						   unsigned char* out, Quality quality = Quality::Normal);
+	// Same result as CompressImage with the block rows split across ThreadPool::Get(), blocks until done
+	void CompressImageParallel(Format format, const unsigned char* rgba, int width, int height, unsigned char* out, Quality quality = Quality::Normal);
+}
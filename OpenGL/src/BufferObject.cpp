@@ -0,0 +1,166 @@
+#include "BufferObject.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "Renderer.h"
+#include "DeletionQueue.h"
+
+static GLenum GetGLUsage(BufferUsage usage) {
+    switch (usage) {
+        case BufferUsage::Dynamic: return GL_DYNAMIC_DRAW;
+        case BufferUsage::Stream: return GL_STREAM_DRAW;
+        default: return GL_STATIC_DRAW;
+    }
+}
+
+BufferObject::BufferObject(unsigned int target, const void* data, unsigned int size, BufferUsage usage)
+    : m_RendererID(0), m_Target(target), m_Size(size), m_Usage(usage), m_Mapped(false) {
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLCall(glBindBuffer(m_Target, m_RendererID));
+    GLCall(glBufferData(m_Target, size, data, GetGLUsage(m_Usage)));
+}
+
+BufferObject::BufferObject(BufferObject&& other)
+    : m_RendererID(other.m_RendererID), m_Target(other.m_Target), m_Size(other.m_Size), m_Usage(other.m_Usage),
+      m_Pending(std::move(other.m_Pending)), m_Staging(std::move(other.m_Staging)), m_Run(std::move(other.m_Run)), m_Mapped(other.m_Mapped) {
+    other.m_RendererID = 0;
+    other.m_Size = 0;
+    other.m_Mapped = false;
+}
+
+BufferObject& BufferObject::operator=(BufferObject&& other) {
+    if (this != &other) {
+        Delete();
+        m_RendererID = other.m_RendererID;
+        m_Target = other.m_Target;
+        m_Size = other.m_Size;
+        m_Usage = other.m_Usage;
+        m_Pending = std::move(other.m_Pending);
+        m_Staging = std::move(other.m_Staging);
+        m_Run = std::move(other.m_Run);
+        m_Mapped = other.m_Mapped;
+        other.m_RendererID = 0;
+        other.m_Size = 0;
+        other.m_Mapped = false;
+    }
+    return *this;
+}
+
+BufferObject::~BufferObject() {
+    Delete();
+}
+
+void BufferObject::Delete() {
+    if (m_RendererID == 0) {
+        return;
+    }
+    DeletionQueue::DeleteBuffer(m_RendererID);
+    m_RendererID = 0;
+}
+
+void BufferObject::SetData(const void* data, unsigned int size, unsigned int offset) {
+    ASSERT(offset + size <= m_Size);
+    if (size == 0) {
+        return;
+    }
+    m_Pending.push_back({ offset, size, m_Staging.size() });
+    m_Staging.insert(m_Staging.end(), (const unsigned char*)data, (const unsigned char*)data + size);
+}
+
+void BufferObject::Flush() {
+    ASSERT(!m_Mapped);
+    if (m_Pending.empty()) {
+        return;
+    }
+
+    // Writes in offset order, stable so the later of two writes to the same bytes is still copied last
+    std::vector<unsigned int> order(m_Pending.size());
+    for (unsigned int i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) { return m_Pending[a].Offset < m_Pending[b].Offset; });
+
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+    size_t first = 0;
+    while (first < order.size()) {
+        unsigned int begin = m_Pending[order[first]].Offset;
+        unsigned int end = begin + m_Pending[order[first]].Size;
+        size_t last = first + 1;
+        while (last < order.size() && m_Pending[order[last]].Offset <= end) {
+            end = std::max(end, m_Pending[order[last]].Offset + m_Pending[order[last]].Size);
+            last++;
+        }
+
+        const unsigned char* data = &m_Staging[m_Pending[order[first]].Staging];
+        if (last - first > 1) {
+            // Overlapping writes land in the order they were queued
+            std::sort(order.begin() + first, order.begin() + last);
+            m_Run.resize(end - begin);
+            for (size_t i = first; i < last; i++) {
+                const PendingWrite& write = m_Pending[order[i]];
+                memcpy(&m_Run[write.Offset - begin], &m_Staging[write.Staging], write.Size);
+            }
+            data = m_Run.data();
+        }
+
+        if (begin == 0 && end == m_Size) {
+            GLCall(glBufferData(GL_COPY_WRITE_BUFFER, m_Size, data, GetGLUsage(m_Usage)));
+        }
+        else {
+            GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, begin, end - begin, data));
+        }
+        first = last;
+    }
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+
+    m_Pending.clear();
+    m_Staging.clear();
+}
+
+void BufferObject::Reallocate(const void* data, unsigned int size) {
+    ASSERT(!m_Mapped);
+    m_Pending.clear();
+    m_Staging.clear();
+    m_Size = size;
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+    GLCall(glBufferData(GL_COPY_WRITE_BUFFER, size, data, GetGLUsage(m_Usage)));
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+}
+
+void* BufferObject::Map(unsigned int offset, unsigned int size, bool unsynchronized) {
+    ASSERT(!m_Mapped && size > 0 && offset + size <= m_Size);
+    Flush();
+
+    GLbitfield access = GL_MAP_WRITE_BIT;
+    access |= offset == 0 && size == m_Size ? GL_MAP_INVALIDATE_BUFFER_BIT : GL_MAP_INVALIDATE_RANGE_BIT;
+    if (unsynchronized) {
+        access |= GL_MAP_UNSYNCHRONIZED_BIT;
+    }
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+    GLCall(void* pointer = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, access));
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    m_Mapped = pointer != nullptr;
+    return pointer;
+}
+
+void BufferObject::Unmap() {
+    ASSERT(m_Mapped);
+    m_Mapped = false;
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+    GLCall(GLboolean intact = glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    if (!intact) {
+        // Rare, the storage was lost while mapped (mode switch and the like), so the contents are undefined
+        std::cout << "Buffer " << m_RendererID << " was corrupted while mapped, rewrite it" << std::endl;
+    }
+}
+
+void BufferObject::Bind() const {
+    GLCall(glBindBuffer(m_Target, m_RendererID));
+}
+
+void BufferObject::Unbind() const {
+    GLCall(glBindBuffer(m_Target, 0));
+}
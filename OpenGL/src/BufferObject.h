@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// How often the contents change, picks the GL usage hint
+enum class BufferUsage {
+	Static, // Written once and drawn many times
+	Dynamic, // Parts rewritten now and then
+	Stream // Rewritten every frame or so
+};
+
+// GL buffer shared by VertexBuffer and IndexBuffer, sizes and offsets in bytes.
+// SetData only queues a write. Flush merges the queued writes that overlap or touch and sends each run
+// in one glBufferSubData, and when a run covers the whole buffer it goes through glBufferData instead,
+// orphaning the old storage so the driver hands out fresh memory rather than waiting on draws still
+// reading the previous contents. Mapping the whole buffer invalidates it for the same reason.
+// Updates and maps go through GL_COPY_WRITE_BUFFER, so they never change the element buffer of
+// whichever VAO happens to be bound.
+class BufferObject {
+private:
+	struct PendingWrite {
+		unsigned int Offset;
+		unsigned int Size;
+		size_t Staging; // Start of its bytes in m_Staging
+	};
+
+	unsigned int m_RendererID;
+	unsigned int m_Target;
+	unsigned int m_Size;
+	BufferUsage m_Usage;
+	std::vector<PendingWrite> m_Pending;
+	std::vector<unsigned char> m_Staging;
+	std::vector<unsigned char> m_Run; // Scratch for runs assembled from several writes
+	bool m_Mapped;
+public:
+	// Leaves the buffer bound to target. data may be null for storage with undefined contents
+	BufferObject(unsigned int target, const void* data, unsigned int size, BufferUsage usage);
+	// Move only, a copy would delete the same GL buffer twice. The moved from buffer owns nothing
+	BufferObject(BufferObject&& other);
+	BufferObject& operator=(BufferObject&& other);
+	BufferObject(const BufferObject&) = delete;
+	BufferObject& operator=(const BufferObject&) = delete;
+	~BufferObject();
+
+	void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+	void Flush();
+	// New storage of size bytes, dropping the old contents and any queued writes
+	void Reallocate(const void* data, unsigned int size);
+
+	// Write only, flushes queued writes first. The mapped range is invalidated, or the whole buffer when
+	// the range covers it. unsynchronized skips waiting on the GPU, for ranges no draw in flight reads
+	void* Map(unsigned int offset, unsigned int size, bool unsynchronized = false);
+	void Unmap();
+
+	void Bind() const;
+	void Unbind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetSize() const { return m_Size; }
+	inline BufferUsage GetUsage() const { return m_Usage; }
+	inline bool IsMapped() const { return m_Mapped; }
+private:
+	void Delete();
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <GL/glew.h>
+
+// .gltex container, written offline by TextureCooker and read by Texture.
+// Pixels are stored ready for upload: rows already flipped bottom-up for OpenGL, mip chain
+// precomputed, alpha premultiplied unless the flag says otherwise, blocks already compressed.
+//
+//	CookedTextureHeader
+//	MipCount times: unsigned int byte size, then that many bytes, largest level first
+
+#define COOKED_TEXTURE_MAGIC "GLTX"
+#define COOKED_TEXTURE_VERSION 1
+
+enum CookedTextureFlags : unsigned int {
+	COOKED_PREMULTIPLIED_ALPHA = 1 << 0,
+	COOKED_FLIPPED = 1 << 1
+};
+
+// The formats TextureCooker writes, also used by .gltiles. Anything else in a header means the file is damaged
+// or wasn't cooked, and isn't passed on to GL
+inline bool IsCookedTextureFormat(unsigned int glFormat) {
+	switch (glFormat) {
+		case GL_RGBA8:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_RG_RGTC2:
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			return true;
+		default:
+			return false;
+	}
+}
+
+struct CookedTextureHeader {
+	char Magic[4];
+	unsigned int Version;
+	unsigned int GLFormat; // Internal format for glCompressedTexImage2D, GL_RGBA8 when stored uncompressed
+	unsigned int Width, Height;
+	unsigned int MipCount;
+	unsigned int Flags;
+};
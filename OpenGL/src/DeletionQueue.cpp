@@ -0,0 +1,142 @@
+#include "DeletionQueue.h"
+
+#include <algorithm>
+#include <utility>
+#include "Renderer.h"
+#include "VertexArrayCache.h"
+
+DeletionQueue* DeletionQueue::s_Instance = nullptr;
+
+DeletionQueue::DeletionQueue(unsigned int maxDeletionsPerFrame) : m_MaxDeletionsPerFrame(maxDeletionsPerFrame), m_Pending(0) {
+    ASSERT(s_Instance == nullptr);
+    s_Instance = this;
+}
+
+DeletionQueue::~DeletionQueue() {
+    Flush();
+    s_Instance = nullptr;
+}
+
+void DeletionQueue::Delete(Type type, unsigned int name) {
+    if (name == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Queued.push_back({ type, name });
+}
+
+void DeletionQueue::EndFrame() {
+    Batch batch{};
+    batch.Fence = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        batch.Deletions.swap(m_Queued);
+    }
+    if (!batch.Deletions.empty()) {
+        // Everything this frame submitted, so every use of these objects, comes before the fence
+        batch.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_Pending += (unsigned int)batch.Deletions.size();
+        m_Batches.push_back(std::move(batch));
+    }
+
+    unsigned int budget = m_MaxDeletionsPerFrame;
+    while (!m_Batches.empty() && budget > 0) {
+        Batch& oldest = m_Batches.front();
+        if (oldest.Fence) {
+            GLint status = GL_UNSIGNALED;
+            GLCall(glGetSynciv(oldest.Fence, GL_SYNC_STATUS, 1, nullptr, &status));
+            if (status != GL_SIGNALED) {
+                // Fences signal in order, nothing newer is done either
+                break;
+            }
+            GLCall(glDeleteSync(oldest.Fence));
+            oldest.Fence = nullptr;
+        }
+        budget -= DeleteBatch(oldest, budget);
+        if (oldest.Deletions.empty()) {
+            m_Batches.pop_front();
+        }
+    }
+}
+
+void DeletionQueue::Flush() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_Queued.empty()) {
+            Batch batch{};
+            batch.Fence = nullptr;
+            batch.Deletions = std::move(m_Queued);
+            m_Batches.push_back(std::move(batch));
+            m_Queued.clear();
+        }
+    }
+    if (m_Batches.empty()) {
+        return;
+    }
+    GLCall(glFinish());
+    for (Batch& batch : m_Batches) {
+        if (batch.Fence) {
+            GLCall(glDeleteSync(batch.Fence));
+        }
+        for (const Deletion& deletion : batch.Deletions) {
+            DeleteNow(deletion.ObjectType, deletion.Name);
+        }
+    }
+    m_Batches.clear();
+    m_Pending = 0;
+}
+
+unsigned int DeletionQueue::DeleteBatch(Batch& batch, unsigned int budget) {
+    unsigned int count = std::min(budget, (unsigned int)batch.Deletions.size());
+    for (unsigned int i = 0; i < count; i++) {
+        DeleteNow(batch.Deletions[i].ObjectType, batch.Deletions[i].Name);
+    }
+    batch.Deletions.erase(batch.Deletions.begin(), batch.Deletions.begin() + count);
+    m_Pending -= count;
+    return count;
+}
+
+void DeletionQueue::DeleteNow(Type type, unsigned int name) {
+    switch (type) {
+        case Type::Buffer:
+            // Only now can the name be handed out again, so only now can a VAO built for it be confused with another
+            if (VertexArrayCache::Exists()) {
+                VertexArrayCache::Get().OnBufferDeleted(name);
+            }
+            GLCall(glDeleteBuffers(1, &name));
+            break;
+        case Type::Texture:
+            GLCall(glDeleteTextures(1, &name));
+            break;
+        case Type::Program:
+            GLCall(glDeleteProgram(name));
+            break;
+    }
+}
+
+void DeletionQueue::DeleteBuffer(unsigned int buffer) {
+    if (Exists()) {
+        Get().Delete(Type::Buffer, buffer);
+    }
+    else if (buffer != 0) {
+        DeleteNow(Type::Buffer, buffer);
+    }
+}
+
+void DeletionQueue::DeleteTexture(unsigned int texture) {
+    if (Exists()) {
+        Get().Delete(Type::Texture, texture);
+    }
+    else if (texture != 0) {
+        DeleteNow(Type::Texture, texture);
+    }
+}
+
+void DeletionQueue::DeleteProgram(unsigned int program) {
+    if (Exists()) {
+        Get().Delete(Type::Program, program);
+    }
+    else if (program != 0) {
+        DeleteNow(Type::Program, program);
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <vector>
+
+typedef struct __GLsync* GLsync;
+
+// Holds on to GL objects that are no longer wanted until the GPU is done with them. glDelete* on an object
+// a draw in flight still reads can stall in the driver, and a test going away with all its textures and
+// buffers at once turns into one long frame. Deletions queued during a frame are tagged with a fence
+// placed at its end, and EndFrame deletes them once that fence has signaled, at most a budget of objects
+// per frame. Delete can be called from any thread, nothing touches GL until EndFrame on the render thread.
+// The wrappers go through DeleteBuffer, DeleteTexture and DeleteProgram, which delete right away while there's
+// no queue. It's constructed before anything owning GL objects so it's the last to go.
+class DeletionQueue {
+public:
+	enum class Type {
+		Buffer,
+		Texture,
+		Program
+	};
+private:
+	struct Deletion {
+		Type ObjectType;
+		unsigned int Name;
+	};
+
+	struct Batch {
+		GLsync Fence; // Null once signaled
+		std::vector<Deletion> Deletions;
+	};
+
+	std::mutex m_Mutex;
+	std::vector<Deletion> m_Queued; // This frame's, guarded by m_Mutex
+	std::deque<Batch> m_Batches; // Render thread only, oldest first
+	unsigned int m_MaxDeletionsPerFrame;
+	unsigned int m_Pending; // In m_Batches
+
+	static DeletionQueue* s_Instance;
+public:
+	DeletionQueue(unsigned int maxDeletionsPerFrame = 64);
+	~DeletionQueue();
+
+	static DeletionQueue& Get() { return *s_Instance; }
+	static bool Exists() { return s_Instance != nullptr; }
+
+	// Any thread, name 0 is ignored
+	void Delete(Type type, unsigned int name);
+	// Render thread, once per frame after its last draw
+	void EndFrame();
+	// Render thread, waits for the GPU and deletes everything queued
+	void Flush();
+
+	inline unsigned int GetPendingCount() const { return m_Pending; }
+
+	// Through the queue when there is one, else right away, which only the render thread may do then
+	static void DeleteBuffer(unsigned int buffer);
+	static void DeleteTexture(unsigned int texture);
+	static void DeleteProgram(unsigned int program);
+private:
+	static void DeleteNow(Type type, unsigned int name);
+	// Deletes from the front of the batch, returns how many
+	unsigned int DeleteBatch(Batch& batch, unsigned int budget);
+};
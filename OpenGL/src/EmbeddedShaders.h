@@ -0,0 +1,253 @@
+// Generated by tools/embed_shaders.py from res/shaders, do not edit.
+#pragma once
+
+struct EmbeddedShader {
+	const char* Filepath;
+	const char* Keywords; // Space separated, same order as the #keywords line
+	const char* VertexSource;
+	const char* FragmentSource;
+	const unsigned int* VertexSpirv; // nullptr unless built with --spirv
+	unsigned int VertexSpirvWords;
+	const unsigned int* FragmentSpirv;
+	unsigned int FragmentSpirvWords;
+};
+
+constexpr EmbeddedShader s_EmbeddedShaders[] = {
+	{
+		"res/shaders/Basic.shader",
+		"TEXTURED VERTEX_COLOR",
+		R"glsl(#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 vertexColor;
+
+// Stages compiled to SPIR-V separately are matched by location rather than by name
+#ifdef GL_SPIRV
+layout(location = 0) out vec2 v_TexCoord;
+layout(location = 1) out vec4 v_Color;
+#else
+out vec2 v_TexCoord;
+out vec4 v_Color;
+#endif
+
+// GL_SPIRV is defined when compiling to SPIR-V, which has no block names to bind at runtime
+#ifdef GL_SPIRV
+layout(std140, binding = 0) uniform Camera
+#else
+layout(std140) uniform Camera
+#endif
+{
+    mat4 u_ViewProjection;
+};
+
+#ifdef GL_SPIRV
+layout(std140, binding = 1) uniform Draw
+#else
+layout(std140) uniform Draw
+#endif
+{
+    mat4 u_Model;
+    vec4 u_Color;
+};
+
+void main()
+{
+    gl_Position = u_ViewProjection * u_Model * position;
+    v_TexCoord = texCoord;
+    v_Color = VERTEX_COLOR ? vertexColor : vec4(1.0);
+}
+
+)glsl",
+		R"glsl(#version 330 core
+
+layout(location = 0) out vec4 color;
+
+#ifdef GL_SPIRV
+layout(location = 0) in vec2 v_TexCoord;
+layout(location = 1) in vec4 v_Color;
+#else
+in vec2 v_TexCoord;
+in vec4 v_Color;
+#endif
+
+#ifdef GL_SPIRV
+layout(std140, binding = 1) uniform Draw
+#else
+layout(std140) uniform Draw
+#endif
+{
+    mat4 u_Model;
+    vec4 u_Color;
+};
+
+#ifdef GL_SPIRV
+layout(binding = 0) uniform sampler2D u_Texture;
+#else
+uniform sampler2D u_Texture;
+#endif
+
+void main()
+{
+    vec4 texColor = TEXTURED ? texture(u_Texture, v_TexCoord) : u_Color;
+    color = texColor * v_Color;
+}
+)glsl",
+		nullptr, 0, nullptr, 0
+	},
+	{
+		"res/shaders/Sprite.shader",
+		"",
+		R"glsl(#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in float layer;
+
+// Stages compiled to SPIR-V separately are matched by location rather than by name
+#ifdef GL_SPIRV
+layout(location = 0) out vec2 v_TexCoord;
+layout(location = 1) flat out float v_Layer;
+#else
+out vec2 v_TexCoord;
+flat out float v_Layer;
+#endif
+
+#ifdef GL_SPIRV
+layout(std140, binding = 0) uniform Camera
+#else
+layout(std140) uniform Camera
+#endif
+{
+    mat4 u_ViewProjection;
+};
+
+void main()
+{
+    gl_Position = u_ViewProjection * position;
+    v_TexCoord = texCoord;
+    v_Layer = layer;
+}
+
+)glsl",
+		R"glsl(#version 330 core
+
+layout(location = 0) out vec4 color;
+
+#ifdef GL_SPIRV
+layout(location = 0) in vec2 v_TexCoord;
+layout(location = 1) flat in float v_Layer;
+#else
+in vec2 v_TexCoord;
+flat in float v_Layer;
+#endif
+
+// Every sprite in a batch samples the same array, each picks its own layer
+#ifdef GL_SPIRV
+layout(binding = 0) uniform sampler2DArray u_Textures;
+#else
+uniform sampler2DArray u_Textures;
+#endif
+
+void main()
+{
+    color = texture(u_Textures, vec3(v_TexCoord, v_Layer));
+}
+)glsl",
+		nullptr, 0, nullptr, 0
+	},
+	{
+		"res/shaders/VirtualTexture.shader",
+		"",
+		R"glsl(#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 texCoord;
+
+// Stages compiled to SPIR-V separately are matched by location rather than by name
+#ifdef GL_SPIRV
+layout(location = 0) out vec2 v_TexCoord;
+#else
+out vec2 v_TexCoord;
+#endif
+
+#ifdef GL_SPIRV
+layout(std140, binding = 0) uniform Camera
+#else
+layout(std140) uniform Camera
+#endif
+{
+    mat4 u_ViewProjection;
+};
+
+void main()
+{
+    gl_Position = u_ViewProjection * position;
+    v_TexCoord = texCoord;
+}
+
+)glsl",
+		R"glsl(#version 330 core
+
+layout(location = 0) out vec4 color;
+
+#ifdef GL_SPIRV
+layout(location = 0) in vec2 v_TexCoord;
+#else
+in vec2 v_TexCoord;
+#endif
+
+// Bound by VirtualTexture::Bind
+#ifdef GL_SPIRV
+layout(std140, binding = 2) uniform VirtualTexture
+#else
+layout(std140) uniform VirtualTexture
+#endif
+{
+    vec4 u_ImageInfo;    // Level 0 width and height, tile size, border
+    vec4 u_PhysicalInfo; // Physical texture size, pages per side, level count
+};
+
+#ifdef GL_SPIRV
+layout(binding = 0) uniform sampler2D u_Physical;
+layout(binding = 1) uniform sampler2D u_Indirection;
+#else
+uniform sampler2D u_Physical;    // Tile pages, bilinear
+uniform sampler2D u_Indirection; // Page + 1 per tile in RG, one mip per pyramid level
+#endif
+
+void main()
+{
+    ivec2 imageSize = ivec2(u_ImageInfo.xy);
+    float tileSize = u_ImageInfo.z;
+    float border = u_ImageInfo.w;
+    int levelCount = int(u_PhysicalInfo.z);
+
+    // Same choice as VirtualTexture::GetLevel, the level with at least one texel per pixel
+    vec2 texel = v_TexCoord * vec2(imageSize);
+    float footprint = max(length(dFdx(texel)), length(dFdy(texel)));
+    int level = min(int(floor(log2(max(footprint, 1.0)))), levelCount - 1);
+
+    // Falls back to coarser levels until a resident tile covers this pixel, the top level always is
+    for (; level < levelCount; level++) {
+        ivec2 levelSize = max(imageSize >> level, ivec2(1));
+        vec2 levelTexel = v_TexCoord * vec2(levelSize);
+        ivec2 tiles = (levelSize + int(tileSize) - 1) / int(tileSize);
+        ivec2 tile = clamp(ivec2(levelTexel / tileSize), ivec2(0), tiles - 1);
+        vec2 entry = texelFetch(u_Indirection, tile, level).rg;
+        int page = int(entry.r * 255.0 + 0.5) + int(entry.g * 255.0 + 0.5) * 256 - 1;
+        if (page >= 0) {
+            int pagesPerSide = int(u_PhysicalInfo.y);
+            vec2 pageOrigin = vec2(page % pagesPerSide, page / pagesPerSide) * (tileSize + 2.0 * border);
+            vec2 inTile = clamp(levelTexel - vec2(tile) * tileSize, 0.0, tileSize);
+            // The physical texture has the one level, and implicit derivatives are undefined in this non-uniform loop
+            color = textureLod(u_Physical, (pageOrigin + border + inTile) / u_PhysicalInfo.x, 0.0);
+            return;
+        }
+    }
+    color = vec4(0.0, 0.0, 0.0, 1.0);
+}
+)glsl",
+		nullptr, 0, nullptr, 0
+	},
+};
@@ -0,0 +1,12 @@
+#include "GpuResources.h"
+
+GpuResources* GpuResources::s_Instance = nullptr;
+
+GpuResources::GpuResources() {
+    ASSERT(s_Instance == nullptr);
+    s_Instance = this;
+}
+
+GpuResources::~GpuResources() {
+    s_Instance = nullptr;
+}
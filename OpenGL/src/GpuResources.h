@@ -0,0 +1,39 @@
+#pragma once
+#include "ResourcePool.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Texture.h"
+#include "Shader.h"
+
+typedef ResourceHandle<VertexBuffer> VertexBufferHandle;
+typedef ResourceHandle<IndexBuffer> IndexBufferHandle;
+typedef ResourceHandle<VertexArray> VertexArrayHandle;
+typedef ResourceHandle<Texture> TextureHandle;
+typedef ResourceHandle<Shader> ShaderHandle;
+
+// One pool per GL resource type, for code that refers to resources by handle instead of owning them through
+// pointers. Whatever is still in a pool is deleted when this goes, so it's constructed after the texture
+// loader and residency tracker that textures report to. Shaders from ShaderLibrary stay shared there.
+class GpuResources {
+private:
+	ResourcePool<VertexBuffer> m_VertexBuffers;
+	ResourcePool<IndexBuffer> m_IndexBuffers;
+	ResourcePool<VertexArray> m_VertexArrays;
+	ResourcePool<Texture> m_Textures;
+	ResourcePool<Shader> m_Shaders;
+
+	static GpuResources* s_Instance;
+public:
+	GpuResources();
+	~GpuResources();
+
+	static GpuResources& Get() { return *s_Instance; }
+	static bool Exists() { return s_Instance != nullptr; }
+
+	inline ResourcePool<VertexBuffer>& GetVertexBuffers() { return m_VertexBuffers; }
+	inline ResourcePool<IndexBuffer>& GetIndexBuffers() { return m_IndexBuffers; }
+	inline ResourcePool<VertexArray>& GetVertexArrays() { return m_VertexArrays; }
+	inline ResourcePool<Texture>& GetTextures() { return m_Textures; }
+	inline ResourcePool<Shader>& GetShaders() { return m_Shaders; }
+};
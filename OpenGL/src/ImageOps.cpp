@@ -0,0 +1,333 @@
+#include "ImageOps.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "ThreadPool.h"
+
+// SSE2 is guaranteed on x64 and is MSVC's default for x86
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define IMAGE_OPS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ImageOps {
+    namespace {
+        const int LINEAR_TO_SRGB_STEPS = 4096;
+
+        struct SrgbTables {
+            float ToLinear[256];                          // sRGB byte to linear 0-1
+            unsigned char ToSrgb[LINEAR_TO_SRGB_STEPS + 1]; // Linear 0-1 in 4096 steps to sRGB byte
+            unsigned char ToLinear8[256];
+            unsigned char ToSrgb8[256];
+        };
+
+        float DecodeSrgb(float value) {
+            return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+
+        float EncodeSrgb(float value) {
+            return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+        }
+
+        // At 8 bits a table lookup beats evaluating the transfer curve, in SIMD or not
+        const SrgbTables& GetSrgbTables() {
+            static const SrgbTables tables = []() {
+                SrgbTables result;
+                for (int i = 0; i < 256; i++) {
+                    result.ToLinear[i] = DecodeSrgb(i / 255.0f);
+                    result.ToLinear8[i] = (unsigned char)(result.ToLinear[i] * 255.0f + 0.5f);
+                    result.ToSrgb8[i] = (unsigned char)(EncodeSrgb(i / 255.0f) * 255.0f + 0.5f);
+                }
+                for (int i = 0; i <= LINEAR_TO_SRGB_STEPS; i++) {
+                    result.ToSrgb[i] = (unsigned char)(EncodeSrgb((float)i / LINEAR_TO_SRGB_STEPS) * 255.0f + 0.5f);
+                }
+                return result;
+            }();
+            return tables;
+        }
+
+        void ForEachRows(int height, const std::function<void(int, int)>& job) {
+            ThreadPool::Get().ParallelFor((unsigned int)height, [&](unsigned int begin, unsigned int end) { job((int)begin, (int)end); });
+        }
+
+        void RemapColor(unsigned char* rgba, int width, int height, const unsigned char* table) {
+            ForEachRows(height, [&](int begin, int end) {
+                unsigned char* pixel = rgba + (size_t)begin * width * 4;
+                unsigned char* last = rgba + (size_t)end * width * 4;
+                for (; pixel < last; pixel += 4) {
+                    pixel[0] = table[pixel[0]];
+                    pixel[1] = table[pixel[1]];
+                    pixel[2] = table[pixel[2]];
+                }
+            });
+        }
+
+        // A separable filter for a 2:1 reduction, destination texel i reads source texels 2i + First .. 2i + First + TapCount - 1
+        struct Filter {
+            int First;
+            int TapCount;
+            float Weights[8];
+        };
+
+        double BesselI0(double x) {
+            double sum = 1.0, term = 1.0;
+            for (int k = 1; k < 32; k++) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+            return sum;
+        }
+
+        const Filter& GetFilter(MipFilter filter) {
+            static const Filter box = { 0, 2, { 0.5f, 0.5f } };
+            static const Filter kaiser = []() {
+                // Sinc at the destination rate windowed over +-2 destination texels, alpha 4 as is usual for mips
+                const double pi = 3.14159265358979323846, alpha = 4.0, halfWidth = 2.0;
+                Filter result = { -3, 8, {} };
+                double total = 0.0;
+                double weights[8];
+                for (int k = 0; k < 8; k++) {
+                    // Tap centers sit at -3.5 .. 3.5 source texels from the destination center, halved into destination units
+                    double x = (k - 3.5) / 2.0;
+                    double sinc = std::sin(pi * x) / (pi * x);
+                    double window = BesselI0(alpha * std::sqrt(1.0 - (x / halfWidth) * (x / halfWidth))) / BesselI0(alpha);
+                    weights[k] = sinc * window;
+                    total += weights[k];
+                }
+                for (int k = 0; k < 8; k++) {
+                    result.Weights[k] = (float)(weights[k] / total);
+                }
+                return result;
+            }();
+            return filter == MipFilter::Box ? box : kaiser;
+        }
+
+        // One RGBA texel as 4 floats. Plain floats rather than __m128, std::vector only guarantees 8 byte
+        // alignment on 32-bit builds, so the SSE paths load and store them unaligned
+        struct Texel {
+            float Value[4];
+        };
+
+        void DecodeRow(const unsigned char* row, int width, bool srgb, Texel* out) {
+            const SrgbTables& tables = GetSrgbTables();
+            for (int x = 0; x < width; x++) {
+                const unsigned char* pixel = row + x * 4;
+                float r = srgb ? tables.ToLinear[pixel[0]] : pixel[0] / 255.0f;
+                float g = srgb ? tables.ToLinear[pixel[1]] : pixel[1] / 255.0f;
+                float b = srgb ? tables.ToLinear[pixel[2]] : pixel[2] / 255.0f;
+                float a = pixel[3] / 255.0f;
+                out[x] = { { r, g, b, a } };
+            }
+        }
+
+        // out[i] = sum of weights[k] * row[clamp(2i + first + k)]
+        void FilterRow(const Texel* row, int width, const Filter& filter, Texel* out, int outWidth) {
+            for (int i = 0; i < outWidth; i++) {
+                int first = i * 2 + filter.First;
+#ifdef IMAGE_OPS_SSE2
+                __m128 sum = _mm_setzero_ps();
+                for (int k = 0; k < filter.TapCount; k++) {
+                    int x = std::min(std::max(first + k, 0), width - 1);
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(row[x].Value), _mm_set1_ps(filter.Weights[k])));
+                }
+                _mm_storeu_ps(out[i].Value, sum);
+#else
+                float sum[4] = { 0, 0, 0, 0 };
+                for (int k = 0; k < filter.TapCount; k++) {
+                    int x = std::min(std::max(first + k, 0), width - 1);
+                    for (int c = 0; c < 4; c++) {
+                        sum[c] += row[x].Value[c] * filter.Weights[k];
+                    }
+                }
+                memcpy(out[i].Value, sum, sizeof(sum));
+#endif
+            }
+        }
+
+        void EncodeTexel(const float* value, bool srgb, unsigned char* out) {
+            const SrgbTables& tables = GetSrgbTables();
+            for (int c = 0; c < 4; c++) {
+                float clamped = std::min(1.0f, std::max(0.0f, value[c]));
+                if (srgb && c < 3) {
+                    out[c] = tables.ToSrgb[(int)(clamped * LINEAR_TO_SRGB_STEPS + 0.5f)];
+                }
+                else {
+                    out[c] = (unsigned char)(clamped * 255.0f + 0.5f);
+                }
+            }
+        }
+    }
+
+    void FlipVertical(unsigned char* rgba, int width, int height) {
+        size_t rowBytes = (size_t)width * 4;
+        ForEachRows(height / 2, [&](int begin, int end) {
+            for (int y = begin; y < end; y++) {
+                unsigned char* top = rgba + (size_t)y * rowBytes;
+                unsigned char* bottom = rgba + (size_t)(height - 1 - y) * rowBytes;
+                size_t i = 0;
+#ifdef IMAGE_OPS_SSE2
+                for (; i + 16 <= rowBytes; i += 16) {
+                    __m128i a = _mm_loadu_si128((const __m128i*)(top + i));
+                    __m128i b = _mm_loadu_si128((const __m128i*)(bottom + i));
+                    _mm_storeu_si128((__m128i*)(top + i), b);
+                    _mm_storeu_si128((__m128i*)(bottom + i), a);
+                }
+#endif
+                for (; i < rowBytes; i++) {
+                    std::swap(top[i], bottom[i]);
+                }
+            }
+        });
+    }
+
+    void PremultiplyAlpha(unsigned char* rgba, int width, int height) {
+        ForEachRows(height, [&](int begin, int end) {
+            unsigned char* pixel = rgba + (size_t)begin * width * 4;
+            unsigned char* last = rgba + (size_t)end * width * 4;
+#ifdef IMAGE_OPS_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i half = _mm_set1_epi16(128);
+            // Alpha is every 4th 16 bit lane once widened, those keep their original value
+            const __m128i alphaLanes = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+            for (; pixel + 16 <= last; pixel += 16) {
+                __m128i texels = _mm_loadu_si128((const __m128i*)pixel);
+                __m128i halves[2] = { _mm_unpacklo_epi8(texels, zero), _mm_unpackhi_epi8(texels, zero) };
+                for (__m128i& wide : halves) {
+                    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(wide, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                    // x / 255 rounded is (t + (t >> 8)) >> 8 with t = x + 128, exact for every 8 bit product
+                    __m128i t = _mm_add_epi16(_mm_mullo_epi16(wide, alpha), half);
+                    __m128i scaled = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+                    wide = _mm_or_si128(_mm_andnot_si128(alphaLanes, scaled), _mm_and_si128(alphaLanes, wide));
+                }
+                _mm_storeu_si128((__m128i*)pixel, _mm_packus_epi16(halves[0], halves[1]));
+            }
+#endif
+            for (; pixel < last; pixel += 4) {
+                unsigned int alpha = pixel[3];
+                for (int c = 0; c < 3; c++) {
+                    unsigned int t = pixel[c] * alpha + 128;
+                    pixel[c] = (unsigned char)((t + (t >> 8)) >> 8);
+                }
+            }
+        });
+    }
+
+    void SrgbToLinear(unsigned char* rgba, int width, int height) {
+        RemapColor(rgba, width, height, GetSrgbTables().ToLinear8);
+    }
+
+    void LinearToSrgb(unsigned char* rgba, int width, int height) {
+        RemapColor(rgba, width, height, GetSrgbTables().ToSrgb8);
+    }
+
+    void Swizzle(unsigned char* rgba, int width, int height, unsigned int r, unsigned int g, unsigned int b, unsigned int a) {
+        const unsigned int order[4] = { r, g, b, a };
+        ForEachRows(height, [&](int begin, int end) {
+            unsigned char* pixel = rgba + (size_t)begin * width * 4;
+            unsigned char* last = rgba + (size_t)end * width * 4;
+#ifdef IMAGE_OPS_SSE2
+            // SSE2 has no byte shuffle, but with one texel per 32 bit lane each output channel is a shift and a mask
+            const __m128i byteMask = _mm_set1_epi32(0xFF);
+            __m128i shifts[4];
+            for (int c = 0; c < 4; c++) {
+                shifts[c] = _mm_cvtsi32_si128(order[c] * 8);
+            }
+            for (; pixel + 16 <= last; pixel += 16) {
+                __m128i texels = _mm_loadu_si128((const __m128i*)pixel);
+                __m128i result = _mm_setzero_si128();
+                for (int c = 0; c < 4; c++) {
+                    __m128i channel = _mm_and_si128(_mm_srl_epi32(texels, shifts[c]), byteMask);
+                    result = _mm_or_si128(result, _mm_slli_epi32(channel, c * 8));
+                }
+                _mm_storeu_si128((__m128i*)pixel, result);
+            }
+#endif
+            for (; pixel < last; pixel += 4) {
+                unsigned char source[4];
+                memcpy(source, pixel, 4);
+                for (int c = 0; c < 4; c++) {
+                    pixel[c] = source[order[c]];
+                }
+            }
+        });
+    }
+
+    void Downsample(const unsigned char* source, int width, int height, unsigned char* destination, MipFilter filter, bool srgb) {
+        const Filter& taps = GetFilter(filter);
+        int outWidth = std::max(1, width / 2), outHeight = std::max(1, height / 2);
+
+        ForEachRows(outHeight, [&](int begin, int end) {
+            // Horizontally filtered source rows, kept in a window since neighbouring output rows overlap on most of theirs
+            std::vector<Texel> decoded(width);
+            std::vector<Texel> window((size_t)taps.TapCount * outWidth);
+            std::vector<int> windowRow(taps.TapCount, -1);
+            std::vector<const Texel*> rows(taps.TapCount);
+
+            for (int y = begin; y < end; y++) {
+                int first = y * 2 + taps.First;
+                for (int k = 0; k < taps.TapCount; k++) {
+                    int sourceRow = std::min(std::max(first + k, 0), height - 1);
+                    // Rows land in the slot for their index, so a row stays put as the window slides over it
+                    int slot = ((sourceRow % taps.TapCount) + taps.TapCount) % taps.TapCount;
+                    Texel* filtered = &window[(size_t)slot * outWidth];
+                    if (windowRow[slot] != sourceRow) {
+                        DecodeRow(source + (size_t)sourceRow * width * 4, width, srgb, decoded.data());
+                        FilterRow(decoded.data(), width, taps, filtered, outWidth);
+                        windowRow[slot] = sourceRow;
+                    }
+                    rows[k] = filtered;
+                }
+
+                unsigned char* out = destination + (size_t)y * outWidth * 4;
+                for (int x = 0; x < outWidth; x++) {
+                    alignas(16) float value[4];
+#ifdef IMAGE_OPS_SSE2
+                    __m128 sum = _mm_setzero_ps();
+                    for (int k = 0; k < taps.TapCount; k++) {
+                        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[k][x].Value), _mm_set1_ps(taps.Weights[k])));
+                    }
+                    _mm_store_ps(value, sum);
+#else
+                    memset(value, 0, sizeof(value));
+                    for (int k = 0; k < taps.TapCount; k++) {
+                        for (int c = 0; c < 4; c++) {
+                            value[c] += rows[k][x].Value[c] * taps.Weights[k];
+                        }
+                    }
+#endif
+                    EncodeTexel(value, srgb, out + x * 4);
+                }
+            }
+        });
+    }
+
+    int GetMipCount(int width, int height) {
+        int count = 1;
+        while (width > 1 || height > 1) {
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+            count++;
+        }
+        return count;
+    }
+
+    std::vector<std::vector<unsigned char>> GenerateMips(const unsigned char* rgba, int width, int height, MipFilter filter, bool srgb, int mipCount) {
+        int levelCount = GetMipCount(width, height);
+        if (mipCount > 0) {
+            levelCount = std::min(levelCount, mipCount);
+        }
+        std::vector<std::vector<unsigned char>> levels;
+        levels.reserve(levelCount - 1);
+        const unsigned char* previous = rgba;
+        while ((int)levels.size() + 1 < levelCount) {
+            int outWidth = std::max(1, width / 2), outHeight = std::max(1, height / 2);
+            levels.emplace_back((size_t)outWidth * outHeight * 4);
+            Downsample(previous, width, height, levels.back().data(), filter, srgb);
+            previous = levels.back().data();
+            width = outWidth;
+            height = outHeight;
+        }
+        return levels;
+    }
+}
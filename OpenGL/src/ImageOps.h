@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+
+// Whole-image kernels over tightly packed RGBA8 pixels. Rows are split across ThreadPool::Get()
+// and each kernel uses SSE2 where the target has it, with a scalar fallback that gives the same result.
+namespace ImageOps {
+	enum class MipFilter {
+		Box,   // 2x2 average, cheapest, slightly blurry and prone to aliasing on fine detail
+		Kaiser // 8 tap Kaiser windowed sinc, keeps mips sharp without ringing much
+	};
+
+	void FlipVertical(unsigned char* rgba, int width, int height);
+	// Color channels scaled by alpha, rounded to nearest
+	void PremultiplyAlpha(unsigned char* rgba, int width, int height);
+	// Converts the color channels between sRGB and linear encoding, alpha is left alone.
+	// Storing linear data in 8 bits bands in the darks, prefer filtering through Downsample's srgb flag
+	void SrgbToLinear(unsigned char* rgba, int width, int height);
+	void LinearToSrgb(unsigned char* rgba, int width, int height);
+	// Output channel c takes input channel r, g, b or a (0-3), e.g. 2, 1, 0, 3 turns BGRA into RGBA
+	void Swizzle(unsigned char* rgba, int width, int height, unsigned int r, unsigned int g, unsigned int b, unsigned int a);
+
+	// Halves each dimension (never below 1) into destination. With srgb set the color channels are
+	// decoded to linear before filtering and encoded again after, which keeps mips from darkening.
+	void Downsample(const unsigned char* source, int width, int height, unsigned char* destination, MipFilter filter, bool srgb);
+	// Levels in a full chain down to 1x1, including the base level
+	int GetMipCount(int width, int height);
+	// Levels 1 and up, each built from the one before it. mipCount caps the chain, counting the base level
+	// like GetMipCount, 0 goes all the way down to 1x1
+	std::vector<std::vector<unsigned char>> GenerateMips(const unsigned char* rgba, int width, int height, MipFilter filter, bool srgb,
+														 int mipCount = 0);
+}
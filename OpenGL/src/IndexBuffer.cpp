@@ -2,22 +2,114 @@
 
 #include "Renderer.h"
 
-IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) : m_Count(count) {
+template<typename T>
+static void NarrowIndices(const unsigned int* data, unsigned int count, T* narrowed) {
+    for (unsigned int i = 0; i < count; i++) {
+        // RESTART truncates to the type's largest value, which is exactly its restart index
+        narrowed[i] = (T)data[i];
+    }
+}
+
+static unsigned int PickType(const unsigned int* data, unsigned int count, unsigned int type) {
+    if (type != IndexBuffer::AUTO_TYPE) {
+        return type;
+    }
+    return data ? IndexBuffer::GetNarrowestType(data, count) : GL_UNSIGNED_INT;
+}
+
+IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count, BufferUsage usage, unsigned int type)
+    : m_Count(count), m_Type(PickType(data, count, type)), m_AutoType(type == AUTO_TYPE), m_PrimitiveRestart(false),
+      m_Buffer(GL_ELEMENT_ARRAY_BUFFER, data ? Narrow(data, count) : nullptr, count * GetIndexSize(m_Type), usage) {
     ASSERT(sizeof(unsigned int) == sizeof(GLuint));
+}
 
-    GLCall(glGenBuffers(1, &m_RendererID));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
-    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
+IndexBuffer::IndexBuffer(unsigned int count, BufferUsage usage, unsigned int type) : IndexBuffer(nullptr, count, usage, type) {
 }
 
 IndexBuffer::~IndexBuffer() {
-    GLCall(glDeleteBuffers(1, &m_RendererID));
 }
 
-void IndexBuffer::Bind() const  {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+void IndexBuffer::SetData(const unsigned int* data, unsigned int count, unsigned int first) {
+    m_Buffer.SetData(Narrow(data, count), count * GetIndexSize(), first * GetIndexSize());
+}
+
+void IndexBuffer::Flush() {
+    m_Buffer.Flush();
+}
+
+void IndexBuffer::Reallocate(const unsigned int* data, unsigned int count) {
+    m_PrimitiveRestart = false;
+    if (m_AutoType) {
+        m_Type = PickType(data, count, AUTO_TYPE);
+    }
+    m_Buffer.Reallocate(data ? Narrow(data, count) : nullptr, count * GetIndexSize());
+    m_Count = count;
+}
+
+void* IndexBuffer::Map(unsigned int first, unsigned int count, bool unsynchronized) {
+    return m_Buffer.Map(first * GetIndexSize(), count * GetIndexSize(), unsynchronized);
+}
+
+void IndexBuffer::Unmap() {
+    m_Buffer.Unmap();
+}
+
+void IndexBuffer::Bind() const {
+    m_Buffer.Bind();
 }
 
 void IndexBuffer::Unbind() const {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
-}
\ No newline at end of file
+    m_Buffer.Unbind();
+}
+
+void IndexBuffer::SetCount(unsigned int count) {
+    ASSERT(count <= GetCapacity());
+    m_Count = count;
+}
+
+unsigned int IndexBuffer::GetIndexSize(unsigned int type) {
+    switch (type) {
+        case GL_UNSIGNED_BYTE: return 1;
+        case GL_UNSIGNED_SHORT: return 2;
+        case GL_UNSIGNED_INT: return 4;
+    }
+    ASSERT(false);
+    return 0;
+}
+
+unsigned int IndexBuffer::GetMaxIndex(unsigned int type) {
+    return type == GL_UNSIGNED_BYTE ? 0xff : type == GL_UNSIGNED_SHORT ? 0xffff : 0xffffffff;
+}
+
+unsigned int IndexBuffer::GetNarrowestType(const unsigned int* data, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+        if (data[i] >= 0xffff && data[i] != RESTART) {
+            return GL_UNSIGNED_INT;
+        }
+    }
+    return GL_UNSIGNED_SHORT;
+}
+
+const void* IndexBuffer::Narrow(const unsigned int* data, unsigned int count) {
+    unsigned int maxIndex = GetMaxIndex(m_Type);
+    for (unsigned int i = 0; i < count; i++) {
+        if (data[i] == RESTART) {
+            m_PrimitiveRestart = true;
+        }
+        else {
+            ASSERT(data[i] < maxIndex);
+        }
+    }
+    if (m_Type == GL_UNSIGNED_INT) {
+        return data;
+    }
+
+    m_Narrowed.resize(count * GetIndexSize());
+    if (m_Type == GL_UNSIGNED_SHORT) {
+        NarrowIndices(data, count, (unsigned short*)m_Narrowed.data());
+    }
+    else {
+        NarrowIndices(data, count, m_Narrowed.data());
+    }
+    return m_Narrowed.data();
+}
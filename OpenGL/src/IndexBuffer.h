@@ -1,15 +1,65 @@
 #pragma once
+#include <vector>
+#include "BufferObject.h"
 
+// Counts and offsets in indices. Writes queued with SetData reach the GPU on Flush, see BufferObject.
+// Indices are always passed in as unsigned int and stored in the buffer's index type, which by default is
+// the narrowest of GL_UNSIGNED_SHORT and GL_UNSIGNED_INT that holds the data it's created or reallocated
+// with, halving index memory and fetch bandwidth for anything under 65535 vertices. GL_UNSIGNED_BYTE is
+// only used when asked for explicitly, since most desktop hardware has no native 8-bit index fetch and the
+// driver widens it behind our back.
+// RESTART in the data ends the current strip or fan; it's stored as the type's largest value, which is
+// therefore never a vertex index, and Renderer::Draw turns primitive restart on for buffers holding one.
 class IndexBuffer {
+public:
+	static const unsigned int RESTART = 0xffffffff;
+	static const unsigned int AUTO_TYPE = 0;
 private:
-	unsigned int m_RendererID;
-	unsigned int m_Count; // Indices count
+	unsigned int m_Count; // Indices drawn
+	unsigned int m_Type;
+	bool m_AutoType;
+	bool m_PrimitiveRestart;
+	std::vector<unsigned char> m_Narrowed; // Scratch for data converted to m_Type
+	BufferObject m_Buffer; // Last, its initial data goes through Narrow
 public:
-	IndexBuffer(const unsigned int* data, unsigned int count);
+	IndexBuffer(const unsigned int* data, unsigned int count, BufferUsage usage = BufferUsage::Static, unsigned int type = AUTO_TYPE);
+	// Room for count indices to be filled later with SetData or Map. With AUTO_TYPE they're 32-bit until
+	// reallocated with data
+	IndexBuffer(unsigned int count, BufferUsage usage, unsigned int type = AUTO_TYPE);
+	IndexBuffer(IndexBuffer&&) = default;
+	IndexBuffer& operator=(IndexBuffer&&) = default;
 	~IndexBuffer();
 
-	void Bind() const ;
-	void Unbind() const ;
+	// Every index has to fit the buffer's type
+	void SetData(const unsigned int* data, unsigned int count, unsigned int first = 0);
+	void Flush();
+	// New storage for count indices, all of them drawn. Picks the type again unless it was given explicitly
+	void Reallocate(const unsigned int* data, unsigned int count);
+	// Indices of GetType, written as is, so a restart is GetRestartIndex
+	void* Map(unsigned int first, unsigned int count, bool unsynchronized = false);
+	void Unmap();
+
+	void Bind() const;
+	void Unbind() const;
 
+	// Draws only the first count indices, for geometry that shrinks and grows within the same storage
+	void SetCount(unsigned int count);
+	// Set by data containing RESTART, only needed by hand for data written through Map
+	inline void SetPrimitiveRestart(bool enabled) { m_PrimitiveRestart = enabled; }
 	inline unsigned int GetCount() const { return m_Count; }
-};
\ No newline at end of file
+	inline unsigned int GetCapacity() const { return m_Buffer.GetSize() / GetIndexSize(); }
+	inline unsigned int GetRendererID() const { return m_Buffer.GetRendererID(); }
+	inline unsigned int GetType() const { return m_Type; }
+	inline unsigned int GetIndexSize() const { return GetIndexSize(m_Type); }
+	inline bool IsPrimitiveRestart() const { return m_PrimitiveRestart; }
+	inline unsigned int GetRestartIndex() const { return GetMaxIndex(m_Type); }
+
+	static unsigned int GetIndexSize(unsigned int type);
+	// Largest value the type can hold, which is its restart index, so vertices go up to one less
+	static unsigned int GetMaxIndex(unsigned int type);
+	// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, whichever holds every index in data besides RESTART
+	static unsigned int GetNarrowestType(const unsigned int* data, unsigned int count);
+private:
+	// Converts to m_Type in m_Narrowed, or returns data itself for 32-bit buffers
+	const void* Narrow(const unsigned int* data, unsigned int count);
+};
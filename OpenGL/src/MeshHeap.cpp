@@ -0,0 +1,207 @@
+#include "MeshHeap.h"
+
+#include <algorithm>
+#include "Renderer.h"
+
+static void CopyBuffer(unsigned int source, unsigned int destination, unsigned int sourceOffset, unsigned int destinationOffset, unsigned int size) {
+    GLCall(glBindBuffer(GL_COPY_READ_BUFFER, source));
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, destination));
+    GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, destinationOffset, size));
+    GLCall(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+}
+
+// The allocator's size bins are 1/8 of a power of two apart, so when all the free space is one range the
+// largest request it reports is at least 8/9 of it. Below that the free space is split into holes
+static bool IsFragmented(const OffsetAllocator& allocator) {
+    return (unsigned long long)allocator.GetLargestFreeSize() * 9 < (unsigned long long)allocator.GetFreeSize() * 8;
+}
+
+// Room for at least count more after growing, whatever the allocator's rounding
+static unsigned int GetGrownCapacity(unsigned int capacity, unsigned int count) {
+    return std::max(capacity * 2, capacity + count * 2);
+}
+
+MeshHeap::MeshHeap(const VertexBufferLayout& layout, unsigned int vertexCapacity, unsigned int indexCapacity, unsigned int indexType)
+    : m_Layout(layout), m_VertexAllocator(vertexCapacity), m_IndexAllocator(indexCapacity), m_MovedBytes(0) {
+    m_VAO = std::make_unique<VertexArray>();
+    m_VertexBuffer = std::make_unique<VertexBuffer>(vertexCapacity * m_Layout.GetStride(), BufferUsage::Dynamic);
+    m_VAO->AddBuffer(*m_VertexBuffer, m_Layout);
+    // Created while the VAO is bound so it becomes the VAO's element buffer
+    m_IndexBuffer = std::make_unique<IndexBuffer>(indexCapacity, BufferUsage::Dynamic, indexType);
+    m_VAO->Unbind();
+}
+
+MeshHeap::~MeshHeap() {
+}
+
+int MeshHeap::Add(const void* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount) {
+    ASSERT(vertexCount > 0 && indexCount > 0 && vertexCount - 1 < IndexBuffer::GetMaxIndex(m_IndexBuffer->GetType()));
+    Mesh mesh;
+    mesh.Vertices = m_VertexAllocator.Allocate(vertexCount);
+    if (mesh.Vertices.Offset == OffsetAllocator::NO_SPACE) {
+        GrowVertices(GetGrownCapacity(m_VertexAllocator.GetSize(), vertexCount));
+        mesh.Vertices = m_VertexAllocator.Allocate(vertexCount);
+        ASSERT(mesh.Vertices.Offset != OffsetAllocator::NO_SPACE);
+    }
+    mesh.Indices = m_IndexAllocator.Allocate(indexCount);
+    if (mesh.Indices.Offset == OffsetAllocator::NO_SPACE) {
+        GrowIndices(GetGrownCapacity(m_IndexAllocator.GetSize(), indexCount));
+        mesh.Indices = m_IndexAllocator.Allocate(indexCount);
+        ASSERT(mesh.Indices.Offset != OffsetAllocator::NO_SPACE);
+    }
+    mesh.VertexCount = vertexCount;
+    mesh.IndexCount = indexCount;
+    mesh.Live = true;
+
+    unsigned int stride = m_Layout.GetStride();
+    m_VertexBuffer->SetData(vertices, vertexCount * stride, mesh.Vertices.Offset * stride);
+    m_IndexBuffer->SetData(indices, indexCount, mesh.Indices.Offset);
+
+    int id;
+    if (!m_FreeMeshes.empty()) {
+        id = m_FreeMeshes.back();
+        m_FreeMeshes.pop_back();
+        m_Meshes[id] = mesh;
+    }
+    else {
+        id = (int)m_Meshes.size();
+        m_Meshes.push_back(mesh);
+    }
+    return id;
+}
+
+void MeshHeap::Remove(int mesh) {
+    Mesh& removed = m_Meshes[mesh];
+    ASSERT(removed.Live);
+    // Queued writes into the old ranges still land before anything written there later, the buffer
+    // applies them in order
+    m_VertexAllocator.Free(removed.Vertices);
+    m_IndexAllocator.Free(removed.Indices);
+    removed.Live = false;
+    m_FreeMeshes.push_back(mesh);
+}
+
+void MeshHeap::SetVertices(int mesh, const void* vertices) {
+    const Mesh& target = m_Meshes[mesh];
+    ASSERT(target.Live);
+    unsigned int stride = m_Layout.GetStride();
+    m_VertexBuffer->SetData(vertices, target.VertexCount * stride, target.Vertices.Offset * stride);
+}
+
+void MeshHeap::Draw(int mesh, const Shader& shader) {
+    const Mesh& target = m_Meshes[mesh];
+    ASSERT(target.Live);
+    Flush();
+    shader.Bind();
+    m_VAO->Bind();
+    GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, target.IndexCount, m_IndexBuffer->GetType(),
+                                    (void*)((size_t)target.Indices.Offset * m_IndexBuffer->GetIndexSize()), target.Vertices.Offset));
+}
+
+void MeshHeap::Draw(const std::vector<int>& meshes, const Shader& shader) {
+    if (meshes.empty()) {
+        return;
+    }
+    m_DrawCounts.clear();
+    m_DrawOffsets.clear();
+    m_DrawBaseVertices.clear();
+    for (int mesh : meshes) {
+        const Mesh& target = m_Meshes[mesh];
+        ASSERT(target.Live);
+        m_DrawCounts.push_back(target.IndexCount);
+        m_DrawOffsets.push_back((void*)((size_t)target.Indices.Offset * m_IndexBuffer->GetIndexSize()));
+        m_DrawBaseVertices.push_back(target.Vertices.Offset);
+    }
+
+    Flush();
+    shader.Bind();
+    m_VAO->Bind();
+    GLCall(glMultiDrawElementsBaseVertex(GL_TRIANGLES, m_DrawCounts.data(), m_IndexBuffer->GetType(), m_DrawOffsets.data(),
+                                         (GLsizei)m_DrawCounts.size(), m_DrawBaseVertices.data()));
+}
+
+unsigned int MeshHeap::Defragment(unsigned int maxBytes) {
+    unsigned int moved = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        bool indices = pass == 1;
+        if (!IsFragmented(indices ? m_IndexAllocator : m_VertexAllocator)) {
+            continue;
+        }
+        // Anything still queued has to reach the GPU before it's copied
+        Flush();
+
+        // Highest ranges first, they're the ones standing between the holes and the free tail
+        std::vector<int> order;
+        for (int i = 0; i < (int)m_Meshes.size(); i++) {
+            if (m_Meshes[i].Live) {
+                order.push_back(i);
+            }
+        }
+        std::sort(order.begin(), order.end(), [this, indices](int a, int b) {
+            return indices ? m_Meshes[a].Indices.Offset > m_Meshes[b].Indices.Offset : m_Meshes[a].Vertices.Offset > m_Meshes[b].Vertices.Offset;
+        });
+        for (int mesh : order) {
+            if (moved >= maxBytes) {
+                break;
+            }
+            moved += Move(m_Meshes[mesh], indices);
+        }
+    }
+    m_MovedBytes += moved;
+    return moved;
+}
+
+MeshHeap::MeshRange MeshHeap::GetRange(int mesh) const {
+    const Mesh& target = m_Meshes[mesh];
+    return { target.Vertices.Offset, target.VertexCount, target.Indices.Offset, target.IndexCount };
+}
+
+void MeshHeap::Flush() {
+    m_VertexBuffer->Flush();
+    m_IndexBuffer->Flush();
+}
+
+void MeshHeap::GrowVertices(unsigned int vertexCapacity) {
+    unsigned int stride = m_Layout.GetStride();
+    m_VertexBuffer->Flush();
+    std::unique_ptr<VertexBuffer> buffer = std::make_unique<VertexBuffer>(vertexCapacity * stride, BufferUsage::Dynamic);
+    CopyBuffer(m_VertexBuffer->GetRendererID(), buffer->GetRendererID(), 0, 0, m_VertexAllocator.GetSize() * stride);
+    m_VertexBuffer = std::move(buffer);
+    m_VAO->AddBuffer(*m_VertexBuffer, m_Layout);
+    m_VAO->Unbind();
+    m_VertexAllocator.Grow(vertexCapacity);
+}
+
+void MeshHeap::GrowIndices(unsigned int indexCapacity) {
+    m_IndexBuffer->Flush();
+    m_VAO->Bind();
+    std::unique_ptr<IndexBuffer> buffer = std::make_unique<IndexBuffer>(indexCapacity, BufferUsage::Dynamic, m_IndexBuffer->GetType());
+    m_VAO->Unbind();
+    CopyBuffer(m_IndexBuffer->GetRendererID(), buffer->GetRendererID(), 0, 0, m_IndexAllocator.GetSize() * m_IndexBuffer->GetIndexSize());
+    m_IndexBuffer = std::move(buffer);
+    m_IndexAllocator.Grow(indexCapacity);
+}
+
+unsigned int MeshHeap::Move(Mesh& mesh, bool indices) {
+    OffsetAllocator& allocator = indices ? m_IndexAllocator : m_VertexAllocator;
+    OffsetAllocator::Allocation& current = indices ? mesh.Indices : mesh.Vertices;
+    unsigned int count = indices ? mesh.IndexCount : mesh.VertexCount;
+
+    OffsetAllocator::Allocation target = allocator.Allocate(count);
+    if (target.Offset == OffsetAllocator::NO_SPACE) {
+        return 0;
+    }
+    if (target.Offset > current.Offset) {
+        allocator.Free(target);
+        return 0;
+    }
+
+    // Both ranges are allocated so they can't overlap, which is all a copy within one buffer needs
+    unsigned int unit = indices ? m_IndexBuffer->GetIndexSize() : m_Layout.GetStride();
+    unsigned int buffer = indices ? m_IndexBuffer->GetRendererID() : m_VertexBuffer->GetRendererID();
+    CopyBuffer(buffer, buffer, current.Offset * unit, target.Offset * unit, count * unit);
+    allocator.Free(current);
+    current = target;
+    return count * unit;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "VertexArray.h"
+#include "VertexBufferLayout.h"
+#include "IndexBuffer.h"
+#include "OffsetAllocator.h"
+
+// Many small meshes sharing one vertex layout, sub-allocated out of a single vertex buffer and a single
+// index buffer behind one VAO, so drawing any number of them needs no buffer or VAO switch and a list
+// of them goes out in one glMultiDrawElementsBaseVertex. Indices are relative to the mesh's own first
+// vertex, the draw adds its base vertex, so 16-bit indices do for any mesh under 65535 vertices however
+// big the heap gets.
+// The buffers double when full, copying the old contents on the GPU. Removing meshes leaves holes, which
+// Defragment closes a few meshes at a time by moving the last ones down with glCopyBufferSubData.
+// Mesh ids stay valid until Remove and are reused after it.
+class MeshHeap {
+public:
+	struct MeshRange {
+		unsigned int BaseVertex;
+		unsigned int VertexCount;
+		unsigned int FirstIndex;
+		unsigned int IndexCount;
+	};
+private:
+	struct Mesh {
+		OffsetAllocator::Allocation Vertices; // In vertices
+		OffsetAllocator::Allocation Indices; // In indices
+		unsigned int VertexCount;
+		unsigned int IndexCount;
+		bool Live;
+	};
+
+	VertexBufferLayout m_Layout;
+	std::unique_ptr<VertexArray> m_VAO;
+	std::unique_ptr<VertexBuffer> m_VertexBuffer;
+	std::unique_ptr<IndexBuffer> m_IndexBuffer;
+	OffsetAllocator m_VertexAllocator;
+	OffsetAllocator m_IndexAllocator;
+	std::vector<Mesh> m_Meshes;
+	std::vector<int> m_FreeMeshes;
+	unsigned int m_MovedBytes; // By Defragment since the last call to ResetStats
+
+	// Multi-draw arguments, kept to avoid reallocating them every frame
+	std::vector<int> m_DrawCounts;
+	std::vector<void*> m_DrawOffsets;
+	std::vector<int> m_DrawBaseVertices;
+public:
+	MeshHeap(const VertexBufferLayout& layout, unsigned int vertexCapacity, unsigned int indexCapacity, unsigned int indexType = GL_UNSIGNED_SHORT);
+	~MeshHeap();
+
+	// Queues the upload and returns the mesh id
+	int Add(const void* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount);
+	void Remove(int mesh);
+	// Rewrites all of a mesh's vertices
+	void SetVertices(int mesh, const void* vertices);
+
+	// Both flush queued uploads first. Triangles, with shader's uniforms already set
+	void Draw(int mesh, const Shader& shader);
+	void Draw(const std::vector<int>& meshes, const Shader& shader);
+
+	// Moves meshes from the end of either buffer into holes closer to the start until about maxBytes
+	// have been copied, nothing when the free space is already in one piece. Returns the bytes moved
+	unsigned int Defragment(unsigned int maxBytes);
+
+	MeshRange GetRange(int mesh) const;
+	inline unsigned int GetMeshCount() const { return (unsigned int)(m_Meshes.size() - m_FreeMeshes.size()); }
+	inline const OffsetAllocator& GetVertexAllocator() const { return m_VertexAllocator; }
+	inline const OffsetAllocator& GetIndexAllocator() const { return m_IndexAllocator; }
+	inline unsigned int GetMovedBytes() const { return m_MovedBytes; }
+	inline void ResetStats() { m_MovedBytes = 0; }
+private:
+	void Flush();
+	void GrowVertices(unsigned int vertexCapacity);
+	void GrowIndices(unsigned int indexCapacity);
+	// Moves the mesh's range if the allocator has a lower one free, returns the bytes copied
+	unsigned int Move(Mesh& mesh, bool indices);
+};
@@ -0,0 +1,456 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Triangles using each vertex, those of vertex v are Triangles[Offsets[v], Offsets[v + 1])
+struct Adjacency {
+    std::vector<unsigned int> Offsets;
+    std::vector<unsigned int> Triangles;
+};
+
+static void BuildAdjacency(Adjacency& adjacency, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount) {
+    adjacency.Offsets.assign(vertexCount + 1, 0);
+    for (unsigned int i = 0; i < indexCount; i++) {
+        adjacency.Offsets[indices[i] + 1]++;
+    }
+    for (unsigned int v = 0; v < vertexCount; v++) {
+        adjacency.Offsets[v + 1] += adjacency.Offsets[v];
+    }
+    std::vector<unsigned int> fill(adjacency.Offsets.begin(), adjacency.Offsets.end() - 1);
+    adjacency.Triangles.resize(indexCount);
+    for (unsigned int i = 0; i < indexCount; i++) {
+        adjacency.Triangles[fill[indices[i]]++] = i / 3;
+    }
+}
+
+// FIFO cache through timestamps: a vertex is cached while fewer than cacheSize vertices went in after it.
+// Returns how many of the triangle's vertices missed
+static unsigned int UpdateFifoCache(const unsigned int* triangle, unsigned int cacheSize, std::vector<unsigned int>& cacheTimes, unsigned int& time) {
+    unsigned int misses = 0;
+    for (int corner = 0; corner < 3; corner++) {
+        unsigned int v = triangle[corner];
+        if (time - cacheTimes[v] > cacheSize) {
+            cacheTimes[v] = time++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+namespace MeshOptimizer {
+    VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, unsigned int cacheSize) {
+        std::vector<unsigned int> cacheTimes(vertexCount, 0);
+        std::vector<bool> used(vertexCount, false);
+        unsigned int time = cacheSize + 1;
+        unsigned int transformed = 0, usedCount = 0;
+        for (unsigned int i = 0; i + 2 < indexCount; i += 3) {
+            transformed += UpdateFifoCache(indices + i, cacheSize, cacheTimes, time);
+            for (int corner = 0; corner < 3; corner++) {
+                if (!used[indices[i + corner]]) {
+                    used[indices[i + corner]] = true;
+                    usedCount++;
+                }
+            }
+        }
+        VertexCacheStats stats;
+        stats.VerticesTransformed = transformed;
+        stats.ACMR = indexCount >= 3 ? (float)transformed / (indexCount / 3) : 0.0f;
+        stats.ATVR = usedCount > 0 ? (float)transformed / usedCount : 0.0f;
+        return stats;
+    }
+
+    VertexFetchStats AnalyzeVertexFetch(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, unsigned int vertexSize,
+                                        unsigned int cacheLines, unsigned int lineSize) {
+        // Only vertices missing the post-transform cache get fetched
+        std::vector<unsigned int> cacheTimes(vertexCount, 0);
+        std::vector<bool> used(vertexCount, false);
+        unsigned int time = 16 + 1;
+        unsigned int usedCount = 0;
+
+        std::vector<unsigned long long> lines(cacheLines, ~0ull);
+        std::vector<unsigned long long> lastUse(cacheLines, 0);
+        unsigned long long now = 0;
+        unsigned int bytes = 0;
+        for (unsigned int i = 0; i + 2 < indexCount; i += 3) {
+            for (int corner = 0; corner < 3; corner++) {
+                unsigned int v = indices[i + corner];
+                if (!used[v]) {
+                    used[v] = true;
+                    usedCount++;
+                }
+                if (time - cacheTimes[v] <= 16) {
+                    continue;
+                }
+                cacheTimes[v] = time++;
+
+                unsigned long long first = (unsigned long long)v * vertexSize / lineSize;
+                unsigned long long last = ((unsigned long long)v * vertexSize + vertexSize - 1) / lineSize;
+                for (unsigned long long line = first; line <= last; line++) {
+                    unsigned int slot = 0;
+                    bool hit = false;
+                    for (unsigned int s = 0; s < cacheLines; s++) {
+                        if (lines[s] == line) {
+                            slot = s;
+                            hit = true;
+                            break;
+                        }
+                        if (lastUse[s] < lastUse[slot]) {
+                            slot = s;
+                        }
+                    }
+                    if (!hit) {
+                        lines[slot] = line;
+                        bytes += lineSize;
+                    }
+                    lastUse[slot] = ++now;
+                }
+            }
+        }
+        VertexFetchStats stats;
+        stats.BytesFetched = bytes;
+        stats.Overfetch = usedCount > 0 ? (float)bytes / ((float)usedCount * vertexSize) : 0.0f;
+        return stats;
+    }
+
+    // Forsyth, "Linear-Speed Vertex Cache Optimisation", with his constants and a 32 entry LRU model
+    static const int FORSYTH_CACHE_SIZE = 32;
+    static const int FORSYTH_VALENCE_TABLE = 32;
+
+    static float ForsythCacheScore(int position) {
+        if (position < 0) {
+            return 0.0f;
+        }
+        // The last triangle's vertices score a bit lower so the next one doesn't just turn around on them
+        if (position < 3) {
+            return 0.75f;
+        }
+        return std::pow(1.0f - (float)(position - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+
+    static void OptimizeVertexCacheForsyth(unsigned int* destination, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount) {
+        unsigned int triangleCount = indexCount / 3;
+        Adjacency adjacency;
+        BuildAdjacency(adjacency, indices, triangleCount * 3, vertexCount);
+
+        // Lone vertices are worth finishing off, which keeps the mesh from being left full of holes
+        float cacheScores[FORSYTH_CACHE_SIZE];
+        float valenceScores[FORSYTH_VALENCE_TABLE];
+        for (int i = 0; i < FORSYTH_CACHE_SIZE; i++) {
+            cacheScores[i] = ForsythCacheScore(i);
+        }
+        for (int i = 1; i < FORSYTH_VALENCE_TABLE; i++) {
+            valenceScores[i] = 2.0f / std::sqrt((float)i);
+        }
+        auto vertexScore = [&](int position, unsigned int live) {
+            if (live == 0) {
+                return -1.0f;
+            }
+            float valence = live < (unsigned int)FORSYTH_VALENCE_TABLE ? valenceScores[live] : 2.0f / std::sqrt((float)live);
+            return (position >= 0 ? cacheScores[position] : 0.0f) + valence;
+        };
+
+        std::vector<unsigned int> live(vertexCount);
+        std::vector<float> vertexScores(vertexCount);
+        for (unsigned int v = 0; v < vertexCount; v++) {
+            live[v] = adjacency.Offsets[v + 1] - adjacency.Offsets[v];
+            vertexScores[v] = vertexScore(-1, live[v]);
+        }
+        std::vector<bool> emitted(triangleCount, false);
+
+        std::vector<unsigned int> output(triangleCount * 3);
+        unsigned int cache[FORSYTH_CACHE_SIZE + 3];
+        unsigned int cacheCount = 0;
+        unsigned int cursor = 0; // Restart point once nothing in the cache has triangles left
+        int best = -1;
+        for (unsigned int out = 0; out < triangleCount; out++) {
+            if (best < 0) {
+                while (emitted[cursor]) {
+                    cursor++;
+                }
+                best = (int)cursor;
+            }
+            const unsigned int* triangle = indices + best * 3;
+            memcpy(&output[out * 3], triangle, 3 * sizeof(unsigned int));
+            emitted[best] = true;
+
+            // Drops the triangle from its vertices' live lists, which keep live ones at the front
+            for (int corner = 0; corner < 3; corner++) {
+                unsigned int v = triangle[corner];
+                unsigned int* list = &adjacency.Triangles[adjacency.Offsets[v]];
+                for (unsigned int i = 0; i < live[v]; i++) {
+                    if (list[i] == (unsigned int)best) {
+                        std::swap(list[i], list[live[v] - 1]);
+                        live[v]--;
+                        break;
+                    }
+                }
+            }
+
+            // New LRU order: the triangle's vertices first, then the rest of the old cache
+            unsigned int newCache[FORSYTH_CACHE_SIZE + 3];
+            unsigned int newCount = 0;
+            for (int corner = 0; corner < 3; corner++) {
+                if (std::find(newCache, newCache + newCount, triangle[corner]) == newCache + newCount) {
+                    newCache[newCount++] = triangle[corner];
+                }
+            }
+            unsigned int triangleVertices = newCount;
+            for (unsigned int i = 0; i < cacheCount; i++) {
+                if (std::find(newCache, newCache + triangleVertices, cache[i]) == newCache + triangleVertices) {
+                    newCache[newCount++] = cache[i];
+                }
+            }
+
+            // Rescores everything that moved, including what fell out, and picks the best triangle still touching the cache
+            best = -1;
+            float bestScore = -1.0f;
+            for (unsigned int i = 0; i < newCount; i++) {
+                vertexScores[newCache[i]] = vertexScore(i < (unsigned int)FORSYTH_CACHE_SIZE ? (int)i : -1, live[newCache[i]]);
+            }
+            for (unsigned int i = 0; i < newCount; i++) {
+                unsigned int v = newCache[i];
+                const unsigned int* list = &adjacency.Triangles[adjacency.Offsets[v]];
+                for (unsigned int j = 0; j < live[v]; j++) {
+                    unsigned int t = list[j];
+                    float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                    if (i < (unsigned int)FORSYTH_CACHE_SIZE && score > bestScore) {
+                        bestScore = score;
+                        best = (int)t;
+                    }
+                }
+            }
+            cacheCount = std::min(newCount, (unsigned int)FORSYTH_CACHE_SIZE);
+            memcpy(cache, newCache, cacheCount * sizeof(unsigned int));
+        }
+        memcpy(destination, output.data(), output.size() * sizeof(unsigned int));
+    }
+
+    // Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+    static const unsigned int TIPSIFY_CACHE_SIZE = 16;
+
+    static void OptimizeVertexCacheTipsify(unsigned int* destination, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount) {
+        unsigned int triangleCount = indexCount / 3;
+        if (triangleCount == 0) {
+            return;
+        }
+        Adjacency adjacency;
+        BuildAdjacency(adjacency, indices, triangleCount * 3, vertexCount);
+
+        std::vector<unsigned int> live(vertexCount);
+        for (unsigned int v = 0; v < vertexCount; v++) {
+            live[v] = adjacency.Offsets[v + 1] - adjacency.Offsets[v];
+        }
+        std::vector<unsigned int> cacheTimes(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<unsigned int> deadEnds; // Recently used vertices to fall back on when the fan runs dry
+        std::vector<unsigned int> candidates;
+        std::vector<unsigned int> output;
+        output.reserve(triangleCount * 3);
+        unsigned int time = TIPSIFY_CACHE_SIZE + 1;
+        unsigned int cursor = 0;
+
+        long long fan = indices[0];
+        while (fan >= 0) {
+            // Every remaining triangle around the fanning vertex
+            candidates.clear();
+            for (unsigned int i = adjacency.Offsets[fan]; i < adjacency.Offsets[fan + 1]; i++) {
+                unsigned int t = adjacency.Triangles[i];
+                if (emitted[t]) {
+                    continue;
+                }
+                emitted[t] = true;
+                for (int corner = 0; corner < 3; corner++) {
+                    unsigned int v = indices[t * 3 + corner];
+                    output.push_back(v);
+                    deadEnds.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+                    if (time - cacheTimes[v] > TIPSIFY_CACHE_SIZE) {
+                        cacheTimes[v] = time++;
+                    }
+                }
+            }
+
+            // Next fan: the oldest candidate that will still be cached once its own triangles are emitted
+            fan = -1;
+            long long bestPriority = -1;
+            for (unsigned int v : candidates) {
+                if (live[v] == 0) {
+                    continue;
+                }
+                long long priority = 0;
+                if (time - cacheTimes[v] + 2 * live[v] <= TIPSIFY_CACHE_SIZE) {
+                    priority = time - cacheTimes[v];
+                }
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    fan = v;
+                }
+            }
+            while (fan < 0 && !deadEnds.empty()) {
+                unsigned int v = deadEnds.back();
+                deadEnds.pop_back();
+                if (live[v] > 0) {
+                    fan = v;
+                }
+            }
+            while (fan < 0 && cursor < vertexCount) {
+                if (live[cursor] > 0) {
+                    fan = cursor;
+                }
+                cursor++;
+            }
+        }
+        memcpy(destination, output.data(), output.size() * sizeof(unsigned int));
+    }
+
+    void OptimizeVertexCache(unsigned int* destination, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, CacheMethod method) {
+        if (method == CacheMethod::Tipsify) {
+            OptimizeVertexCacheTipsify(destination, indices, indexCount, vertexCount);
+        }
+        else {
+            OptimizeVertexCacheForsyth(destination, indices, indexCount, vertexCount);
+        }
+    }
+
+    struct Cluster {
+        unsigned int First; // Triangle
+        unsigned int Count;
+        float Key;
+    };
+
+    void OptimizeOverdraw(unsigned int* destination, const unsigned int* indices, unsigned int indexCount, const float* positions,
+                          unsigned int vertexCount, unsigned int positionStride, float threshold) {
+        const unsigned int cacheSize = 16;
+        unsigned int triangleCount = indexCount / 3;
+        if (triangleCount == 0) {
+            return;
+        }
+        std::vector<unsigned int> source(indices, indices + triangleCount * 3);
+        auto position = [&](unsigned int v) { return (const float*)((const unsigned char*)positions + (size_t)v * positionStride); };
+
+        // Hard boundaries where the cache went completely cold
+        std::vector<unsigned int> cacheTimes(vertexCount, 0);
+        unsigned int time = cacheSize + 1;
+        std::vector<unsigned int> hard;
+        unsigned int totalMisses = 0;
+        for (unsigned int t = 0; t < triangleCount; t++) {
+            unsigned int misses = UpdateFifoCache(&source[t * 3], cacheSize, cacheTimes, time);
+            if (t == 0 || misses == 3) {
+                hard.push_back(t);
+            }
+            totalMisses += misses;
+        }
+        hard.push_back(triangleCount);
+
+        // Soft boundaries: once a cluster started cold has brought its ACMR down near the whole mesh's, reordering
+        // it costs little, so a new cluster starts there
+        float limit = threshold * totalMisses / triangleCount;
+        std::vector<Cluster> clusters;
+        for (size_t h = 0; h + 1 < hard.size(); h++) {
+            unsigned int first = hard[h];
+            unsigned int misses = 0;
+            time += cacheSize + 1;
+            for (unsigned int t = hard[h]; t < hard[h + 1]; t++) {
+                misses += UpdateFifoCache(&source[t * 3], cacheSize, cacheTimes, time);
+                if (t + 1 < hard[h + 1] && (float)misses <= limit * (t + 1 - first)) {
+                    clusters.push_back({ first, t + 1 - first, 0.0f });
+                    first = t + 1;
+                    misses = 0;
+                    time += cacheSize + 1;
+                }
+            }
+            clusters.push_back({ first, hard[h + 1] - first, 0.0f });
+        }
+
+        // Clusters out at the silhouette, facing away from the center, occlude the most and go first
+        float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+        for (unsigned int i = 0; i < triangleCount * 3; i++) {
+            const float* p = position(source[i]);
+            for (int c = 0; c < 3; c++) {
+                meshCenter[c] += p[c];
+            }
+        }
+        for (int c = 0; c < 3; c++) {
+            meshCenter[c] /= triangleCount * 3;
+        }
+        for (Cluster& cluster : clusters) {
+            float center[3] = { 0.0f, 0.0f, 0.0f }, normal[3] = { 0.0f, 0.0f, 0.0f };
+            float totalArea = 0.0f;
+            for (unsigned int t = cluster.First; t < cluster.First + cluster.Count; t++) {
+                const float* p0 = position(source[t * 3]);
+                const float* p1 = position(source[t * 3 + 1]);
+                const float* p2 = position(source[t * 3 + 2]);
+                float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+                float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+                float cross[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+                float area = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+                for (int c = 0; c < 3; c++) {
+                    center[c] += (p0[c] + p1[c] + p2[c]) / 3.0f * area;
+                    normal[c] += cross[c];
+                }
+                totalArea += area;
+            }
+            float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            if (totalArea <= 0.0f || length <= 0.0f) {
+                continue; // Degenerate, keeps a key of 0
+            }
+            cluster.Key = 0.0f;
+            for (int c = 0; c < 3; c++) {
+                cluster.Key += (center[c] / totalArea - meshCenter[c]) * normal[c] / length;
+            }
+        }
+        std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.Key > b.Key; });
+
+        unsigned int* out = destination;
+        for (const Cluster& cluster : clusters) {
+            memcpy(out, &source[cluster.First * 3], cluster.Count * 3 * sizeof(unsigned int));
+            out += cluster.Count * 3;
+        }
+    }
+
+    unsigned int OptimizeVertexFetch(unsigned int* remap, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount) {
+        for (unsigned int v = 0; v < vertexCount; v++) {
+            remap[v] = ~0u;
+        }
+        unsigned int next = 0;
+        for (unsigned int i = 0; i < indexCount; i++) {
+            if (remap[indices[i]] == ~0u) {
+                remap[indices[i]] = next++;
+            }
+        }
+        return next;
+    }
+
+    void RemapIndices(unsigned int* destination, const unsigned int* indices, unsigned int indexCount, const unsigned int* remap) {
+        for (unsigned int i = 0; i < indexCount; i++) {
+            destination[i] = remap[indices[i]];
+        }
+    }
+
+    void RemapVertices(void* destination, const void* vertices, unsigned int vertexCount, unsigned int vertexSize, const unsigned int* remap) {
+        for (unsigned int v = 0; v < vertexCount; v++) {
+            if (remap[v] != ~0u) {
+                memcpy((unsigned char*)destination + (size_t)remap[v] * vertexSize, (const unsigned char*)vertices + (size_t)v * vertexSize, vertexSize);
+            }
+        }
+    }
+
+    void Optimize(std::vector<unsigned int>& indices, std::vector<unsigned char>& vertices, unsigned int vertexSize, unsigned int positionOffset,
+                  float overdrawThreshold) {
+        unsigned int indexCount = (unsigned int)indices.size();
+        unsigned int vertexCount = (unsigned int)(vertices.size() / vertexSize);
+        OptimizeVertexCache(indices.data(), indices.data(), indexCount, vertexCount);
+        OptimizeOverdraw(indices.data(), indices.data(), indexCount, (const float*)(vertices.data() + positionOffset), vertexCount, vertexSize,
+                         overdrawThreshold);
+
+        std::vector<unsigned int> remap(vertexCount);
+        unsigned int used = OptimizeVertexFetch(remap.data(), indices.data(), indexCount, vertexCount);
+        RemapIndices(indices.data(), indices.data(), indexCount, remap.data());
+        std::vector<unsigned char> fetched((size_t)used * vertexSize);
+        RemapVertices(fetched.data(), vertices.data(), vertexCount, vertexSize, remap.data());
+        vertices.swap(fetched);
+    }
+}
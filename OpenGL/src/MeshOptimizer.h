@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+
+// Reorders indexed triangle lists for the GPU, meant for load or cook time. The usual order is
+//	OptimizeVertexCache, so each vertex is shaded as few times as possible
+//	OptimizeOverdraw, which moves whole clusters of that order around so outer surfaces draw first
+//	OptimizeVertexFetch, renumbering vertices in the order the triangles first use them
+// or Optimize, which does all three on an interleaved vertex buffer.
+// The Analyze functions measure an index buffer against a simulated post-transform cache and vertex fetch.
+namespace MeshOptimizer {
+	enum class CacheMethod {
+		Tipsify, // Fans around one vertex at a time targeting a 16 entry cache, the faster and better of the two on that or anything bigger
+		Forsyth  // Scores vertices by LRU position and remaining triangles, degrades more gracefully on caches smaller than expected
+	};
+
+	struct VertexCacheStats {
+		unsigned int VerticesTransformed;
+		float ACMR; // Vertices transformed per triangle, 0.5 is the limit for a large regular grid, 3 the worst
+		float ATVR; // Vertices transformed per vertex used, 1 is perfect
+	};
+
+	struct VertexFetchStats {
+		unsigned int BytesFetched;
+		float Overfetch; // Bytes fetched over the size of the vertices used, 1 is perfect
+	};
+
+	// Simulates a FIFO post-transform cache of cacheSize vertices, the model most hardware is closest to
+	VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, unsigned int cacheSize = 16);
+	// Simulates an LRU cache of cacheLines lines of lineSize bytes in front of the vertex buffer
+	VertexFetchStats AnalyzeVertexFetch(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, unsigned int vertexSize,
+										unsigned int cacheLines = 64, unsigned int lineSize = 64);
+
+	// destination may be indices
+	void OptimizeVertexCache(unsigned int* destination, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+							 CacheMethod method = CacheMethod::Tipsify);
+	// Takes a cache optimized list and splits it into clusters wherever the cache went cold, and again wherever a
+	// cluster has brought its ACMR down to threshold times the whole mesh's. Clusters facing away from the mesh's center
+	// are moved to the front, so they fill depth before what they hide. positions is the first float of each
+	// vertex's x, y, z, positionStride bytes apart. destination may be indices
+	void OptimizeOverdraw(unsigned int* destination, const unsigned int* indices, unsigned int indexCount, const float* positions,
+						  unsigned int vertexCount, unsigned int positionStride, float threshold = 1.05f);
+	// Fills remap with each vertex's new position in first use order, ~0u for vertices no triangle uses,
+	// and returns how many are used
+	unsigned int OptimizeVertexFetch(unsigned int* remap, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount);
+	void RemapIndices(unsigned int* destination, const unsigned int* indices, unsigned int indexCount, const unsigned int* remap);
+	// destination holds the used vertices only, it must not be vertices
+	void RemapVertices(void* destination, const void* vertices, unsigned int vertexCount, unsigned int vertexSize, const unsigned int* remap);
+
+	// All three passes. vertices is interleaved with vertexSize bytes per vertex and its position as three
+	// floats positionOffset bytes in. Unused vertices are dropped
+	void Optimize(std::vector<unsigned int>& indices, std::vector<unsigned char>& vertices, unsigned int vertexSize, unsigned int positionOffset,
+				  float overdrawThreshold = 1.05f);
+}
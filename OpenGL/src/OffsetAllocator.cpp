@@ -0,0 +1,245 @@
+#include "OffsetAllocator.h"
+
+#include <cstring>
+#include "Renderer.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Bins are a float with 3 mantissa bits: sizes below 8 get a bin each, then 8 bins per power of two
+static const unsigned int MANTISSA_BITS = 3;
+static const unsigned int MANTISSA_VALUE = 1 << MANTISSA_BITS;
+static const unsigned int MANTISSA_MASK = MANTISSA_VALUE - 1;
+static const unsigned int NO_NODE = 0xffffffff;
+
+static unsigned int LowestBit(unsigned int value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return index;
+#else
+    return __builtin_ctz(value);
+#endif
+}
+
+static unsigned int HighestBit(unsigned int value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, value);
+    return index;
+#else
+    return 31 - __builtin_clz(value);
+#endif
+}
+
+// Lowest set bit at or above start, NO_NODE when there's none
+static unsigned int LowestBitFrom(unsigned int mask, unsigned int start) {
+    if (start >= 32) {
+        return NO_NODE;
+    }
+    mask &= ~0u << start;
+    return mask != 0 ? LowestBit(mask) : NO_NODE;
+}
+
+// Rounding up when allocating and down when storing a free range means any range found in a bin
+// at or above the request's is big enough
+static unsigned int SizeToBin(unsigned int size, bool roundUp) {
+    if (size < MANTISSA_VALUE) {
+        return size;
+    }
+    unsigned int mantissaStart = HighestBit(size) - MANTISSA_BITS;
+    unsigned int bin = ((mantissaStart + 1) << MANTISSA_BITS) + ((size >> mantissaStart) & MANTISSA_MASK);
+    if (roundUp && (size & ((1u << mantissaStart) - 1)) != 0) {
+        bin++; // May carry into the next power of two, which is still the right bin
+    }
+    return bin;
+}
+
+static unsigned int BinToSize(unsigned int bin) {
+    unsigned int exponent = bin >> MANTISSA_BITS;
+    unsigned int mantissa = bin & MANTISSA_MASK;
+    return exponent == 0 ? mantissa : (mantissa | MANTISSA_VALUE) << (exponent - 1);
+}
+
+OffsetAllocator::OffsetAllocator(unsigned int size)
+    : m_Size(size), m_FreeSize(0), m_AllocationCount(0), m_UsedTopBins(0), m_LastNode(NO_NODE) {
+    memset(m_UsedLeafBins, 0, sizeof(m_UsedLeafBins));
+    for (unsigned int& head : m_BinHeads) {
+        head = NO_NODE;
+    }
+    if (size > 0) {
+        m_LastNode = NewNode(0, size, false);
+    }
+}
+
+OffsetAllocator::Allocation OffsetAllocator::Allocate(unsigned int size) {
+    ASSERT(size > 0);
+    unsigned int minimumBin = SizeToBin(size, true);
+    unsigned int top = minimumBin >> MANTISSA_BITS;
+    unsigned int leaf = NO_NODE;
+    if (m_UsedTopBins & (1u << top)) {
+        leaf = LowestBitFrom(m_UsedLeafBins[top], minimumBin & MANTISSA_MASK);
+    }
+    if (leaf == NO_NODE) {
+        top = LowestBitFrom(m_UsedTopBins, top + 1);
+        if (top == NO_NODE) {
+            return { NO_SPACE, NO_NODE };
+        }
+        leaf = LowestBit(m_UsedLeafBins[top]);
+    }
+
+    unsigned int node = m_BinHeads[(top << MANTISSA_BITS) | leaf];
+    RemoveFromBin(node);
+    unsigned int remainder = m_Nodes[node].Size - size;
+    m_Nodes[node].Size = size;
+    m_Nodes[node].Used = true;
+    if (remainder > 0) {
+        // The rest stays free right after the allocation
+        unsigned int split = NewNode(m_Nodes[node].Offset + size, remainder, false);
+        unsigned int next = m_Nodes[node].NeighborNext;
+        m_Nodes[split].NeighborPrev = node;
+        m_Nodes[split].NeighborNext = next;
+        if (next != NO_NODE) {
+            m_Nodes[next].NeighborPrev = split;
+        }
+        m_Nodes[node].NeighborNext = split;
+        if (m_LastNode == node) {
+            m_LastNode = split;
+        }
+    }
+    m_AllocationCount++;
+    return { m_Nodes[node].Offset, node };
+}
+
+void OffsetAllocator::Free(Allocation allocation) {
+    unsigned int node = allocation.Node;
+    ASSERT(node < m_Nodes.size() && m_Nodes[node].Used);
+    unsigned int offset = m_Nodes[node].Offset;
+    unsigned int size = m_Nodes[node].Size;
+    unsigned int prev = m_Nodes[node].NeighborPrev;
+    unsigned int next = m_Nodes[node].NeighborNext;
+
+    // Free neighbours are absorbed and their nodes recycled
+    if (prev != NO_NODE && !m_Nodes[prev].Used) {
+        RemoveFromBin(prev);
+        offset = m_Nodes[prev].Offset;
+        size += m_Nodes[prev].Size;
+        m_UnusedNodes.push_back(prev);
+        prev = m_Nodes[prev].NeighborPrev;
+    }
+    if (next != NO_NODE && !m_Nodes[next].Used) {
+        RemoveFromBin(next);
+        size += m_Nodes[next].Size;
+        if (m_LastNode == next) {
+            m_LastNode = node;
+        }
+        m_UnusedNodes.push_back(next);
+        next = m_Nodes[next].NeighborNext;
+    }
+
+    Node& merged = m_Nodes[node];
+    merged.Offset = offset;
+    merged.Size = size;
+    merged.Used = false;
+    merged.NeighborPrev = prev;
+    merged.NeighborNext = next;
+    if (prev != NO_NODE) {
+        m_Nodes[prev].NeighborNext = node;
+    }
+    if (next != NO_NODE) {
+        m_Nodes[next].NeighborPrev = node;
+    }
+    InsertIntoBin(node);
+    m_AllocationCount--;
+}
+
+void OffsetAllocator::Grow(unsigned int size) {
+    ASSERT(size >= m_Size);
+    if (size == m_Size) {
+        return;
+    }
+    unsigned int extra = size - m_Size;
+    if (m_LastNode != NO_NODE && !m_Nodes[m_LastNode].Used) {
+        RemoveFromBin(m_LastNode);
+        m_Nodes[m_LastNode].Size += extra;
+        InsertIntoBin(m_LastNode);
+    }
+    else {
+        unsigned int node = NewNode(m_Size, extra, false);
+        m_Nodes[node].NeighborPrev = m_LastNode;
+        if (m_LastNode != NO_NODE) {
+            m_Nodes[m_LastNode].NeighborNext = node;
+        }
+        m_LastNode = node;
+    }
+    m_Size = size;
+}
+
+unsigned int OffsetAllocator::GetAllocationSize(Allocation allocation) const {
+    return m_Nodes[allocation.Node].Size;
+}
+
+unsigned int OffsetAllocator::GetLargestFreeSize() const {
+    if (m_UsedTopBins == 0) {
+        return 0;
+    }
+    unsigned int top = HighestBit(m_UsedTopBins);
+    return BinToSize((top << MANTISSA_BITS) | HighestBit(m_UsedLeafBins[top]));
+}
+
+unsigned int OffsetAllocator::NewNode(unsigned int offset, unsigned int size, bool used) {
+    unsigned int node;
+    if (!m_UnusedNodes.empty()) {
+        node = m_UnusedNodes.back();
+        m_UnusedNodes.pop_back();
+    }
+    else {
+        node = (unsigned int)m_Nodes.size();
+        m_Nodes.emplace_back();
+    }
+    m_Nodes[node] = { offset, size, NO_NODE, NO_NODE, NO_NODE, NO_NODE, used };
+    if (!used) {
+        InsertIntoBin(node);
+    }
+    return node;
+}
+
+void OffsetAllocator::InsertIntoBin(unsigned int node) {
+    unsigned int bin = SizeToBin(m_Nodes[node].Size, false);
+    unsigned int top = bin >> MANTISSA_BITS;
+    if (m_BinHeads[bin] == NO_NODE) {
+        m_UsedLeafBins[top] |= 1 << (bin & MANTISSA_MASK);
+        m_UsedTopBins |= 1u << top;
+    }
+    else {
+        m_Nodes[m_BinHeads[bin]].BinPrev = node;
+    }
+    m_Nodes[node].BinPrev = NO_NODE;
+    m_Nodes[node].BinNext = m_BinHeads[bin];
+    m_BinHeads[bin] = node;
+    m_FreeSize += m_Nodes[node].Size;
+}
+
+void OffsetAllocator::RemoveFromBin(unsigned int node) {
+    unsigned int prev = m_Nodes[node].BinPrev;
+    unsigned int next = m_Nodes[node].BinNext;
+    if (prev != NO_NODE) {
+        m_Nodes[prev].BinNext = next;
+    }
+    else {
+        unsigned int bin = SizeToBin(m_Nodes[node].Size, false);
+        unsigned int top = bin >> MANTISSA_BITS;
+        m_BinHeads[bin] = next;
+        if (next == NO_NODE) {
+            m_UsedLeafBins[top] &= ~(1 << (bin & MANTISSA_MASK));
+            if (m_UsedLeafBins[top] == 0) {
+                m_UsedTopBins &= ~(1u << top);
+            }
+        }
+    }
+    if (next != NO_NODE) {
+        m_Nodes[next].BinPrev = prev;
+    }
+    m_FreeSize -= m_Nodes[node].Size;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+
+// Hands out ranges of an abstract [0, size) space, in whatever unit the caller works in, for
+// sub-allocating GL buffers. Two level segregated fit: free ranges sit in 256 bins by a small float of
+// their size (3 mantissa bits), and a bitmask per level finds the first big enough bin in constant time.
+// Freed ranges merge with free neighbours right away, so fragmentation only comes from live allocations.
+// A free range is binned by its size rounded down and a request by its size rounded up, so a range can be
+// up to an eighth bigger than the largest request it's sure to satisfy.
+class OffsetAllocator {
+public:
+	static const unsigned int NO_SPACE = 0xffffffff;
+
+	struct Allocation {
+		unsigned int Offset; // NO_SPACE when the allocation failed
+		unsigned int Node; // Internal, pass the allocation back to Free as is
+	};
+private:
+	struct Node {
+		unsigned int Offset;
+		unsigned int Size;
+		unsigned int BinPrev, BinNext; // Free nodes of the same bin
+		unsigned int NeighborPrev, NeighborNext; // Adjacent ranges, by offset
+		bool Used;
+	};
+
+	unsigned int m_Size;
+	unsigned int m_FreeSize;
+	unsigned int m_AllocationCount;
+	unsigned int m_UsedTopBins;
+	unsigned char m_UsedLeafBins[32];
+	unsigned int m_BinHeads[256];
+	std::vector<Node> m_Nodes;
+	std::vector<unsigned int> m_UnusedNodes;
+	unsigned int m_LastNode; // Range ending at m_Size
+public:
+	OffsetAllocator(unsigned int size);
+
+	// Offset is NO_SPACE when no free range fits
+	Allocation Allocate(unsigned int size);
+	void Free(Allocation allocation);
+	// Extends the space to size, the new room is free
+	void Grow(unsigned int size);
+
+	unsigned int GetAllocationSize(Allocation allocation) const;
+	inline unsigned int GetSize() const { return m_Size; }
+	inline unsigned int GetFreeSize() const { return m_FreeSize; }
+	inline unsigned int GetAllocationCount() const { return m_AllocationCount; }
+	// Largest size Allocate is sure to succeed for, rounded down to a bin
+	unsigned int GetLargestFreeSize() const;
+private:
+	unsigned int NewNode(unsigned int offset, unsigned int size, bool used);
+	void InsertIntoBin(unsigned int node);
+	void RemoveFromBin(unsigned int node);
+};
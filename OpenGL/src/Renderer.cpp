@@ -1,5 +1,6 @@
 #include <iostream>
 #include "Renderer.h"
+#include "GpuResources.h"
 
 void GLClearError() {
     while (glGetError() != GL_NO_ERROR);
@@ -17,9 +18,26 @@ void Renderer::Clear() const {
     GLCall(glClear(GL_COLOR_BUFFER_BIT));
 }
 
-void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const {
-    shader.Bind();
+void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int primitive) const {
     va.Bind();
     ib.Bind();
-    GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr));
+    Draw(ib, shader, primitive);
+}
+
+void Renderer::Draw(const IndexBuffer& ib, const Shader& shader, unsigned int primitive) const {
+    shader.Bind();
+    if (ib.IsPrimitiveRestart()) {
+        // GL_PRIMITIVE_RESTART_FIXED_INDEX would pick the index from the type by itself but needs 4.3
+        GLCall(glEnable(GL_PRIMITIVE_RESTART));
+        GLCall(glPrimitiveRestartIndex(ib.GetRestartIndex()));
+    }
+    GLCall(glDrawElements(primitive, ib.GetCount(), ib.GetType(), nullptr));
+    if (ib.IsPrimitiveRestart()) {
+        GLCall(glDisable(GL_PRIMITIVE_RESTART));
+    }
+}
+
+void Renderer::Draw(ResourceHandle<VertexArray> va, ResourceHandle<IndexBuffer> ib, const Shader& shader, unsigned int primitive) const {
+    GpuResources& resources = GpuResources::Get();
+    Draw(resources.GetVertexArrays()[va], resources.GetIndexBuffers()[ib], shader, primitive);
 }
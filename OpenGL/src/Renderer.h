@@ -4,6 +4,9 @@
 #include "IndexBuffer.h"
 #include "Shader.h"
 
+template<typename T>
+class ResourceHandle;
+
 #define ASSERT(x) if (!(x)) __debugbreak();
 #define GLCall(x) GLClearError();\
     x;\
@@ -15,5 +18,10 @@ bool GLLogCall(const char* function, const char* file, int line);
 class Renderer {
 public:
     void Clear() const;
-    void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+    // primitive is any glDrawElements mode, strips and fans can be cut with IndexBuffer::RESTART
+    void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int primitive = GL_TRIANGLES) const;
+    // With whatever VAO is bound, which has ib as its element buffer, e.g. after VertexArrayCache::Bind
+    void Draw(const IndexBuffer& ib, const Shader& shader, unsigned int primitive = GL_TRIANGLES) const;
+    // Looks the VAO and index buffer up in GpuResources, both handles have to be valid
+    void Draw(ResourceHandle<VertexArray> va, ResourceHandle<IndexBuffer> ib, const Shader& shader, unsigned int primitive = GL_TRIANGLES) const;
 };
\ No newline at end of file
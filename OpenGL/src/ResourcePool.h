@@ -0,0 +1,160 @@
+#pragma once
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Renderer.h"
+
+// 32-bit reference to a resource in a ResourcePool<T>, the low INDEX_BITS are its slot and the rest the
+// generation the slot was in when the resource was created. Destroying a resource moves its slot on to the
+// next generation, so a stale handle fails IsValid instead of reaching whatever reuses the slot.
+// Small enough to pack into sort keys and command lists, and 0 is never valid.
+template<typename T>
+class ResourceHandle {
+public:
+	static const unsigned int INDEX_BITS = 20; // About a million live resources of each type
+	static const unsigned int INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static const unsigned int MAX_GENERATION = (1u << (32 - INDEX_BITS)) - 1;
+private:
+	unsigned int m_Value;
+public:
+	ResourceHandle() : m_Value(0) {}
+	ResourceHandle(unsigned int index, unsigned int generation) : m_Value(generation << INDEX_BITS | index) {}
+
+	// Back from GetValue, e.g. when unpacking a sort key
+	static ResourceHandle FromValue(unsigned int value) {
+		ResourceHandle handle;
+		handle.m_Value = value;
+		return handle;
+	}
+
+	inline unsigned int GetIndex() const { return m_Value & INDEX_MASK; }
+	inline unsigned int GetGeneration() const { return m_Value >> INDEX_BITS; }
+	inline unsigned int GetValue() const { return m_Value; }
+	inline bool IsNull() const { return m_Value == 0; }
+
+	inline bool operator==(const ResourceHandle& other) const { return m_Value == other.m_Value; }
+	inline bool operator!=(const ResourceHandle& other) const { return m_Value != other.m_Value; }
+};
+
+// Owns every resource of one type, handing out ResourceHandles to them. Kept as parallel arrays rather than
+// one array of structs, so the generations every lookup checks sit packed together away from the resources.
+// Those are built in place in fixed size chunks and never move, pointers from Get stay good until Destroy.
+// Freed slots are reused most recent first, and a slot whose generation runs out is retired instead of
+// wrapping around, so a stale handle can never match a later resource.
+template<typename T>
+class ResourcePool {
+public:
+	typedef ResourceHandle<T> Handle;
+private:
+	static const unsigned int CHUNK_SIZE = 256;
+	typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+	std::vector<std::unique_ptr<Slot[]>> m_Chunks;
+	std::vector<unsigned short> m_Generations; // Of each slot, a live slot's handles carry the same one
+	std::vector<bool> m_Live;
+	std::vector<unsigned int> m_FreeSlots;
+	unsigned int m_Count;
+public:
+	ResourcePool() : m_Count(0) {}
+	ResourcePool(const ResourcePool&) = delete;
+	ResourcePool& operator=(const ResourcePool&) = delete;
+	~ResourcePool() {
+		for (unsigned int index = 0; index < m_Live.size(); index++) {
+			if (m_Live[index]) {
+				GetSlot(index)->~T();
+			}
+		}
+	}
+
+	// Constructs a T from args in a free slot, Create(std::move(resource)) takes over an existing one
+	template<typename... Args>
+	Handle Create(Args&&... args) {
+		unsigned int index;
+		if (!m_FreeSlots.empty()) {
+			index = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		else {
+			index = (unsigned int)m_Generations.size();
+			ASSERT(index <= Handle::INDEX_MASK);
+			if (index % CHUNK_SIZE == 0) {
+				m_Chunks.emplace_back(new Slot[CHUNK_SIZE]);
+			}
+			// Generation 0 is left out so the null handle never matches slot 0
+			m_Generations.push_back(1);
+			m_Live.push_back(false);
+		}
+		new (GetSlot(index)) T(std::forward<Args>(args)...);
+		m_Live[index] = true;
+		m_Count++;
+		return Handle(index, m_Generations[index]);
+	}
+
+	// Returns false, doing nothing, when the handle is already stale
+	bool Destroy(Handle handle) {
+		if (!IsValid(handle)) {
+			return false;
+		}
+		DestroySlot(handle.GetIndex());
+		return true;
+	}
+
+	// Destroys everything, handles from before stay stale
+	void Clear() {
+		for (unsigned int index = 0; index < m_Live.size(); index++) {
+			if (m_Live[index]) {
+				DestroySlot(index);
+			}
+		}
+	}
+
+	// The slot exists, is still in the handle's generation and holds a resource. Generations and live flags
+	// sit in packed arrays of their own, so this doesn't touch the resources
+	inline bool IsValid(Handle handle) const {
+		unsigned int index = handle.GetIndex();
+		return index < m_Generations.size() && m_Generations[index] == handle.GetGeneration() && m_Live[index];
+	}
+
+	// Null for stale handles
+	inline T* Get(Handle handle) { return IsValid(handle) ? GetSlot(handle.GetIndex()) : nullptr; }
+	inline const T* Get(Handle handle) const { return IsValid(handle) ? GetSlot(handle.GetIndex()) : nullptr; }
+	// For handles known to be valid
+	inline T& operator[](Handle handle) {
+		ASSERT(IsValid(handle));
+		return *GetSlot(handle.GetIndex());
+	}
+	inline const T& operator[](Handle handle) const {
+		ASSERT(IsValid(handle));
+		return *GetSlot(handle.GetIndex());
+	}
+
+	// Calls function(handle, resource) for every live resource in slot order
+	template<typename Function>
+	void ForEach(Function function) {
+		for (unsigned int index = 0; index < m_Live.size(); index++) {
+			if (m_Live[index]) {
+				function(Handle(index, m_Generations[index]), *GetSlot(index));
+			}
+		}
+	}
+
+	inline unsigned int GetCount() const { return m_Count; }
+	// Slots ever used, live or not
+	inline unsigned int GetCapacity() const { return (unsigned int)m_Generations.size(); }
+private:
+	void DestroySlot(unsigned int index) {
+		GetSlot(index)->~T();
+		m_Live[index] = false;
+		m_Count--;
+		if (m_Generations[index] < Handle::MAX_GENERATION) {
+			m_Generations[index]++;
+			m_FreeSlots.push_back(index);
+		}
+	}
+
+	inline T* GetSlot(unsigned int index) const {
+		return reinterpret_cast<T*>(&m_Chunks[index / CHUNK_SIZE][index % CHUNK_SIZE]);
+	}
+};
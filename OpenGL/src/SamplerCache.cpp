@@ -0,0 +1,65 @@
+#include "SamplerCache.h"
+
+#include <algorithm>
+#include "Renderer.h"
+
+SamplerCache* SamplerCache::s_Instance = nullptr;
+
+static GLenum GetMinFilter(SamplerFilter filter) {
+    switch (filter) {
+        case SamplerFilter::Nearest: return GL_NEAREST;
+        case SamplerFilter::Linear: return GL_LINEAR;
+        case SamplerFilter::Trilinear: return GL_LINEAR_MIPMAP_LINEAR;
+    }
+    return GL_LINEAR;
+}
+
+static GLenum GetWrapMode(SamplerWrap wrap) {
+    switch (wrap) {
+        case SamplerWrap::Clamp: return GL_CLAMP_TO_EDGE;
+        case SamplerWrap::Repeat: return GL_REPEAT;
+        case SamplerWrap::MirroredRepeat: return GL_MIRRORED_REPEAT;
+    }
+    return GL_CLAMP_TO_EDGE;
+}
+
+SamplerCache::SamplerCache() : m_MaxAnisotropy(1) {
+    ASSERT(s_Instance == nullptr);
+    s_Instance = this;
+
+    if (GLEW_EXT_texture_filter_anisotropic) {
+        float maxAnisotropy;
+        GLCall(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy));
+        m_MaxAnisotropy = (unsigned int)maxAnisotropy;
+    }
+}
+
+SamplerCache::~SamplerCache() {
+    for (const auto& sampler : m_Samplers) {
+        GLCall(glDeleteSamplers(1, &sampler.second));
+    }
+    s_Instance = nullptr;
+}
+
+unsigned int SamplerCache::GetSampler(const SamplerState& state) {
+    // Requests past the driver's limit would create samplers identical to the one at the limit
+    unsigned int anisotropy = std::min(std::max(state.Anisotropy, 1u), m_MaxAnisotropy);
+    unsigned int key = (unsigned int)state.Filter | ((unsigned int)state.Wrap << 2) | (anisotropy << 4);
+
+    auto found = m_Samplers.find(key);
+    if (found != m_Samplers.end()) {
+        return found->second;
+    }
+
+    unsigned int sampler;
+    GLCall(glGenSamplers(1, &sampler));
+    GLCall(glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GetMinFilter(state.Filter)));
+    GLCall(glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, state.Filter == SamplerFilter::Nearest ? GL_NEAREST : GL_LINEAR));
+    GLCall(glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GetWrapMode(state.Wrap)));
+    GLCall(glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GetWrapMode(state.Wrap)));
+    if (anisotropy > 1) {
+        GLCall(glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, (float)anisotropy));
+    }
+    m_Samplers[key] = sampler;
+    return sampler;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <unordered_map>
+
+enum class SamplerFilter {
+	Nearest,
+	Linear,   // Bilinear within the base level only
+	Trilinear // Bilinear within and linear between mip levels
+};
+
+enum class SamplerWrap {
+	Clamp,
+	Repeat,
+	MirroredRepeat
+};
+
+struct SamplerState {
+	SamplerFilter Filter = SamplerFilter::Trilinear;
+	SamplerWrap Wrap = SamplerWrap::Clamp;
+	unsigned int Anisotropy = 1; // 1 is off, clamped to what the driver supports
+};
+
+// Hands out one sampler object per distinct SamplerState, so textures sharing sampling state share a sampler
+// instead of each carrying its own copy of the parameters.
+class SamplerCache {
+private:
+	std::unordered_map<unsigned int, unsigned int> m_Samplers; // Packed state to sampler object
+	unsigned int m_MaxAnisotropy;
+
+	static SamplerCache* s_Instance;
+public:
+	SamplerCache();
+	~SamplerCache();
+
+	static SamplerCache& Get() { return *s_Instance; }
+
+	unsigned int GetSampler(const SamplerState& state);
+	inline unsigned int GetMaxAnisotropy() const { return m_MaxAnisotropy; }
+	inline size_t GetSamplerCount() const { return m_Samplers.size(); }
+};
@@ -4,15 +4,47 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <utility>
 #include "Renderer.h"
+#include "EmbeddedShaders.h"
+#include "DeletionQueue.h"
 
-Shader::Shader(const std::string& filepath) : m_FilePath(filepath), m_RendererID(0) {
+Shader::Shader(const std::string& filepath) : m_FilePath(filepath), m_RendererID(0), m_Spirv(false) {
 	ShaderProgramSource gfx_shader = ParseShader(m_FilePath);
-	m_RendererID = CreateShader(gfx_shader.VertexSource, gfx_shader.FragmentSource);
+	// Keywords still have to be declared even with all of them off
+	m_Spirv = UsesSpirv(gfx_shader);
+	m_RendererID = FinishShader(BeginCreateShader(gfx_shader, 0));
+}
+
+Shader::Shader(const std::string& filepath, const ShaderProgramSource& source, unsigned int keywordMask)
+    : m_FilePath(filepath), m_RendererID(0), m_Spirv(UsesSpirv(source)) {
+    m_RendererID = FinishShader(BeginCreateShader(source, keywordMask));
+}
+
+Shader::Shader(const std::string& filepath, const PendingProgram& pending) : m_FilePath(filepath), m_RendererID(0), m_Spirv(pending.Spirv) {
+    m_RendererID = FinishShader(pending);
+}
+
+Shader::Shader(Shader&& other)
+    : m_FilePath(std::move(other.m_FilePath)), m_RendererID(other.m_RendererID), m_Spirv(other.m_Spirv),
+      m_UniformLocationCache(std::move(other.m_UniformLocationCache)) {
+    other.m_RendererID = 0;
+}
+
+Shader& Shader::operator=(Shader&& other) {
+    if (this != &other) {
+        DeletionQueue::DeleteProgram(m_RendererID);
+        m_FilePath = std::move(other.m_FilePath);
+        m_RendererID = other.m_RendererID;
+        m_Spirv = other.m_Spirv;
+        m_UniformLocationCache = std::move(other.m_UniformLocationCache);
+        other.m_RendererID = 0;
+    }
+    return *this;
 }
 
 Shader::~Shader() {
-    GLCall(glDeleteProgram(m_RendererID));
+    DeletionQueue::DeleteProgram(m_RendererID);
 }
 
 void Shader::Bind() const {
@@ -39,6 +71,18 @@ void Shader::SetUniformMat4f(const std::string& name, const glm::mat4& matrix) {
     GLCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &matrix[0][0]));
 }
 
+void Shader::SetUniformBlockBinding(const std::string& name, unsigned int binding) {
+    if (m_Spirv) {
+        return;
+    }
+    GLCall(unsigned int index = glGetUniformBlockIndex(m_RendererID, name.c_str()));
+    if (index == GL_INVALID_INDEX) {
+        std::cout << "Warning: uniform block '" << name << "' doesn't exist!" << std::endl;
+        return;
+    }
+    GLCall(glUniformBlockBinding(m_RendererID, index, binding));
+}
+
 // Private Methods
 
 unsigned int Shader::GetUniformLocation(const std::string& name) {
@@ -59,24 +103,111 @@ unsigned int Shader::GetUniformLocation(const std::string& name) {
     }
 }
 
-unsigned int Shader::CreateShader(const std::string& vertexShader, const std::string& fragmentShader) {
-    unsigned int program = glCreateProgram();
-    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
-    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+PendingProgram Shader::BeginCreateShader(const std::string& vertexShader, const std::string& fragmentShader) {
+    PendingProgram pending;
+    GLCall(pending.Program = glCreateProgram());
+    pending.VertexShader = CompileShader(GL_VERTEX_SHADER, vertexShader);
+    pending.FragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+    pending.Spirv = false;
+
+    // Linking straight away is fine even if compilation failed, the error surfaces in FinishShader
+    GLCall(glAttachShader(pending.Program, pending.VertexShader));
+    GLCall(glAttachShader(pending.Program, pending.FragmentShader));
+    GLCall(glLinkProgram(pending.Program));
+
+    return pending;
+}
+
+PendingProgram Shader::BeginCreateShader(const ShaderProgramSource& source, unsigned int keywordMask) {
+    if (!UsesSpirv(source)) {
+        return BeginCreateShader(InjectKeywords(source.VertexSource, source.Keywords, keywordMask),
+                                 InjectKeywords(source.FragmentSource, source.Keywords, keywordMask));
+    }
+
+#ifdef EMBEDDED_SHADERS_SPIRV
+    PendingProgram pending;
+    GLCall(pending.Program = glCreateProgram());
+    unsigned int keywordCount = (unsigned int)source.Keywords.size();
+    pending.VertexShader = SpecializeShader(GL_VERTEX_SHADER, source.VertexSpirv, keywordCount, keywordMask);
+    pending.FragmentShader = SpecializeShader(GL_FRAGMENT_SHADER, source.FragmentSpirv, keywordCount, keywordMask);
+    pending.Spirv = true;
+
+    GLCall(glAttachShader(pending.Program, pending.VertexShader));
+    GLCall(glAttachShader(pending.Program, pending.FragmentShader));
+    GLCall(glLinkProgram(pending.Program));
+
+    return pending;
+#else
+    ASSERT(false);
+    return PendingProgram();
+#endif
+}
+
+bool Shader::UsesSpirv(const ShaderProgramSource& source) {
+#ifdef EMBEDDED_SHADERS_SPIRV
+    return !source.VertexSpirv.empty() && !source.FragmentSpirv.empty() && (GLEW_VERSION_4_6 || GLEW_ARB_gl_spirv);
+#else
+    // Built without modules, see tools/embed_shaders.py --spirv
+    (void)source;
+    return false;
+#endif
+}
+
+bool Shader::IsProgramReady(const PendingProgram& pending) {
+    if (!GLEW_KHR_parallel_shader_compile) {
+        return true;
+    }
+    int completed;
+    GLCall(glGetProgramiv(pending.Program, GL_COMPLETION_STATUS_KHR, &completed));
+    return completed == GL_TRUE;
+}
+
+unsigned int Shader::FinishShader(const PendingProgram& pending) {
+    bool compiled = CheckCompileStatus(pending.VertexShader, GL_VERTEX_SHADER);
+    compiled = CheckCompileStatus(pending.FragmentShader, GL_FRAGMENT_SHADER) && compiled;
 
-    GLCall(glAttachShader(program, vs));
-    GLCall(glAttachShader(program, fs));
-    GLCall(glLinkProgram(program));
-    GLCall(glValidateProgram(program));
+    int linked;
+    GLCall(glGetProgramiv(pending.Program, GL_LINK_STATUS, &linked));
+    if (compiled && linked == GL_FALSE) {
+        int length;
+        GLCall(glGetProgramiv(pending.Program, GL_INFO_LOG_LENGTH, &length));
+        char* message = (char*)alloca(length * sizeof(char));
+        GLCall(glGetProgramInfoLog(pending.Program, length, &length, message));
+        std::cout << "Failed to link shader " << m_FilePath << std::endl;
+        std::cout << message << std::endl;
+    }
+    GLCall(glValidateProgram(pending.Program));
 
-    GLCall(glDeleteShader(vs));
-    GLCall(glDeleteShader(fs));
+    GLCall(glDeleteShader(pending.VertexShader));
+    GLCall(glDeleteShader(pending.FragmentShader));
 
-    return program;
+    return pending.Program;
 }
 
 ShaderProgramSource Shader::ParseShader(const std::string& filepath) {
+    // Shaders validated and embedded at build time skip the file entirely
+    for (const EmbeddedShader& embedded : s_EmbeddedShaders) {
+        if (filepath == embedded.Filepath) {
+            ShaderProgramSource source;
+            source.VertexSource = embedded.VertexSource;
+            source.FragmentSource = embedded.FragmentSource;
+#ifdef EMBEDDED_SHADERS_SPIRV
+            source.VertexSpirv.assign(embedded.VertexSpirv, embedded.VertexSpirv + embedded.VertexSpirvWords);
+            source.FragmentSpirv.assign(embedded.FragmentSpirv, embedded.FragmentSpirv + embedded.FragmentSpirvWords);
+#endif
+            std::stringstream keywords(embedded.Keywords);
+            std::string keyword;
+            while (keywords >> keyword) {
+                source.Keywords.push_back(keyword);
+            }
+            return source;
+        }
+    }
+
     std::ifstream stream(filepath);
+    if (!stream) {
+        std::cout << "Failed to open shader " << filepath << std::endl;
+    }
 
     enum class ShaderType {
         NONE = -1, VERTEX = 0, FRAGMENT = 1
@@ -86,8 +217,17 @@ ShaderProgramSource Shader::ParseShader(const std::string& filepath) {
     std::string line;
     std::stringstream ss[2];
 
+    ShaderProgramSource source;
+
     while (getline(stream, line)) {
-        if (line.find("#shader") != std::string::npos) {
+        if (line.find("#keywords") != std::string::npos) {
+            std::stringstream keywords(line.substr(line.find("#keywords") + 9));
+            std::string keyword;
+            while (keywords >> keyword) {
+                source.Keywords.push_back(keyword);
+            }
+        }
+        else if (line.find("#shader") != std::string::npos) {
             if (line.find("vertex") != std::string::npos) {
                 // set mode to vertex
                 type = ShaderType::VERTEX;
@@ -97,24 +237,75 @@ ShaderProgramSource Shader::ParseShader(const std::string& filepath) {
                 type = ShaderType::FRAGMENT;
             }
         }
-        else {
+        else if (type != ShaderType::NONE) {
             ss[int(type)] << line << '\n';
         }
     }
 
-    ShaderProgramSource source;
     source.VertexSource = ss[int(ShaderType::VERTEX)].str();
     source.FragmentSource = ss[int(ShaderType::FRAGMENT)].str();
 
     return source; // Could also do { ss[0].str(), ss[1].str() } but keeping the above since more readable over time imo
 }
 
+std::string Shader::InjectKeywords(const std::string& source, const std::vector<std::string>& keywords, unsigned int keywordMask) {
+    if (keywords.empty()) {
+        return source;
+    }
+
+    // #version has to stay the first statement, so keywords go on the line right after it
+    std::string block;
+    for (unsigned int i = 0; i < keywords.size(); i++) {
+        block += "const bool " + keywords[i] + ((keywordMask & (1u << i)) ? " = true;\n" : " = false;\n");
+    }
+
+    size_t version = source.find("#version");
+    if (version == std::string::npos) {
+        return block + source;
+    }
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == std::string::npos) {
+        return source + '\n' + block;
+    }
+    std::string result = source;
+    result.insert(lineEnd + 1, block);
+    return result;
+}
+
 unsigned int Shader::CompileShader(unsigned int type, const std::string& source) {
     GLCall(unsigned int id = glCreateShader(type));
     const char* src = source.c_str(); // OpenGL expects source string in this format
     GLCall(glShaderSource(id, 1, &src, nullptr));
     GLCall(glCompileShader(id));
+    // Status isn't queried here, doing so would wait on the compiler and serialize every program in a batch
+    return id;
+}
+
+#ifdef EMBEDDED_SHADERS_SPIRV
+unsigned int Shader::SpecializeShader(unsigned int type, const std::vector<unsigned int>& spirv, unsigned int keywordCount, unsigned int keywordMask) {
+    GLCall(unsigned int id = glCreateShader(type));
+    GLCall(glShaderBinary(1, &id, GL_SHADER_BINARY_FORMAT_SPIR_V, spirv.data(), (GLsizei)(spirv.size() * sizeof(unsigned int))));
+
+    // Keyword i was declared as layout(constant_id = i) const bool when the module was built
+    std::vector<unsigned int> indices(keywordCount);
+    std::vector<unsigned int> values(keywordCount);
+    for (unsigned int i = 0; i < keywordCount; i++) {
+        indices[i] = i;
+        values[i] = (keywordMask & (1u << i)) ? GL_TRUE : GL_FALSE;
+    }
 
+    if (GLEW_VERSION_4_6) {
+        GLCall(glSpecializeShader(id, "main", keywordCount, indices.data(), values.data()));
+    }
+    else {
+        GLCall(glSpecializeShaderARB(id, "main", keywordCount, indices.data(), values.data()));
+    }
+    // Specialization sets GL_COMPILE_STATUS, so FinishShader checks it the same way as GLSL
+    return id;
+}
+#endif
+
+bool Shader::CheckCompileStatus(unsigned int id, unsigned int type) {
     int result;
     GLCall(glGetShaderiv(id, GL_COMPILE_STATUS, &result));
     if (result == GL_FALSE) {
@@ -125,9 +316,8 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
         GLCall(glGetShaderInfoLog(id, length, &length, message));
         std::cout << "Failed to compile shader " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << std::endl;
         std::cout << message << std::endl;
-        GLCall(glDeleteShader(id));
-        return 0;
+        return false;
     }
 
-    return id;
+    return true;
 }
\ No newline at end of file
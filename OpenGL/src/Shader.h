@@ -1,20 +1,46 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <unordered_map>
 #include "glm/glm.hpp"
 
 struct ShaderProgramSource {
 	std::string VertexSource;
 	std::string FragmentSource;
+	std::vector<std::string> Keywords; // Declared with "#keywords A B C", bit i of a variant mask enables Keywords[i]
+	// Offline compiled modules (ARB_gl_spirv), empty unless embedded by tools/embed_shaders.py --spirv, which
+	// is also what compiles the SPIR-V path in. Keyword i is specialization constant i, so every variant is
+	// specialized from the same module.
+	std::vector<unsigned int> VertexSpirv;
+	std::vector<unsigned int> FragmentSpirv;
+};
+
+// Program whose compile and link have been issued but not yet checked. Nothing here is queried
+// until it's turned into a Shader, which lets the driver overlap compilation across many programs.
+struct PendingProgram {
+	unsigned int Program;
+	unsigned int VertexShader;
+	unsigned int FragmentShader;
+	bool Spirv;
 };
 
 class Shader {
 private:
 	std::string m_FilePath;
 	unsigned int m_RendererID;
+	bool m_Spirv;
 	std::unordered_map<std::string, int> m_UniformLocationCache;
 public:
 	Shader(const std::string& filepath);
+	// Builds a single permutation, from SPIR-V when the source and driver allow it, else from GLSL
+	Shader(const std::string& filepath, const ShaderProgramSource& source, unsigned int keywordMask);
+	// Adopts a program from BeginCreateShader, blocks if the driver hasn't finished it yet
+	Shader(const std::string& filepath, const PendingProgram& pending);
+	// Move only, the moved from shader owns no program
+	Shader(Shader&& other);
+	Shader& operator=(Shader&& other);
+	Shader(const Shader&) = delete;
+	Shader& operator=(const Shader&) = delete;
 	~Shader();
 
 	void Bind() const;
@@ -25,10 +51,27 @@ public:
 	void SetUniform1f(const std::string& name, float value);
 	void SetUniform4f(const std::string& name, float v0, float v1, float f2, float f3);
 	void SetUniformMat4f(const std::string& name, const glm::mat4& matrix);
+	// Points the named uniform block at an indexed GL_UNIFORM_BUFFER binding.
+	// SPIR-V programs have no names to look up, their bindings come from layout(binding = N) in the source.
+	void SetUniformBlockBinding(const std::string& name, unsigned int binding);
+
+	// Uses the build-time embedded copy when there is one (see tools/embed_shaders.py), else reads the file
+	static ShaderProgramSource ParseShader(const std::string& filepath);
+	// Declares every keyword as "const bool KEYWORD = true/false;" after #version. Shaders branch with
+	// if (KEYWORD), which the compiler folds away, and which works unchanged on specialization constants.
+	static std::string InjectKeywords(const std::string& source, const std::vector<std::string>& keywords, unsigned int keywordMask);
+	static bool UsesSpirv(const ShaderProgramSource& source);
+
+	static PendingProgram BeginCreateShader(const std::string& vertexShader, const std::string& fragmentShader);
+	static PendingProgram BeginCreateShader(const ShaderProgramSource& source, unsigned int keywordMask);
+	// Without GL_KHR_parallel_shader_compile there's no way to ask without blocking, so it always reports ready
+	static bool IsProgramReady(const PendingProgram& pending);
 
 private:
 	unsigned int GetUniformLocation(const std::string& name);
-	unsigned int CompileShader(unsigned int type, const std::string& source);
-	unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
-	ShaderProgramSource ParseShader(const std::string& filepath);
+	static unsigned int CompileShader(unsigned int type, const std::string& source);
+	// Only defined when EmbeddedShaders.h has modules
+	static unsigned int SpecializeShader(unsigned int type, const std::vector<unsigned int>& spirv, unsigned int keywordCount, unsigned int keywordMask);
+	static bool CheckCompileStatus(unsigned int id, unsigned int type);
+	unsigned int FinishShader(const PendingProgram& pending);
 };
\ No newline at end of file
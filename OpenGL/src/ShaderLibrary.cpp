@@ -0,0 +1,302 @@
+#include "ShaderLibrary.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <utility>
+#include "Renderer.h"
+#include "ThreadPool.h"
+#include <GLFW/glfw3.h>
+
+ShaderLibrary* ShaderLibrary::s_Instance = nullptr;
+
+ShaderLibrary::ShaderLibrary() : m_WarmUpContext(nullptr) {
+    ASSERT(s_Instance == nullptr);
+    s_Instance = this;
+}
+
+ShaderLibrary::~ShaderLibrary() {
+    WaitForWarmUp();
+    if (m_WarmUpContext) {
+        glfwDestroyWindow(m_WarmUpContext);
+    }
+    s_Instance = nullptr;
+}
+
+std::shared_ptr<Shader> ShaderLibrary::GetShader(const std::string& filepath, unsigned int keywordMask) {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    ShaderFamily& family = GetFamily(filepath);
+    std::string key = VariantKey(filepath, keywordMask);
+
+    // Batch programs live on this thread, so finishing one here just blocks until the driver is done with it
+    auto inFlight = m_InFlight.find(key);
+    if (inFlight != m_InFlight.end()) {
+        return FinishInFlight(inFlight);
+    }
+
+    // If the warm-up thread is already building this variant, waiting is cheaper than compiling it twice
+    m_VariantReady.wait(lock, [&]() { return m_Pending.find(key) == m_Pending.end(); });
+
+    auto found = family.Variants.find(keywordMask);
+    if (found != family.Variants.end()) {
+        return found->second;
+    }
+
+    // Variant wasn't warmed up, this is the hitch the warm-up list is meant to avoid next run
+    std::cout << "Compiling shader variant on demand: " << key << std::endl;
+    m_Pending.insert(key);
+    lock.unlock();
+
+    std::shared_ptr<Shader> shader = std::make_shared<Shader>(filepath, family.Source, keywordMask);
+
+    lock.lock();
+    family.Variants[keywordMask] = shader;
+    m_Pending.erase(key);
+    m_VariantReady.notify_all();
+    return shader;
+}
+
+std::shared_ptr<Shader> ShaderLibrary::GetShader(const std::string& filepath, const std::vector<std::string>& keywords) {
+    return GetShader(filepath, GetKeywordMask(filepath, keywords));
+}
+
+unsigned int ShaderLibrary::GetKeywordMask(const std::string& filepath, const std::vector<std::string>& keywords) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const std::vector<std::string>& declared = GetFamily(filepath).Source.Keywords;
+
+    unsigned int mask = 0;
+    for (const std::string& keyword : keywords) {
+        auto found = std::find(declared.begin(), declared.end(), keyword);
+        if (found == declared.end()) {
+            std::cout << "Warning: keyword '" << keyword << "' isn't declared in " << filepath << std::endl;
+            continue;
+        }
+        mask |= 1u << (found - declared.begin());
+    }
+    return mask;
+}
+
+void ShaderLibrary::SaveWarmUpList(const std::string& listPath) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::ofstream stream(listPath);
+
+    auto writeVariant = [&](const std::string& filepath, unsigned int keywordMask) {
+        stream << filepath;
+        for (const std::string& keyword : GetEnabledKeywords(m_Families.at(filepath), keywordMask)) {
+            stream << ' ' << keyword;
+        }
+        stream << '\n';
+    };
+
+    // Keep everything that's been compiled, warmed up or not, so a variant stays listed across runs
+    for (const auto& family : m_Families) {
+        for (const auto& variant : family.second.Variants) {
+            writeVariant(family.first, variant.first);
+        }
+    }
+    for (const auto& inFlight : m_InFlight) {
+        writeVariant(inFlight.second.Filepath, inFlight.second.KeywordMask);
+    }
+}
+
+void ShaderLibrary::StartWarmUp(const std::string& listPath, GLFWwindow* window) {
+    VariantList variants = LoadVariantList(listPath);
+    if (variants.empty() || m_WarmUpThread.joinable()) {
+        return;
+    }
+
+    // Driver already compiles off-thread, no need for a second context
+    if (GLEW_KHR_parallel_shader_compile) {
+        CompileBatch(variants);
+        return;
+    }
+
+    // Hidden 1x1 window purely for its context, programs are shared objects so they're usable from window's context
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_WarmUpContext = glfwCreateWindow(1, 1, "", nullptr, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!m_WarmUpContext) {
+        std::cout << "Warning: couldn't create a shared context, shader warm-up skipped" << std::endl;
+        return;
+    }
+
+    m_WarmUpThread = std::thread(&ShaderLibrary::WarmUp, this, std::move(variants));
+}
+
+void ShaderLibrary::WaitForWarmUp() {
+    if (m_WarmUpThread.joinable()) {
+        m_WarmUpThread.join();
+    }
+}
+
+void ShaderLibrary::CompileBatch(const VariantList& variants) {
+    // Files are parsed once each, in parallel, before anything needs their keyword lists
+    std::vector<std::pair<std::string, std::future<ShaderProgramSource>>> parsing;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        std::unordered_set<std::string> seen;
+        for (const auto& variant : variants) {
+            const std::string& filepath = variant.first;
+            if (m_Families.find(filepath) == m_Families.end() && seen.insert(filepath).second) {
+                parsing.push_back({ filepath, ThreadPool::Get().Submit([filepath]() { return Shader::ParseShader(filepath); }) });
+            }
+        }
+    }
+    for (auto& parsed : parsing) {
+        ShaderFamily family{};
+        family.Source = parsed.second.get();
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Families.insert({ parsed.first, std::move(family) });
+    }
+
+    struct Preprocessed {
+        std::string Filepath;
+        unsigned int KeywordMask;
+        const ShaderProgramSource* Source;
+        std::future<std::pair<std::string, std::string>> Sources; // Not set for SPIR-V, there's nothing to preprocess
+    };
+    std::vector<Preprocessed> preprocessing;
+    std::unordered_set<std::string> queued;
+    for (const auto& variant : variants) {
+        unsigned int keywordMask = GetKeywordMask(variant.first, variant.second);
+        std::string key = VariantKey(variant.first, keywordMask);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ShaderFamily& family = GetFamily(variant.first);
+        if (family.Variants.find(keywordMask) != family.Variants.end() || m_Pending.find(key) != m_Pending.end() ||
+            m_InFlight.find(key) != m_InFlight.end() || !queued.insert(key).second) {
+            continue;
+        }
+
+        // Family entries are never erased, so the pointer outlives the job
+        const ShaderProgramSource* source = &family.Source;
+        Preprocessed entry{};
+        entry.Filepath = variant.first;
+        entry.KeywordMask = keywordMask;
+        entry.Source = source;
+        preprocessing.push_back(std::move(entry));
+        if (!Shader::UsesSpirv(*source)) {
+            preprocessing.back().Sources = ThreadPool::Get().Submit([source, keywordMask]() {
+                return std::make_pair(Shader::InjectKeywords(source->VertexSource, source->Keywords, keywordMask),
+                                      Shader::InjectKeywords(source->FragmentSource, source->Keywords, keywordMask));
+            });
+        }
+    }
+
+    if (GLEW_KHR_parallel_shader_compile) {
+        // 0xFFFFFFFF lets the implementation pick how many threads to use
+        GLCall(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+    }
+
+    for (Preprocessed& variant : preprocessing) {
+        PendingProgram pending;
+        if (variant.Sources.valid()) {
+            std::pair<std::string, std::string> sources = variant.Sources.get();
+            pending = Shader::BeginCreateShader(sources.first, sources.second);
+        }
+        else {
+            pending = Shader::BeginCreateShader(*variant.Source, variant.KeywordMask);
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_InFlight.insert({ VariantKey(variant.Filepath, variant.KeywordMask), InFlightProgram{ variant.Filepath, variant.KeywordMask, pending } });
+    }
+}
+
+void ShaderLibrary::PollBatch() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto inFlight = m_InFlight.begin(); inFlight != m_InFlight.end();) {
+        auto next = std::next(inFlight);
+        if (Shader::IsProgramReady(inFlight->second.Pending)) {
+            FinishInFlight(inFlight);
+        }
+        inFlight = next;
+    }
+}
+
+ShaderLibrary::VariantList ShaderLibrary::LoadVariantList(const std::string& listPath) {
+    std::ifstream stream(listPath);
+    VariantList variants;
+    std::string line;
+
+    while (getline(stream, line)) {
+        std::stringstream ss(line);
+        std::string filepath, keyword;
+        if (!(ss >> filepath)) {
+            continue;
+        }
+        std::vector<std::string> keywords;
+        while (ss >> keyword) {
+            keywords.push_back(keyword);
+        }
+        variants.push_back({ filepath, keywords });
+    }
+    return variants;
+}
+
+// Private Methods
+
+ShaderLibrary::ShaderFamily& ShaderLibrary::GetFamily(const std::string& filepath) {
+    auto found = m_Families.find(filepath);
+    if (found == m_Families.end()) {
+        ShaderFamily family{};
+        family.Source = Shader::ParseShader(filepath);
+        found = m_Families.insert({ filepath, std::move(family) }).first;
+        ASSERT(found->second.Source.Keywords.size() <= sizeof(unsigned int) * 8);
+    }
+    return found->second;
+}
+
+std::vector<std::string> ShaderLibrary::GetEnabledKeywords(const ShaderFamily& family, unsigned int keywordMask) const {
+    std::vector<std::string> keywords;
+    for (unsigned int i = 0; i < family.Source.Keywords.size(); i++) {
+        if (keywordMask & (1u << i)) {
+            keywords.push_back(family.Source.Keywords[i]);
+        }
+    }
+    return keywords;
+}
+
+// Expects m_Mutex to be held
+std::shared_ptr<Shader> ShaderLibrary::FinishInFlight(std::unordered_map<std::string, InFlightProgram>::iterator inFlight) {
+    const InFlightProgram& program = inFlight->second;
+    std::shared_ptr<Shader> shader = std::make_shared<Shader>(program.Filepath, program.Pending);
+    GetFamily(program.Filepath).Variants[program.KeywordMask] = shader;
+    m_InFlight.erase(inFlight);
+    return shader;
+}
+
+void ShaderLibrary::WarmUp(VariantList variants) {
+    glfwMakeContextCurrent(m_WarmUpContext);
+
+    for (const auto& variant : variants) {
+        const std::string& filepath = variant.first;
+        unsigned int keywordMask = GetKeywordMask(filepath, variant.second);
+        std::string key = VariantKey(filepath, keywordMask);
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        ShaderFamily& family = GetFamily(filepath);
+        if (family.Variants.find(keywordMask) != family.Variants.end() || m_Pending.find(key) != m_Pending.end() ||
+            m_InFlight.find(key) != m_InFlight.end()) {
+            continue;
+        }
+        m_Pending.insert(key);
+        lock.unlock();
+
+        std::shared_ptr<Shader> shader = std::make_shared<Shader>(filepath, family.Source, keywordMask);
+        // Program has to be fully built before another context may use it
+        GLCall(glFinish());
+
+        lock.lock();
+        family.Variants[keywordMask] = shader;
+        m_Pending.erase(key);
+        m_VariantReady.notify_all();
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+std::string ShaderLibrary::VariantKey(const std::string& filepath, unsigned int keywordMask) {
+    return filepath + '#' + std::to_string(keywordMask);
+}
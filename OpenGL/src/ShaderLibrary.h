@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "Shader.h"
+
+struct GLFWwindow;
+
+// Owns every compiled shader permutation. A .shader file declares its keywords with "#keywords A B C"
+// and a variant is requested through a bitmask over that list, bit i enabling Keywords[i].
+// Variants are built lazily on first request and cached by (filepath, mask).
+class ShaderLibrary {
+public:
+	// (filepath, enabled keywords) per variant
+	using VariantList = std::vector<std::pair<std::string, std::vector<std::string>>>;
+private:
+	struct ShaderFamily {
+		ShaderProgramSource Source;
+		std::unordered_map<unsigned int, std::shared_ptr<Shader>> Variants;
+	};
+
+	struct InFlightProgram {
+		std::string Filepath;
+		unsigned int KeywordMask;
+		PendingProgram Pending;
+	};
+
+	std::unordered_map<std::string, ShaderFamily> m_Families;
+	std::unordered_set<std::string> m_Pending; // Variants currently compiling on either thread, keyed by VariantKey
+	std::unordered_map<std::string, InFlightProgram> m_InFlight; // Issued by CompileBatch, not yet checked, keyed by VariantKey
+	std::mutex m_Mutex;
+	std::condition_variable m_VariantReady;
+
+	GLFWwindow* m_WarmUpContext;
+	std::thread m_WarmUpThread;
+
+	static ShaderLibrary* s_Instance;
+public:
+	ShaderLibrary();
+	~ShaderLibrary();
+
+	static ShaderLibrary& Get() { return *s_Instance; }
+
+	std::shared_ptr<Shader> GetShader(const std::string& filepath, unsigned int keywordMask = 0);
+	std::shared_ptr<Shader> GetShader(const std::string& filepath, const std::vector<std::string>& keywords);
+	unsigned int GetKeywordMask(const std::string& filepath, const std::vector<std::string>& keywords);
+
+	// Warm-up list is one variant per line: "<filepath> KEYWORD KEYWORD ...".
+	// Keywords are stored by name so reordering a #keywords line doesn't invalidate old lists.
+	void SaveWarmUpList(const std::string& listPath);
+	// Compiles every variant in the list in the background. Uses CompileBatch when the driver compiles in parallel,
+	// otherwise a worker thread with a hidden context sharing objects with window.
+	// Must be called from the main thread since GLFW only creates windows there.
+	void StartWarmUp(const std::string& listPath, GLFWwindow* window);
+	void WaitForWarmUp();
+
+	// Parses and preprocesses every variant on the thread pool, then issues all compiles and links back to back
+	// without querying anything in between. With GL_KHR_parallel_shader_compile the driver works through them
+	// on its own threads and PollBatch picks up finished programs. Main thread only.
+	void CompileBatch(const VariantList& variants);
+	// Call once a frame, adopts every batch program the driver reports as complete
+	void PollBatch();
+
+	static VariantList LoadVariantList(const std::string& listPath);
+
+private:
+	ShaderFamily& GetFamily(const std::string& filepath);
+	std::vector<std::string> GetEnabledKeywords(const ShaderFamily& family, unsigned int keywordMask) const;
+	void WarmUp(VariantList variants);
+	std::shared_ptr<Shader> FinishInFlight(std::unordered_map<std::string, InFlightProgram>::iterator inFlight);
+
+	static std::string VariantKey(const std::string& filepath, unsigned int keywordMask);
+};
@@ -0,0 +1,79 @@
+#include "SpriteAtlas.h"
+
+#include <utility>
+
+SpriteAtlas::SpriteAtlas(int pageSize, int padding) : m_Builder(pageSize, padding) {
+    m_Pages = std::make_unique<TextureArray>(m_Builder.GetPageSize(), m_Builder.GetPageSize(), 1, m_Builder.GetMipCount());
+}
+
+SpriteAtlas::SpriteAtlas(std::unique_ptr<AtlasBuilder::Table> table, std::unique_ptr<TextureArray> pages)
+    : m_Builder(table->PageSize, 0), m_Pages(std::move(pages)), m_Table(std::move(table)) {
+    for (int i = 0; i < (int)m_Table->Names.size(); i++) {
+        m_Names[m_Table->Names[i]] = i;
+    }
+}
+
+SpriteAtlas::~SpriteAtlas() {
+}
+
+std::unique_ptr<SpriteAtlas> SpriteAtlas::Load(const std::string& tablePath) {
+    std::unique_ptr<AtlasBuilder::Table> table = std::make_unique<AtlasBuilder::Table>();
+    if (!AtlasBuilder::ReadTable(tablePath, *table)) {
+        return nullptr;
+    }
+    // Page files are relative to the table
+    std::string directory = tablePath.substr(0, tablePath.find_last_of("/\\") + 1);
+    std::vector<std::string> pagePaths;
+    for (const std::string& file : table->PageFiles) {
+        pagePaths.push_back(directory + file);
+    }
+    std::unique_ptr<TextureArray> pages = TextureArray::LoadCooked(pagePaths);
+    if (!pages || pages->GetWidth() != table->PageSize) {
+        return nullptr;
+    }
+    return std::unique_ptr<SpriteAtlas>(new SpriteAtlas(std::move(table), std::move(pages)));
+}
+
+int SpriteAtlas::Add(int width, int height, const unsigned char* rgba) {
+    ASSERT(!m_Table);
+    return m_Builder.Add(width, height, rgba);
+}
+
+void SpriteAtlas::Upload() {
+    if (m_Table) {
+        return;
+    }
+    // Only the images packed since the last call go to GL, so the cost follows what was added, not the page size
+    for (int page = 0; page < m_Builder.GetPageCount(); page++) {
+        const std::vector<AtlasBuilder::Rect>& rects = m_Builder.GetDirtyRects(page);
+        if (rects.empty()) {
+            continue;
+        }
+        if (page >= m_Pages->GetLayerCount()) {
+            // Pages are never removed, so the array hands out layers in the same order the builder opens pages
+            int layer = m_Pages->AddEmpty();
+            ASSERT(layer == page);
+        }
+        for (const AtlasBuilder::Rect& rect : rects) {
+            m_Pages->SetLayerRegion(page, m_Builder.GetPage(page), rect.X, rect.Y, rect.Width, rect.Height);
+        }
+    }
+    m_Builder.ClearDirty();
+}
+
+void SpriteAtlas::Bind(unsigned int slot) const {
+    m_Pages->Bind(slot);
+}
+
+int SpriteAtlas::Find(const std::string& name) const {
+    auto found = m_Names.find(name);
+    return found == m_Names.end() ? -1 : found->second;
+}
+
+const AtlasBuilder::Region& SpriteAtlas::GetRegion(int index) const {
+    return m_Table ? m_Table->Regions[index] : m_Builder.GetRegion(index);
+}
+
+int SpriteAtlas::GetRegionCount() const {
+    return m_Table ? (int)m_Table->Regions.size() : (int)m_Builder.GetRegions().size();
+}
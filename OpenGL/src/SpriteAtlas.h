@@ -0,0 +1,43 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "AtlasBuilder.h"
+#include "TextureArray.h"
+
+// Atlas of sprites drawn from one TextureArray, each page is a layer so every sprite in it draws with a single
+// bind, layer = region Page and the region's UVs. Either packed while the game runs, Add only packs on the CPU
+// and Upload sends what was packed since, so a burst of adds costs one upload. Or cooked by TextureCooker
+// --atlas and loaded whole with Load, its sprites then looked up by the name they were cooked under.
+class SpriteAtlas {
+private:
+	AtlasBuilder m_Builder;
+	std::unique_ptr<TextureArray> m_Pages;
+	// Set for cooked atlases, which get their regions from the table and can't be added to
+	std::unique_ptr<AtlasBuilder::Table> m_Table;
+	std::unordered_map<std::string, int> m_Names; // Region index of every cooked sprite
+public:
+	SpriteAtlas(int pageSize = 1024, int padding = 4);
+	~SpriteAtlas();
+
+	// Reads the .atlas table and its pages, which sit next to it. Returns null if any of them can't be read
+	static std::unique_ptr<SpriteAtlas> Load(const std::string& tablePath);
+
+	// rgba is width * height RGBA8 texels with the bottom row first, returns the region index or -1 if it's too big
+	int Add(int width, int height, const unsigned char* rgba);
+	// Render thread, before drawing with anything added since the last call. Each new image is sent as its own
+	// rect with mips filtered from it alone, pages stop at the levels the padding keeps from bleeding
+	void Upload();
+	void Bind(unsigned int slot = 0) const;
+
+	// Region index of a cooked sprite, -1 if there's none by that name
+	int Find(const std::string& name) const;
+	const AtlasBuilder::Region& GetRegion(int index) const;
+	int GetRegionCount() const;
+
+	inline int GetPageCount() const { return m_Table ? (int)m_Table->PageFiles.size() : m_Builder.GetPageCount(); }
+	inline bool IsCooked() const { return m_Table != nullptr; }
+	inline TextureArray& GetTextureArray() { return *m_Pages; }
+private:
+	SpriteAtlas(std::unique_ptr<AtlasBuilder::Table> table, std::unique_ptr<TextureArray> pages);
+};
@@ -0,0 +1,159 @@
+#include "StaticGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "Renderer.h"
+#include "VertexArrayCache.h"
+
+static StaticGeometry::Bounds GetMeshBounds(const StaticMesh& mesh) {
+    StaticGeometry::Bounds bounds = { glm::vec3(INFINITY), glm::vec3(-INFINITY) };
+    for (const StaticVertex& vertex : mesh.Vertices) {
+        bounds.Min = glm::min(bounds.Min, vertex.Position);
+        bounds.Max = glm::max(bounds.Max, vertex.Position);
+    }
+    return bounds;
+}
+
+StaticGeometry::StaticGeometry(float cellSize) : m_CellSize(cellSize), m_Stats() {
+    ASSERT(cellSize > 0.0f);
+}
+
+StaticGeometry::~StaticGeometry() {
+}
+
+StaticGeometry::Bounds StaticGeometry::TransformBounds(const Bounds& bounds, const glm::mat4& transform) {
+    Bounds result = { glm::vec3(INFINITY), glm::vec3(-INFINITY) };
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec3 point(corner & 1 ? bounds.Max.x : bounds.Min.x, corner & 2 ? bounds.Max.y : bounds.Min.y,
+                        corner & 4 ? bounds.Max.z : bounds.Min.z);
+        glm::vec3 transformed = glm::vec3(transform * glm::vec4(point, 1.0f));
+        result.Min = glm::min(result.Min, transformed);
+        result.Max = glm::max(result.Max, transformed);
+    }
+    return result;
+}
+
+StaticGeometry::ObjectHandle StaticGeometry::Add(std::shared_ptr<const StaticMesh> mesh, const glm::mat4& transform, unsigned int material) {
+    ASSERT(mesh && !mesh->Vertices.empty());
+    Bounds bounds = TransformBounds(GetMeshBounds(*mesh), transform);
+    glm::ivec3 cell = glm::ivec3(glm::floor((bounds.Min + bounds.Max) * 0.5f / m_CellSize));
+    ObjectHandle handle = m_Objects.Create(Object{ std::move(mesh), transform, bounds, material, cell });
+
+    BatchEntry& entry = m_Batches[{ material, cell.x, cell.y, cell.z }];
+    entry.Baked.Material = material;
+    entry.Baked.Cell = cell;
+    entry.Objects.push_back(handle);
+    entry.Dirty = true;
+    return handle;
+}
+
+void StaticGeometry::Remove(ObjectHandle object) {
+    const Object* found = m_Objects.Get(object);
+    if (!found) {
+        return;
+    }
+    auto entry = m_Batches.find({ found->Material, found->Cell.x, found->Cell.y, found->Cell.z });
+    ASSERT(entry != m_Batches.end());
+    std::vector<ObjectHandle>& objects = entry->second.Objects;
+    auto position = std::find(objects.begin(), objects.end(), object);
+    ASSERT(position != objects.end());
+    *position = objects.back();
+    objects.pop_back();
+    entry->second.Dirty = true;
+    m_Objects.Destroy(object);
+}
+
+void StaticGeometry::Rebuild() {
+    bool created = false;
+    for (auto entry = m_Batches.begin(); entry != m_Batches.end();) {
+        if (!entry->second.Dirty) {
+            entry++;
+            continue;
+        }
+        if (entry->second.Objects.empty()) {
+            entry = m_Batches.erase(entry);
+            continue;
+        }
+        created |= !entry->second.Baked.Vertices;
+        Bake(entry->second);
+        entry++;
+    }
+    // Creating an index buffer binds it to whichever VAO is bound
+    if (created && VertexArrayCache::Exists()) {
+        VertexArrayCache::Get().Invalidate();
+    }
+}
+
+void StaticGeometry::Bake(BatchEntry& entry) {
+    m_Vertices.clear();
+    m_Indices.clear();
+    Bounds bounds = { glm::vec3(INFINITY), glm::vec3(-INFINITY) };
+    for (ObjectHandle handle : entry.Objects) {
+        const Object& object = m_Objects[handle];
+        unsigned int base = (unsigned int)m_Vertices.size();
+        for (StaticVertex vertex : object.Mesh->Vertices) {
+            vertex.Position = glm::vec3(object.Transform * glm::vec4(vertex.Position, 1.0f));
+            m_Vertices.push_back(vertex);
+        }
+        for (unsigned int index : object.Mesh->Indices) {
+            m_Indices.push_back(base + index);
+        }
+        bounds.Min = glm::min(bounds.Min, object.WorldBounds.Min);
+        bounds.Max = glm::max(bounds.Max, object.WorldBounds.Max);
+    }
+
+    Batch& batch = entry.Baked;
+    unsigned int vertexBytes = (unsigned int)(m_Vertices.size() * sizeof(StaticVertex));
+    if (!batch.Vertices) {
+        batch.Vertices = std::make_unique<VertexBuffer>(m_Vertices.data(), vertexBytes);
+        batch.Indices = std::make_unique<IndexBuffer>(m_Indices.data(), (unsigned int)m_Indices.size());
+    }
+    else {
+        // Keeps the buffer names, so the VAO cache doesn't have to build anything for the batch again
+        batch.Vertices->Reallocate(m_Vertices.data(), vertexBytes);
+        batch.Indices->Reallocate(m_Indices.data(), (unsigned int)m_Indices.size());
+    }
+    batch.WorldBounds = bounds;
+    entry.Dirty = false;
+    m_Stats.BatchesRebuilt++;
+    m_Stats.VerticesBaked += (unsigned int)m_Vertices.size();
+}
+
+void StaticGeometry::Cull(const glm::mat4& viewProjection, std::vector<const Batch*>& visible) const {
+    // Clip planes as row 3 plus or minus rows 0 to 2, inside where the dot product is positive
+    glm::vec4 planes[6];
+    for (int axis = 0; axis < 3; axis++) {
+        glm::vec4 row(viewProjection[0][axis], viewProjection[1][axis], viewProjection[2][axis], viewProjection[3][axis]);
+        glm::vec4 w(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+        planes[axis * 2] = w + row;
+        planes[axis * 2 + 1] = w - row;
+    }
+
+    for (const auto& entry : m_Batches) {
+        const Batch& batch = entry.second.Baked;
+        if (!batch.Vertices || entry.second.Objects.empty()) {
+            continue;
+        }
+        bool inside = true;
+        for (const glm::vec4& plane : planes) {
+            // The corner furthest along the plane's normal, if that's outside the whole box is
+            glm::vec3 corner(plane.x >= 0.0f ? batch.WorldBounds.Max.x : batch.WorldBounds.Min.x,
+                             plane.y >= 0.0f ? batch.WorldBounds.Max.y : batch.WorldBounds.Min.y,
+                             plane.z >= 0.0f ? batch.WorldBounds.Max.z : batch.WorldBounds.Min.z);
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+                inside = false;
+                break;
+            }
+        }
+        if (inside) {
+            visible.push_back(&batch);
+        }
+    }
+}
+
+void StaticGeometry::Draw(const Batch& batch, const Shader& shader) const {
+    VertexArrayCache::Get().Bind(*batch.Vertices, batch.Indices.get(), STATIC_VERTEX_LAYOUT);
+    Renderer renderer;
+    renderer.Draw(*batch.Indices, shader);
+}
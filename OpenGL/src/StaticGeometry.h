@@ -0,0 +1,115 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include "glm/glm.hpp"
+#include "ResourcePool.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "VertexBufferLayout.h"
+
+// What every static mesh is baked into. Basic.shader's attributes in order
+struct StaticVertex {
+	glm::vec3 Position;
+	glm::vec2 TexCoord;
+	glm::vec4 Color;
+};
+
+// What batches are drawn with, and what to bind a StaticMesh's own vertices with to draw it unbaked
+static constexpr auto STATIC_VERTEX_LAYOUT = MakeVertexLayout<StaticVertex>(
+	VERTEX_ATTRIBUTE(StaticVertex, Position),
+	VERTEX_ATTRIBUTE(StaticVertex, TexCoord),
+	VERTEX_ATTRIBUTE(StaticVertex, Color));
+
+// In local space, shared by every object placed with it
+struct StaticMesh {
+	std::vector<StaticVertex> Vertices;
+	std::vector<unsigned int> Indices; // Triangles
+};
+
+// Objects that never move, pre-transformed into world space and merged into one vertex and index buffer per
+// material and grid cell, so a scene of thousands of them draws in a handful of calls. Each object goes in
+// the cell holding the center of its bounds, and each batch keeps the bounds of all its objects, which may
+// reach past the cell, for culling. Adding or removing an object only marks its batch, Rebuild then bakes
+// the marked batches again and leaves the rest alone.
+// Materials are whatever the caller makes of them, batches come out of Cull sorted by material so its
+// state only has to be set once per material.
+class StaticGeometry {
+public:
+	struct Bounds {
+		glm::vec3 Min;
+		glm::vec3 Max;
+	};
+
+	struct Batch {
+		unsigned int Material;
+		glm::ivec3 Cell;
+		Bounds WorldBounds;
+		std::unique_ptr<VertexBuffer> Vertices; // Null until first baked
+		std::unique_ptr<IndexBuffer> Indices;
+	};
+
+	struct Stats {
+		unsigned int BatchesRebuilt;
+		unsigned int VerticesBaked;
+	};
+private:
+	struct Object {
+		std::shared_ptr<const StaticMesh> Mesh;
+		glm::mat4 Transform;
+		Bounds WorldBounds;
+		unsigned int Material;
+		glm::ivec3 Cell;
+	};
+public:
+	typedef ResourceHandle<Object> ObjectHandle;
+private:
+	struct BatchKey {
+		unsigned int Material;
+		int X, Y, Z;
+
+		bool operator<(const BatchKey& other) const {
+			return std::tie(Material, X, Y, Z) < std::tie(other.Material, other.X, other.Y, other.Z);
+		}
+	};
+
+	struct BatchEntry {
+		Batch Baked;
+		std::vector<ObjectHandle> Objects;
+		bool Dirty;
+	};
+
+	float m_CellSize;
+	ResourcePool<Object> m_Objects;
+	std::map<BatchKey, BatchEntry> m_Batches; // Material first, so iterating groups materials together
+	std::vector<StaticVertex> m_Vertices; // Scratch for baking
+	std::vector<unsigned int> m_Indices;
+	Stats m_Stats;
+public:
+	// cellSize is the world size of a grid cell along each axis. Larger cells mean fewer, bigger draws and
+	// coarser culling
+	StaticGeometry(float cellSize);
+	~StaticGeometry();
+
+	ObjectHandle Add(std::shared_ptr<const StaticMesh> mesh, const glm::mat4& transform, unsigned int material);
+	void Remove(ObjectHandle object);
+	// Bakes the batches changed since the last call, dropping the ones left empty
+	void Rebuild();
+
+	// Appends the batches whose bounds touch the view, sorted by material
+	void Cull(const glm::mat4& viewProjection, std::vector<const Batch*>& visible) const;
+	// Binds through VertexArrayCache, with shader and the material's state already set up. Positions are in
+	// world space, so the model matrix should be identity
+	void Draw(const Batch& batch, const Shader& shader) const;
+
+	inline unsigned int GetObjectCount() const { return m_Objects.GetCount(); }
+	inline unsigned int GetBatchCount() const { return (unsigned int)m_Batches.size(); }
+	inline const Stats& GetStats() const { return m_Stats; }
+	inline void ResetStats() { m_Stats = {}; }
+
+	// Box around the transformed corners of bounds
+	static Bounds TransformBounds(const Bounds& bounds, const glm::mat4& transform);
+private:
+	void Bake(BatchEntry& entry);
+};
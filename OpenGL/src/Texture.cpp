@@ -1,37 +1,375 @@
 #include "Texture.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include "TextureLoader.h"
+#include "TextureResidency.h"
+#include "DeletionQueue.h"
+#include "CookedTexture.h"
+#include "ImageOps.h"
 #include "stb_image/stb_image.h"
 #define DESIRED_CHANNELS 4 // Representation of number of bit channels RGBA
 
-Texture::Texture(const std::string& path) : m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr),
-											m_Width(0), m_Height(0), m_BPP(0) {
-	stbi_set_flip_vertically_on_load(1);
-	m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, DESIRED_CHANNELS);
+static bool IsCompressed(unsigned int internalFormat) {
+	return internalFormat != GL_RGBA8 && internalFormat != GL_RG8;
+}
 
-	GLCall(glGenTextures(1, &m_RendererID));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+static unsigned int GetLevelSize(unsigned int internalFormat, int width, int height) {
+	switch (internalFormat) {
+		case GL_RGBA8:
+			return width * height * 4;
+		case GL_RG8:
+			return width * height * 2;
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RED_RGTC1:
+			return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+		default:
+			return ((width + 3) / 4) * ((height + 3) / 4) * 16;
+	}
+}
+
+Texture::Texture(const std::string& path) : m_RendererID(0), m_FilePath(path), m_Width(0), m_Height(0), m_BPP(0),
+											m_InternalFormat(GL_RGBA8), m_MipCount(1), m_ResidentLevel(0), m_ResidentBytes(0), m_SamplerID(SamplerCache::Get().GetSampler(SamplerState())),
+											m_Loader(nullptr), m_Residency(nullptr), m_LastUsedFrame(0), m_Premultiplied(false) {
+	Track();
+	if (LoadCooked(path)) {
+		return;
+	}
+
+	// Decoded straight into a buffer of the right size rather than into stb_image's own allocation and copied over
+	std::vector<unsigned char> pixels;
+	if (stbi_info(path.c_str(), &m_Width, &m_Height, &m_BPP)) {
+		pixels.resize((size_t)m_Width * m_Height * DESIRED_CHANNELS);
+	}
+	if (pixels.empty() || !stbi_load_into(path.c_str(), pixels.data(), pixels.size(), &m_Width, &m_Height, &m_BPP, DESIRED_CHANNELS)) {
+		// Immutable storage can't be empty, the placeholder stands in instead
+		std::cout << "Failed to load texture " << path << ": " << stbi_failure_reason() << std::endl;
+		m_Width = m_Height = 0;
+		return;
+	}
 
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	// Flipped here rather than by stb_image, across the thread pool
+	ImageOps::FlipVertical(pixels.data(), m_Width, m_Height);
 
-	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer));
+	int mipCount = ImageOps::GetMipCount(m_Width, m_Height);
+	unsigned int rendererID = CreateStorage(GL_RGBA8, m_Width, m_Height, mipCount);
+	UploadLevels(pixels.data());
 	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	Adopt(rendererID, GL_RGBA8, mipCount);
+}
+
+Texture::Texture(const std::string& path, TextureLoader& loader) : m_RendererID(0), m_FilePath(path), m_Width(0), m_Height(0), m_BPP(0),
+																	m_InternalFormat(GL_RGBA8), m_MipCount(1), m_ResidentLevel(0), m_ResidentBytes(0), m_SamplerID(SamplerCache::Get().GetSampler(SamplerState())),
+																	m_Loader(&loader), m_Residency(nullptr), m_LastUsedFrame(0), m_Premultiplied(false) {
+	Track();
+	if (LoadCooked(path)) {
+		m_Loader = nullptr;
+		return;
+	}
+
+	// The loader creates the texture object once it knows the image size
+	loader.Enqueue(this);
+}
+
+Texture::Texture(int width, int height, const unsigned char* rgba) : m_RendererID(0), m_Width(width), m_Height(height), m_BPP(4),
+																	m_InternalFormat(GL_RGBA8), m_MipCount(1), m_ResidentLevel(0), m_ResidentBytes(0), m_SamplerID(SamplerCache::Get().GetSampler(SamplerState())),
+																	m_Loader(nullptr), m_Residency(nullptr), m_LastUsedFrame(0), m_Premultiplied(false) {
+	Track();
+	int mipCount = ImageOps::GetMipCount(m_Width, m_Height);
+	unsigned int rendererID = CreateStorage(GL_RGBA8, m_Width, m_Height, mipCount);
+	UploadLevels(rgba);
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	Adopt(rendererID, GL_RGBA8, mipCount);
+}
+
+Texture::Texture(int width, int height, const unsigned char* rgba, BlockCompression::Format format, BlockCompression::Quality quality)
+	: m_RendererID(0), m_Width(width), m_Height(height), m_BPP(4),
+	  m_InternalFormat(GL_RGBA8), m_MipCount(1), m_ResidentLevel(0), m_ResidentBytes(0), m_SamplerID(SamplerCache::Get().GetSampler(SamplerState())),
+	  m_Loader(nullptr), m_Residency(nullptr), m_LastUsedFrame(0), m_Premultiplied(false) {
+	Track();
+	int mipCount = ImageOps::GetMipCount(m_Width, m_Height);
+	unsigned int rendererID = CreateStorage(BlockCompression::GetGLFormat(format), m_Width, m_Height, mipCount);
+	UploadCompressed(rgba, format, quality);
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	Adopt(rendererID, BlockCompression::GetGLFormat(format), mipCount);
+}
+
+Texture::Texture(Texture&& other) {
+	MoveFrom(other);
+}
 
-	if (m_LocalBuffer) {
-		stbi_image_free(m_LocalBuffer);
+Texture& Texture::operator=(Texture&& other) {
+	if (this != &other) {
+		Release();
+		MoveFrom(other);
 	}
+	return *this;
 }
 
 Texture::~Texture() {
-	GLCall(glDeleteTextures(1, &m_RendererID));
+	Release();
+}
+
+void Texture::MoveFrom(Texture& other) {
+	m_RendererID = other.m_RendererID;
+	m_FilePath = std::move(other.m_FilePath);
+	m_Width = other.m_Width;
+	m_Height = other.m_Height;
+	m_BPP = other.m_BPP;
+	m_InternalFormat = other.m_InternalFormat;
+	m_MipCount = other.m_MipCount;
+	m_ResidentLevel = other.m_ResidentLevel;
+	m_ResidentBytes = other.m_ResidentBytes;
+	m_SamplerID = other.m_SamplerID;
+	m_Loader = other.m_Loader;
+	m_Residency = other.m_Residency;
+	m_LastUsedFrame = other.m_LastUsedFrame;
+	m_Premultiplied = other.m_Premultiplied;
+	if (m_Loader) {
+		m_Loader->Retarget(&other, this);
+	}
+	if (m_Residency) {
+		m_Residency->Unregister(&other);
+		m_Residency->Register(this);
+	}
+
+	other.m_RendererID = 0;
+	other.m_ResidentBytes = 0;
+	other.m_Loader = nullptr;
+	other.m_Residency = nullptr;
+}
+
+void Texture::Release() {
+	if (m_Loader) {
+		m_Loader->Cancel(this);
+		m_Loader = nullptr;
+	}
+	if (m_Residency) {
+		m_Residency->Unregister(this);
+		m_Residency = nullptr;
+	}
+	DeletionQueue::DeleteTexture(m_RendererID);
+	m_RendererID = 0;
+	m_ResidentBytes = 0;
 }
 
 void Texture::Bind(unsigned int slot) const {
+	if (m_Residency) {
+		m_LastUsedFrame = m_Residency->GetFrame();
+	}
 	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GLCall(glBindSampler(slot, m_SamplerID));
+	// Nothing on the GPU while loading, evicted or after a failed load, the loader's placeholder stands in when there is one
+	unsigned int placeholderID = TextureLoader::Exists() ? TextureLoader::Get().GetPlaceholderID() : 0;
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID ? m_RendererID : placeholderID));
 }
 
 void Texture::UnBind() const {
 	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
 }
+
+void Texture::SetSampler(const SamplerState& state) {
+	m_SamplerID = SamplerCache::Get().GetSampler(state);
+}
+
+void Texture::Compress(BlockCompression::Format format, BlockCompression::Quality quality) {
+	ASSERT(IsLoaded() && IsResident());
+	std::vector<unsigned char> pixels((size_t)m_Width * m_Height * 4);
+
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GLCall(glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	int mipCount = ImageOps::GetMipCount(m_Width, m_Height);
+	unsigned int rendererID = CreateStorage(BlockCompression::GetGLFormat(format), m_Width, m_Height, mipCount);
+	UploadCompressed(pixels.data(), format, quality);
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	Adopt(rendererID, BlockCompression::GetGLFormat(format), mipCount);
+}
+
+bool Texture::LoadCooked(const std::string& path) {
+	const std::string extension = ".gltex";
+	if (path.size() < extension.size() || path.compare(path.size() - extension.size(), extension.size(), extension) != 0) {
+		return false;
+	}
+
+	std::ifstream stream(path, std::ios::binary);
+	CookedTextureHeader header;
+	if (!stream.read((char*)&header, sizeof(header)) || memcmp(header.Magic, COOKED_TEXTURE_MAGIC, 4) != 0 ||
+		header.Version != COOKED_TEXTURE_VERSION || !IsCookedTextureFormat(header.GLFormat) || header.Width == 0 || header.Height == 0 ||
+		header.MipCount == 0 || (int)header.MipCount > ImageOps::GetMipCount(header.Width, header.Height)) {
+		std::cout << "Failed to load cooked texture " << path << std::endl;
+		return false;
+	}
+
+	m_Width = header.Width;
+	m_Height = header.Height;
+	m_BPP = 4;
+	m_Premultiplied = (header.Flags & COOKED_PREMULTIPLIED_ALPHA) != 0;
+
+	unsigned int rendererID = CreateStorage(header.GLFormat, m_Width, m_Height, header.MipCount);
+	int mipCount = header.MipCount;
+
+	// Levels come in largest first and the rows are already bottom-up, so they go straight to GL
+	std::vector<char> data;
+	int width = m_Width, height = m_Height;
+	for (unsigned int level = 0; level < header.MipCount; level++) {
+		unsigned int size = 0;
+		stream.read((char*)&size, sizeof(size));
+		data.resize(size);
+		if (!stream.read(data.data(), size)) {
+			std::cout << "Cooked texture " << path << " is truncated at mip " << level << std::endl;
+			mipCount = std::max(1, (int)level);
+			GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipCount - 1));
+			break;
+		}
+
+		if (header.GLFormat == GL_RGBA8) {
+			GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data.data()));
+		}
+		else {
+			GLCall(glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, header.GLFormat, size, data.data()));
+		}
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	Adopt(rendererID, header.GLFormat, mipCount);
+
+	return true;
+}
+
+void Texture::UploadLevels(const unsigned char* rgba) {
+	// Filtered here rather than by glGenerateMipmap, across the thread pool and averaged in linear space
+	// whatever the driver would have done
+	std::vector<std::vector<unsigned char>> mips = ImageOps::GenerateMips(rgba, m_Width, m_Height, ImageOps::MipFilter::Kaiser, true);
+	GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, rgba));
+	for (unsigned int level = 1; level <= mips.size(); level++) {
+		GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, std::max(1, m_Width >> level), std::max(1, m_Height >> level),
+							   GL_RGBA, GL_UNSIGNED_BYTE, mips[level - 1].data()));
+	}
+}
+
+void Texture::UploadCompressed(const unsigned char* rgba, BlockCompression::Format format, BlockCompression::Quality quality) {
+	// Two channel formats hold normals or other linear data
+	bool srgb = format != BlockCompression::Format::BC5;
+	std::vector<std::vector<unsigned char>> mips = ImageOps::GenerateMips(rgba, m_Width, m_Height, ImageOps::MipFilter::Kaiser, srgb);
+
+	std::vector<unsigned char> blocks;
+	for (unsigned int level = 0; level <= mips.size(); level++) {
+		int width = std::max(1, m_Width >> level), height = std::max(1, m_Height >> level);
+		blocks.resize(BlockCompression::GetCompressedSize(format, width, height));
+		BlockCompression::CompressImageParallel(format, level == 0 ? rgba : mips[level - 1].data(), width, height, blocks.data(), quality);
+		GLCall(glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, BlockCompression::GetGLFormat(format),
+										 (GLsizei)blocks.size(), blocks.data()));
+	}
+}
+
+void Texture::Adopt(unsigned int rendererID, unsigned int internalFormat, int mipCount, int firstLevel) {
+	DeletionQueue::DeleteTexture(m_RendererID);
+	m_RendererID = rendererID;
+	m_InternalFormat = internalFormat;
+	m_MipCount = mipCount;
+	m_ResidentLevel = firstLevel;
+
+	m_ResidentBytes = 0;
+	if (m_RendererID) {
+		for (int level = firstLevel; level < mipCount; level++) {
+			m_ResidentBytes += GetLevelSize(internalFormat, std::max(1, m_Width >> level), std::max(1, m_Height >> level));
+		}
+	}
+}
+
+bool Texture::Evict(int maxSize) {
+	// Reloading streams through the loader, without one an evicted texture could never come back
+	if (m_FilePath.empty() || m_Loader || !IsResident() || !TextureLoader::Exists()) {
+		return false;
+	}
+
+	int firstLevel = 0;
+	while (firstLevel < m_MipCount - 1 && std::max(m_Width >> firstLevel, m_Height >> firstLevel) > maxSize) {
+		firstLevel++;
+	}
+	if (std::max(m_Width >> firstLevel, m_Height >> firstLevel) > maxSize) {
+		// No mips small enough to keep, the placeholder stands in until the reload finishes
+		Adopt(0, m_InternalFormat, m_MipCount, m_MipCount);
+		return true;
+	}
+
+	// The small levels are copied out through client memory, a stall on a few KB in exchange for freeing the rest
+	std::vector<std::vector<unsigned char>> levels;
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	for (int level = firstLevel; level < m_MipCount; level++) {
+		levels.emplace_back(GetLevelSize(m_InternalFormat, std::max(1, m_Width >> level), std::max(1, m_Height >> level)));
+		if (m_InternalFormat == GL_RGBA8) {
+			GLCall(glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE, levels.back().data()));
+		}
+		else {
+			GLCall(glGetCompressedTexImage(GL_TEXTURE_2D, level, levels.back().data()));
+		}
+	}
+
+	unsigned int rendererID = CreateStorage(m_InternalFormat, std::max(1, m_Width >> firstLevel), std::max(1, m_Height >> firstLevel),
+											m_MipCount - firstLevel);
+	for (int level = firstLevel; level < m_MipCount; level++) {
+		int width = std::max(1, m_Width >> level), height = std::max(1, m_Height >> level);
+		const std::vector<unsigned char>& data = levels[level - firstLevel];
+		if (m_InternalFormat == GL_RGBA8) {
+			GLCall(glTexSubImage2D(GL_TEXTURE_2D, level - firstLevel, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data.data()));
+		}
+		else {
+			GLCall(glCompressedTexSubImage2D(GL_TEXTURE_2D, level - firstLevel, 0, 0, width, height, m_InternalFormat, (GLsizei)data.size(), data.data()));
+		}
+	}
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	Adopt(rendererID, m_InternalFormat, m_MipCount, firstLevel);
+	return true;
+}
+
+void Texture::Reload() {
+	if (LoadCooked(m_FilePath)) {
+		return;
+	}
+	// Keeps drawing with the low mips until the full chain has streamed in and replaces them
+	m_Loader = &TextureLoader::Get();
+	m_Loader->Enqueue(this);
+}
+
+void Texture::Track() {
+	if (TextureResidency::Exists()) {
+		m_Residency = &TextureResidency::Get();
+		m_Residency->Register(this);
+		// Counts as used on creation, otherwise it's fair game for eviction before it's ever drawn
+		m_LastUsedFrame = m_Residency->GetFrame();
+	}
+}
+
+unsigned int Texture::CreateStorage(unsigned int internalFormat, int width, int height, int mipCount) {
+	unsigned int rendererID;
+	GLCall(glGenTextures(1, &rendererID));
+	GLCall(glBindTexture(GL_TEXTURE_2D, rendererID));
+
+	// Immutable storage is allocated and validated once, the driver never has to check the chain is complete on draw
+	if (GLEW_ARB_texture_storage) {
+		GLCall(glTexStorage2D(GL_TEXTURE_2D, mipCount, internalFormat, width, height));
+		return rendererID;
+	}
+
+	// Same layout out of mutable levels for 3.3 drivers without it, capped so the chain counts as complete
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipCount - 1));
+	for (int level = 0; level < mipCount; level++) {
+		int levelWidth = std::max(1, width >> level), levelHeight = std::max(1, height >> level);
+		if (!IsCompressed(internalFormat)) {
+			GLCall(glTexImage2D(GL_TEXTURE_2D, level, internalFormat, levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+		}
+		else {
+			GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, levelWidth, levelHeight, 0,
+										  GetLevelSize(internalFormat, levelWidth, levelHeight), nullptr));
+		}
+	}
+	return rendererID;
+}
@@ -1,19 +1,81 @@
 #pragma once
 #include "Renderer.h"
+#include "BlockCompression.h"
+#include "SamplerCache.h"
+
+class TextureLoader;
+class TextureResidency;
 
 class Texture {
 private:
-	unsigned int m_RendererID;
+	unsigned int m_RendererID; // 0 while nothing is on the GPU yet, Bind uses the loader's placeholder then
 	std::string m_FilePath;
-	unsigned char* m_LocalBuffer;
 	int m_Width, m_Height, m_BPP; // Bits per pixel
+	unsigned int m_InternalFormat; // GL_RGBA8 or a compressed format
+	int m_MipCount; // Levels in the full resolution chain
+	int m_ResidentLevel; // First level of the full chain that's on the GPU, 0 unless evicted
+	unsigned int m_ResidentBytes;
+	unsigned int m_SamplerID; // Shared with every texture sampled the same way, owned by SamplerCache
+	TextureLoader* m_Loader; // Set while an async load is still streaming in, Bind uses the placeholder until then
+	TextureResidency* m_Residency; // Set while tracked against the VRAM budget
+	mutable unsigned long long m_LastUsedFrame;
+	bool m_Premultiplied;
+
+	friend class TextureLoader;
+	friend class TextureResidency;
 public:
 	Texture(const std::string& path);
+	// Returns straight away, decoding happens on the thread pool and the upload is spread over TextureLoader::Update.
+	// Cooked .gltex files are loaded in place since there's nothing to decode.
+	Texture(const std::string& path, TextureLoader& loader);
+	// Runtime content like procedural textures or user uploads, rgba is width * height RGBA8 texels with the bottom row first
+	Texture(int width, int height, const unsigned char* rgba);
+	// Same, block compressed across the thread pool before upload for a quarter to an eighth of the memory
+	Texture(int width, int height, const unsigned char* rgba, BlockCompression::Format format,
+			BlockCompression::Quality quality = BlockCompression::Quality::Fast);
+	// Move only. A texture still loading or tracked for residency is handed over to the new object
+	Texture(Texture&& other);
+	Texture& operator=(Texture&& other);
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
 	~Texture();
 
 	void Bind(unsigned int slot = 0) const;
 	void UnBind() const;
+	// Trilinear and clamped to the edge until changed
+	void SetSampler(const SamplerState& state);
+	// Reads level 0 back and replaces it with a block compressed copy, for textures whose contents were drawn on the GPU.
+	// Stalls until the GPU is done writing the texture, the mips are rebuilt from level 0
+	void Compress(BlockCompression::Format format, BlockCompression::Quality quality = BlockCompression::Quality::Fast);
 
 	inline int GetWidth() const { return m_Width; }
 	inline int GetHeight() const { return m_Height; }
+	inline bool IsLoaded() const { return m_Loader == nullptr; }
+	// False while evicted down to its low mips, TextureResidency brings it back once it's bound again
+	inline bool IsResident() const { return m_ResidentLevel == 0; }
+	inline unsigned int GetResidentBytes() const { return m_ResidentBytes; }
+	// Cooked textures usually are, blend them with GL_ONE, GL_ONE_MINUS_SRC_ALPHA
+	inline bool IsPremultiplied() const { return m_Premultiplied; }
+
+	// Generates and binds a texture with room for mipCount levels, immutable when the driver has ARB_texture_storage.
+	// Sampling state lives in the sampler objects so nothing else is set on it. For classes managing their own texture objects
+	static unsigned int CreateStorage(unsigned int internalFormat, int width, int height, int mipCount);
+private:
+	// Loads a .gltex from TextureCooker, returns false if the file is missing or not a valid container
+	bool LoadCooked(const std::string& path);
+	// Fill a texture made by CreateStorage with rgba and its mip chain, expects it to be bound
+	void UploadLevels(const unsigned char* rgba);
+	void UploadCompressed(const unsigned char* rgba, BlockCompression::Format format, BlockCompression::Quality quality);
+	// Takes ownership of a complete texture object holding levels firstLevel and up of the full chain, replacing the current one
+	void Adopt(unsigned int rendererID, unsigned int internalFormat, int mipCount, int firstLevel = 0);
+	// Swaps the texture for its levels no larger than maxSize, or for nothing if it has none. Returns false if it
+	// can't be brought back later, because it didn't come from a file or there's no TextureLoader to stream it back in
+	bool Evict(int maxSize);
+	// Starts bringing an evicted texture back to full resolution
+	void Reload();
+	void Track();
+	// Takes every member from other and points the loader and residency at this instead
+	void MoveFrom(Texture& other);
+	// Stops loading and tracking and deletes the texture object
+	void Release();
 };
\ No newline at end of file
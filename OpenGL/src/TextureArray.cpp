@@ -0,0 +1,272 @@
+#include "TextureArray.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include "ImageOps.h"
+#include "DeletionQueue.h"
+#include "CookedTexture.h"
+
+// The full chain unless mipCount asks for fewer levels
+static int ClampMipCount(int width, int height, int mipCount) {
+    int full = ImageOps::GetMipCount(width, height);
+    return mipCount > 0 ? std::min(mipCount, full) : full;
+}
+
+TextureArray::TextureArray(int width, int height, int layerCapacity, int mipCount)
+    : m_RendererID(0), m_Width(width), m_Height(height), m_InternalFormat(GL_RGBA8), m_Compressed(false),
+      m_Format(BlockCompression::Format::BC1), m_Quality(BlockCompression::Quality::Fast), m_MipCount(ClampMipCount(width, height, mipCount)),
+      m_LayerCapacity(std::max(1, layerCapacity)), m_NextLayer(0), m_SamplerID(SamplerCache::Get().GetSampler(SamplerState())), m_Premultiplied(false) {
+    m_RendererID = CreateStorage(m_LayerCapacity);
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+TextureArray::TextureArray(int width, int height, BlockCompression::Format format, BlockCompression::Quality quality, int layerCapacity, int mipCount)
+    : m_RendererID(0), m_Width(width), m_Height(height), m_InternalFormat(BlockCompression::GetGLFormat(format)), m_Compressed(true),
+      m_Format(format), m_Quality(quality), m_MipCount(ClampMipCount(width, height, mipCount)),
+      m_LayerCapacity(std::max(1, layerCapacity)), m_NextLayer(0), m_SamplerID(SamplerCache::Get().GetSampler(SamplerState())), m_Premultiplied(false) {
+    m_RendererID = CreateStorage(m_LayerCapacity);
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+TextureArray::TextureArray(int width, int height, unsigned int internalFormat, int mipCount, int layerCapacity)
+    : m_RendererID(0), m_Width(width), m_Height(height), m_InternalFormat(internalFormat), m_Compressed(internalFormat != GL_RGBA8),
+      m_Format(BlockCompression::Format::BC1), m_Quality(BlockCompression::Quality::Fast), m_MipCount(mipCount),
+      m_LayerCapacity(std::max(1, layerCapacity)), m_NextLayer(0), m_SamplerID(SamplerCache::Get().GetSampler(SamplerState())), m_Premultiplied(false) {
+    // Only GetLevelSize reads the format of a cooked array
+    const BlockCompression::Format formats[] = { BlockCompression::Format::BC1, BlockCompression::Format::BC3, BlockCompression::Format::BC4,
+                                                 BlockCompression::Format::BC5, BlockCompression::Format::BC7 };
+    for (BlockCompression::Format format : formats) {
+        if (BlockCompression::GetGLFormat(format) == internalFormat) {
+            m_Format = format;
+        }
+    }
+    m_RendererID = CreateStorage(m_LayerCapacity);
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+TextureArray::~TextureArray() {
+    DeletionQueue::DeleteTexture(m_RendererID);
+}
+
+std::unique_ptr<TextureArray> TextureArray::LoadCooked(const std::vector<std::string>& paths) {
+    std::unique_ptr<TextureArray> array;
+    std::vector<char> data;
+    for (const std::string& path : paths) {
+        std::ifstream stream(path, std::ios::binary);
+        CookedTextureHeader header;
+        if (!stream.read((char*)&header, sizeof(header)) || memcmp(header.Magic, COOKED_TEXTURE_MAGIC, 4) != 0 ||
+            header.Version != COOKED_TEXTURE_VERSION || !IsCookedTextureFormat(header.GLFormat) || header.Width == 0 || header.Height == 0 ||
+            header.MipCount == 0 || (int)header.MipCount > ImageOps::GetMipCount(header.Width, header.Height)) {
+            std::cout << "Failed to load cooked texture " << path << std::endl;
+            return nullptr;
+        }
+
+        if (!array) {
+            array.reset(new TextureArray(header.Width, header.Height, header.GLFormat, header.MipCount, (int)paths.size()));
+            array->m_Premultiplied = (header.Flags & COOKED_PREMULTIPLIED_ALPHA) != 0;
+        }
+        else if ((int)header.Width != array->m_Width || (int)header.Height != array->m_Height || header.GLFormat != array->m_InternalFormat ||
+                 (int)header.MipCount != array->m_MipCount) {
+            std::cout << "Cooked texture " << path << " doesn't match the size, format or mips of " << paths[0] << std::endl;
+            return nullptr;
+        }
+
+        // Levels come in largest first and the rows are already bottom-up, so they go straight to GL
+        int layer = array->m_NextLayer++;
+        GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, array->m_RendererID));
+        for (int level = 0; level < array->m_MipCount; level++) {
+            unsigned int size = 0;
+            stream.read((char*)&size, sizeof(size));
+            data.resize(size);
+            if (!stream.read(data.data(), size) || size != array->GetLevelSize(level)) {
+                std::cout << "Cooked texture " << path << " is truncated at mip " << level << std::endl;
+                GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+                return nullptr;
+            }
+
+            int width = std::max(1, array->m_Width >> level), height = std::max(1, array->m_Height >> level);
+            if (array->m_Compressed) {
+                GLCall(glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, array->m_InternalFormat,
+                                                 (GLsizei)size, data.data()));
+            }
+            else {
+                GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data.data()));
+            }
+        }
+        GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+    }
+    return array;
+}
+
+int TextureArray::Add(const unsigned char* rgba) {
+    int layer = AllocateLayer();
+    SetLayer(layer, rgba);
+    return layer;
+}
+
+int TextureArray::AddEmpty() {
+    int layer = AllocateLayer();
+    // Level 0 is the largest, so one buffer of zeros covers every level
+    std::vector<unsigned char> zeros(GetLevelSize(0), 0);
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+    for (int level = 0; level < m_MipCount; level++) {
+        int width = std::max(1, m_Width >> level), height = std::max(1, m_Height >> level);
+        if (m_Compressed) {
+            GLCall(glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, m_InternalFormat,
+                                             (GLsizei)GetLevelSize(level), zeros.data()));
+        }
+        else {
+            GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, zeros.data()));
+        }
+    }
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+    return layer;
+}
+
+void TextureArray::SetLayer(int layer, const unsigned char* rgba) {
+    ASSERT(layer >= 0 && layer < m_NextLayer);
+    // Two channel formats hold normals or other linear data
+    bool srgb = !(m_Compressed && m_Format == BlockCompression::Format::BC5);
+    std::vector<std::vector<unsigned char>> mips = ImageOps::GenerateMips(rgba, m_Width, m_Height, ImageOps::MipFilter::Kaiser, srgb, m_MipCount);
+
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+    std::vector<unsigned char> blocks;
+    for (int level = 0; level < m_MipCount; level++) {
+        int width = std::max(1, m_Width >> level), height = std::max(1, m_Height >> level);
+        const unsigned char* pixels = level == 0 ? rgba : mips[level - 1].data();
+        if (m_Compressed) {
+            blocks.resize(GetLevelSize(level));
+            BlockCompression::CompressImageParallel(m_Format, pixels, width, height, blocks.data(), m_Quality);
+            GLCall(glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, m_InternalFormat,
+                                             (GLsizei)blocks.size(), blocks.data()));
+        }
+        else {
+            GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+        }
+    }
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+void TextureArray::SetLayerRegion(int layer, const unsigned char* rgba, int x, int y, int width, int height) {
+    ASSERT(layer >= 0 && layer < m_NextLayer);
+    // Compressed levels would also need every level's rect on the block grid
+    ASSERT(!m_Compressed);
+    int alignment = 1 << (m_MipCount - 1);
+    ASSERT(x % alignment == 0 && y % alignment == 0 && width % alignment == 0 && height % alignment == 0);
+    ASSERT(x >= 0 && y >= 0 && x + width <= m_Width && y + height <= m_Height);
+
+    std::vector<unsigned char> region((size_t)width * height * 4);
+    for (int row = 0; row < height; row++) {
+        memcpy(&region[(size_t)row * width * 4], rgba + ((size_t)(y + row) * m_Width + x) * 4, (size_t)width * 4);
+    }
+    std::vector<std::vector<unsigned char>> mips = ImageOps::GenerateMips(region.data(), width, height, ImageOps::MipFilter::Kaiser, true, m_MipCount);
+
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+    for (int level = 0; level < m_MipCount; level++) {
+        const unsigned char* pixels = level == 0 ? region.data() : mips[level - 1].data();
+        GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x >> level, y >> level, layer, width >> level, height >> level, 1,
+                               GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+    }
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+void TextureArray::Remove(int layer) {
+    ASSERT(layer >= 0 && layer < m_NextLayer);
+    ASSERT(std::find(m_FreeLayers.begin(), m_FreeLayers.end(), layer) == m_FreeLayers.end());
+    m_FreeLayers.push_back(layer);
+}
+
+void TextureArray::Bind(unsigned int slot) const {
+    GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+    GLCall(glBindSampler(slot, m_SamplerID));
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+}
+
+void TextureArray::UnBind() const {
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+void TextureArray::SetSampler(const SamplerState& state) {
+    m_SamplerID = SamplerCache::Get().GetSampler(state);
+}
+
+int TextureArray::AllocateLayer() {
+    if (!m_FreeLayers.empty()) {
+        int layer = m_FreeLayers.back();
+        m_FreeLayers.pop_back();
+        return layer;
+    }
+    if (m_NextLayer == m_LayerCapacity) {
+        Grow(m_LayerCapacity * 2);
+    }
+    return m_NextLayer++;
+}
+
+unsigned int TextureArray::GetLevelSize(int level) const {
+    int width = std::max(1, m_Width >> level), height = std::max(1, m_Height >> level);
+    return m_Compressed ? BlockCompression::GetCompressedSize(m_Format, width, height) : width * height * 4;
+}
+
+unsigned int TextureArray::CreateStorage(int layerCapacity) const {
+    unsigned int rendererID;
+    GLCall(glGenTextures(1, &rendererID));
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, rendererID));
+
+    if (GLEW_ARB_texture_storage) {
+        GLCall(glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_MipCount, m_InternalFormat, m_Width, m_Height, layerCapacity));
+        return rendererID;
+    }
+
+    // Mutable levels on 3.3 drivers without it, same as Texture::CreateStorage
+    GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_MipCount - 1));
+    for (int level = 0; level < m_MipCount; level++) {
+        int width = std::max(1, m_Width >> level), height = std::max(1, m_Height >> level);
+        if (m_Compressed) {
+            GLCall(glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, m_InternalFormat, width, height, layerCapacity, 0,
+                                          GetLevelSize(level) * layerCapacity, nullptr));
+        }
+        else {
+            GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, width, height, layerCapacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+        }
+    }
+    return rendererID;
+}
+
+void TextureArray::Grow(int layerCapacity) {
+    unsigned int rendererID = CreateStorage(layerCapacity);
+
+    if (GLEW_ARB_copy_image) {
+        // Stays on the GPU
+        for (int level = 0; level < m_MipCount; level++) {
+            GLCall(glCopyImageSubData(m_RendererID, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, rendererID, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+                                      std::max(1, m_Width >> level), std::max(1, m_Height >> level), m_NextLayer));
+        }
+    }
+    else {
+        // Round trip through client memory, a stall but growing is rare since the capacity doubles each time
+        std::vector<unsigned char> data;
+        for (int level = 0; level < m_MipCount; level++) {
+            int width = std::max(1, m_Width >> level), height = std::max(1, m_Height >> level);
+            data.resize((size_t)GetLevelSize(level) * m_LayerCapacity);
+            GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+            if (m_Compressed) {
+                GLCall(glGetCompressedTexImage(GL_TEXTURE_2D_ARRAY, level, data.data()));
+                GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, rendererID));
+                GLCall(glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, width, height, m_NextLayer, m_InternalFormat,
+                                                 GetLevelSize(level) * m_NextLayer, data.data()));
+            }
+            else {
+                GLCall(glGetTexImage(GL_TEXTURE_2D_ARRAY, level, GL_RGBA, GL_UNSIGNED_BYTE, data.data()));
+                GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, rendererID));
+                GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, width, height, m_NextLayer, GL_RGBA, GL_UNSIGNED_BYTE, data.data()));
+            }
+        }
+    }
+    GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+
+    DeletionQueue::DeleteTexture(m_RendererID);
+    m_RendererID = rendererID;
+    m_LayerCapacity = layerCapacity;
+}
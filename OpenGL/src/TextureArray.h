@@ -0,0 +1,73 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "Renderer.h"
+#include "BlockCompression.h"
+#include "SamplerCache.h"
+
+// Same size, same format textures stored as the layers of one GL_TEXTURE_2D_ARRAY. Draws that only differ in
+// which of them they sample can be batched into one, the shader picks the layer per vertex or per instance
+// (sampler2DArray, vec3(uv, layer)) instead of a texture being rebound between draws.
+// Add hands out layers, reusing removed ones first, and the array doubles its layers when it runs out.
+class TextureArray {
+private:
+	unsigned int m_RendererID;
+	int m_Width, m_Height;
+	unsigned int m_InternalFormat; // GL_RGBA8 or a compressed format
+	bool m_Compressed;
+	BlockCompression::Format m_Format;
+	BlockCompression::Quality m_Quality;
+	int m_MipCount;
+	int m_LayerCapacity;
+	int m_NextLayer; // Layers from here up have never been handed out
+	std::vector<int> m_FreeLayers; // Removed layers, handed out again before the array grows
+	unsigned int m_SamplerID;
+	bool m_Premultiplied;
+public:
+	// mipCount caps the chain, counting the base level, 0 for the full chain
+	TextureArray(int width, int height, int layerCapacity = 16, int mipCount = 0);
+	// Layers are block compressed across the thread pool as they're added
+	TextureArray(int width, int height, BlockCompression::Format format,
+				 BlockCompression::Quality quality = BlockCompression::Quality::Fast, int layerCapacity = 16, int mipCount = 0);
+	~TextureArray();
+
+	// One layer per .gltex from TextureCooker, in order. They must all have the same size, format and mip count,
+	// and go to GL as stored, so SetLayer and Add don't fit these. Returns null if any of them can't be read
+	static std::unique_ptr<TextureArray> LoadCooked(const std::vector<std::string>& paths);
+
+	// rgba is width * height RGBA8 texels with the bottom row first, returns the layer it went into.
+	// Growing copies every layer into a new array, so start with enough capacity when the count is known
+	int Add(const unsigned char* rgba);
+	// Hands out a layer the same way with every level zeroed, for filling in piece by piece with SetLayerRegion
+	int AddEmpty();
+	// Replaces the contents of a layer handed out by Add
+	void SetLayer(int layer, const unsigned char* rgba);
+	// Replaces one rect of an RGBA8 layer, rgba is the whole layer but only the rect is read. Its mips are filtered
+	// from the rect alone, so every side must be a multiple of 2^(mip count - 1) and nothing outside it changes
+	void SetLayerRegion(int layer, const unsigned char* rgba, int x, int y, int width, int height);
+	// Gives a layer back, it keeps its contents until Add hands it out again
+	void Remove(int layer);
+
+	void Bind(unsigned int slot = 0) const;
+	void UnBind() const;
+	// Trilinear and clamped to the edge until changed
+	void SetSampler(const SamplerState& state);
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline int GetLayerCount() const { return m_NextLayer - (int)m_FreeLayers.size(); }
+	inline int GetLayerCapacity() const { return m_LayerCapacity; }
+	// Cooked layers usually are, blend them with GL_ONE, GL_ONE_MINUS_SRC_ALPHA
+	inline bool IsPremultiplied() const { return m_Premultiplied; }
+private:
+	// Empty array for cooked layers of internalFormat
+	TextureArray(int width, int height, unsigned int internalFormat, int mipCount, int layerCapacity);
+
+	// Next free layer, growing the array if there's none
+	int AllocateLayer();
+	unsigned int GetLevelSize(int level) const;
+	// Generates and binds an array with room for layerCapacity layers of the full mip chain
+	unsigned int CreateStorage(int layerCapacity) const;
+	void Grow(int layerCapacity);
+};
@@ -0,0 +1,247 @@
+#include "TextureLoader.h"
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include "Texture.h"
+#include "ThreadPool.h"
+#include "ImageOps.h"
+#include "DeletionQueue.h"
+#include "stb_image/stb_image.h"
+
+TextureLoader* TextureLoader::s_Instance = nullptr;
+
+TextureLoader::TextureLoader(unsigned int bytesPerFrame, unsigned int pixelBufferSize)
+    : m_NextPixelBuffer(0), m_PixelBufferSize(pixelBufferSize), m_BytesPerFrame(bytesPerFrame), m_PlaceholderID(0) {
+    ASSERT(s_Instance == nullptr);
+    s_Instance = this;
+
+    GLCall(glGenBuffers(PIXEL_BUFFER_COUNT, m_PixelBuffers));
+    for (unsigned int i = 0; i < PIXEL_BUFFER_COUNT; i++) {
+        GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffers[i]));
+        GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, m_PixelBufferSize, nullptr, GL_STREAM_DRAW));
+    }
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+    // Single white texel, reads as "no texture" without breaking shaders that sample it
+    unsigned char white[4] = { 255, 255, 255, 255 };
+    m_PlaceholderID = Texture::CreateStorage(GL_RGBA8, 1, 1, 1);
+    GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white));
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+TextureLoader::~TextureLoader() {
+    for (Request& request : m_Requests) {
+        request.Target->m_Loader = nullptr;
+        m_Abandoned.push_back(std::move(request.Decoding));
+        GLCall(glDeleteTextures(1, &request.Destination));
+    }
+    // The workers use the pool, so they have to be done before it goes
+    for (std::future<DecodedImage>& decoding : m_Abandoned) {
+        if (decoding.valid()) {
+            decoding.wait();
+        }
+    }
+
+    GLCall(glDeleteBuffers(PIXEL_BUFFER_COUNT, m_PixelBuffers));
+    GLCall(glDeleteTextures(1, &m_PlaceholderID));
+    s_Instance = nullptr;
+}
+
+void TextureLoader::Enqueue(Texture* texture) {
+    std::string path = texture->m_FilePath;
+    Request request;
+    request.Target = texture;
+    request.Destination = 0;
+    request.Image = DecodedImage();
+    request.Decoded = false;
+    request.Level = 0;
+    request.RowsUploaded = 0;
+    request.Decoding = ThreadPool::Get().Submit([this, path]() {
+        DecodedImage image{};
+        int channels;
+        // Sized up front so the image decodes straight into a pooled buffer, rather than into an allocation
+        // of stb_image's own that would then be copied and freed
+        if (stbi_info(path.c_str(), &image.Width, &image.Height, &channels)) {
+            image.Pixels = AcquirePixels((size_t)image.Width * image.Height * 4);
+            if (!stbi_load_into(path.c_str(), image.Pixels.data(), image.Pixels.size(), &image.Width, &image.Height, &channels, 4)) {
+                ReleasePixels(image.Pixels);
+            }
+        }
+        if (image.Pixels.empty()) {
+            const char* reason = stbi_failure_reason();
+            image.FailureReason = reason ? reason : "unknown error";
+        }
+        // Already on a worker, so these run inline rather than fanning out again
+        else {
+            ImageOps::FlipVertical(image.Pixels.data(), image.Width, image.Height);
+            image.Mips = ImageOps::GenerateMips(image.Pixels.data(), image.Width, image.Height, ImageOps::MipFilter::Kaiser, true);
+        }
+        return image;
+    });
+    m_Requests.push_back(std::move(request));
+}
+
+void TextureLoader::Cancel(Texture* texture) {
+    for (auto request = m_Requests.begin(); request != m_Requests.end(); request++) {
+        if (request->Target == texture) {
+            if (request->Decoded) {
+                ReleasePixels(request->Image.Pixels);
+            }
+            else {
+                m_Abandoned.push_back(std::move(request->Decoding));
+            }
+            DeletionQueue::DeleteTexture(request->Destination);
+            m_Requests.erase(request);
+            return;
+        }
+    }
+}
+
+void TextureLoader::Retarget(Texture* from, Texture* to) {
+    for (Request& request : m_Requests) {
+        if (request.Target == from) {
+            request.Target = to;
+            return;
+        }
+    }
+}
+
+void TextureLoader::Update() {
+    for (auto decoding = m_Abandoned.begin(); decoding != m_Abandoned.end();) {
+        if (decoding->wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            DecodedImage image = decoding->get();
+            ReleasePixels(image.Pixels);
+            decoding = m_Abandoned.erase(decoding);
+        }
+        else {
+            decoding++;
+        }
+    }
+
+    unsigned int budget = m_BytesPerFrame;
+    for (auto request = m_Requests.begin(); request != m_Requests.end() && budget > 0;) {
+        if (!request->Decoded) {
+            if (request->Decoding.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                request++;
+                continue;
+            }
+            request->Image = request->Decoding.get();
+            request->Decoded = true;
+
+            Texture* texture = request->Target;
+            if (request->Image.Pixels.empty()) {
+                std::cout << "Failed to load texture " << texture->m_FilePath << ": " << request->Image.FailureReason << std::endl;
+                texture->m_Loader = nullptr;
+                request = m_Requests.erase(request);
+                continue;
+            }
+
+            texture->m_Width = request->Image.Width;
+            texture->m_Height = request->Image.Height;
+            texture->m_BPP = 4;
+
+            const DecodedImage& image = request->Image;
+            request->Destination = Texture::CreateStorage(GL_RGBA8, image.Width, image.Height, (int)image.Mips.size() + 1);
+        }
+
+        budget -= UploadRows(*request, budget);
+
+        if (request->Level > (int)request->Image.Mips.size()) {
+            Texture* texture = request->Target;
+            texture->Adopt(request->Destination, GL_RGBA8, (int)request->Image.Mips.size() + 1);
+            texture->m_Loader = nullptr;
+            ReleasePixels(request->Image.Pixels);
+            request = m_Requests.erase(request);
+        }
+    }
+
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+    // The pool is for bursts of loads, once nothing is decoding its buffers are just held memory
+    if (m_Requests.empty() && m_Abandoned.empty()) {
+        std::lock_guard<std::mutex> lock(m_PixelPoolMutex);
+        m_PixelPool.clear();
+    }
+}
+
+unsigned int TextureLoader::UploadRows(Request& request, unsigned int budget) {
+    const DecodedImage& image = request.Image;
+    unsigned int uploaded = 0;
+
+    GLCall(glBindTexture(GL_TEXTURE_2D, request.Destination));
+    while (request.Level <= (int)image.Mips.size() && uploaded < budget) {
+        int width = std::max(1, image.Width >> request.Level), height = std::max(1, image.Height >> request.Level);
+        const unsigned char* pixels = request.Level == 0 ? image.Pixels.data() : image.Mips[request.Level - 1].data();
+        unsigned int rowBytes = width * 4;
+        // Too wide for the staging buffers, those rows fall back to a plain client memory upload
+        bool staged = rowBytes <= m_PixelBufferSize;
+
+        unsigned int rows = std::min((unsigned int)(height - request.RowsUploaded), (budget - uploaded) / rowBytes);
+        if (staged) {
+            rows = std::min(rows, m_PixelBufferSize / rowBytes);
+        }
+        if (rows == 0) {
+            // Always make some progress, a single row wider than the budget still goes through on its own
+            if (uploaded > 0) {
+                break;
+            }
+            rows = 1;
+        }
+        unsigned int bytes = rows * rowBytes;
+        const unsigned char* source = pixels + (size_t)request.RowsUploaded * rowBytes;
+
+        if (!staged) {
+            GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+            GLCall(glTexSubImage2D(GL_TEXTURE_2D, request.Level, 0, request.RowsUploaded, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, source));
+        }
+        else {
+            // Invalidating lets the driver hand back fresh memory instead of waiting on the GPU's last read of this PBO
+            GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffers[m_NextPixelBuffer]));
+            m_NextPixelBuffer = (m_NextPixelBuffer + 1) % PIXEL_BUFFER_COUNT;
+            GLCall(void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+            memcpy(mapped, source, bytes);
+            GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+            GLCall(glTexSubImage2D(GL_TEXTURE_2D, request.Level, 0, request.RowsUploaded, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+        }
+
+        request.RowsUploaded += rows;
+        uploaded += bytes;
+        if (request.RowsUploaded == height) {
+            request.Level++;
+            request.RowsUploaded = 0;
+        }
+    }
+    return std::min(uploaded, budget);
+}
+
+std::vector<unsigned char> TextureLoader::AcquirePixels(size_t size) {
+    std::vector<unsigned char> pixels;
+    {
+        std::lock_guard<std::mutex> lock(m_PixelPoolMutex);
+        auto best = m_PixelPool.end();
+        for (auto buffer = m_PixelPool.begin(); buffer != m_PixelPool.end(); buffer++) {
+            if (buffer->capacity() >= size && (best == m_PixelPool.end() || buffer->capacity() < best->capacity())) {
+                best = buffer;
+            }
+        }
+        if (best != m_PixelPool.end()) {
+            pixels = std::move(*best);
+            m_PixelPool.erase(best);
+        }
+    }
+    // Pooled buffers keep their size, so this only clears what's grown past it
+    pixels.resize(size);
+    return pixels;
+}
+
+void TextureLoader::ReleasePixels(std::vector<unsigned char>& pixels) {
+    if (!pixels.empty()) {
+        std::lock_guard<std::mutex> lock(m_PixelPoolMutex);
+        if (m_PixelPool.size() < PIXEL_POOL_SIZE) {
+            m_PixelPool.push_back(std::move(pixels));
+        }
+    }
+    pixels = std::vector<unsigned char>();
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <list>
+#include <vector>
+#include <future>
+#include <mutex>
+#include <string>
+
+class Texture;
+
+// Streams textures in without stalling the render thread. Decoding, flipping and mip generation run on
+// the thread pool, then Update copies a bounded number of rows per frame into a ring of pixel buffer
+// objects and hands them to glTexSubImage2D, level by level, so the driver can DMA from the PBO while
+// the frame carries on. Uploads go to a texture object of their own that the Texture adopts once complete,
+// so a texture being reloaded keeps drawing with what it had.
+class TextureLoader {
+private:
+	static const unsigned int PIXEL_BUFFER_COUNT = 3;
+	static const unsigned int PIXEL_POOL_SIZE = 4;
+
+	struct DecodedImage {
+		std::vector<unsigned char> Pixels; // Level 0, from the pool
+		int Width, Height;
+		std::vector<std::vector<unsigned char>> Mips; // Levels 1 and up
+		std::string FailureReason; // From the worker, stbi_failure_reason is per thread
+	};
+
+	struct Request {
+		Texture* Target;
+		unsigned int Destination; // Texture object being filled, 0 until the image is decoded
+		std::future<DecodedImage> Decoding;
+		DecodedImage Image;
+		bool Decoded;
+		int Level;
+		int RowsUploaded; // Of the current level
+	};
+
+	std::list<Request> m_Requests;
+	// Decodes for textures destroyed mid-load, kept until the worker finishes so the pixels can be freed
+	std::list<std::future<DecodedImage>> m_Abandoned;
+	// Level 0 buffers of finished loads, stb_image decodes the next images straight into them. Emptied by
+	// Update once there's nothing left to load
+	std::vector<std::vector<unsigned char>> m_PixelPool;
+	std::mutex m_PixelPoolMutex;
+
+	unsigned int m_PixelBuffers[PIXEL_BUFFER_COUNT];
+	unsigned int m_NextPixelBuffer;
+	unsigned int m_PixelBufferSize;
+	unsigned int m_BytesPerFrame;
+	unsigned int m_PlaceholderID;
+
+	static TextureLoader* s_Instance;
+public:
+	// bytesPerFrame caps how much pixel data Update copies each frame, pixelBufferSize is the size of each PBO
+	TextureLoader(unsigned int bytesPerFrame = 4 * 1024 * 1024, unsigned int pixelBufferSize = 4 * 1024 * 1024);
+	~TextureLoader();
+
+	static TextureLoader& Get() { return *s_Instance; }
+	static bool Exists() { return s_Instance != nullptr; }
+
+	void Enqueue(Texture* texture);
+	void Cancel(Texture* texture);
+	// A texture that's loading moved to another address, its upload continues into the new one
+	void Retarget(Texture* from, Texture* to);
+	// Render thread, once per frame
+	void Update();
+
+	inline unsigned int GetPlaceholderID() const { return m_PlaceholderID; }
+	inline bool IsIdle() const { return m_Requests.empty(); }
+private:
+	// Returns how many bytes it uploaded
+	unsigned int UploadRows(Request& request, unsigned int budget);
+	// Any thread. The smallest pooled buffer that holds size bytes, or a new one
+	std::vector<unsigned char> AcquirePixels(size_t size);
+	// Any thread. Back to the pool if there's room, pixels is left empty
+	void ReleasePixels(std::vector<unsigned char>& pixels);
+};
@@ -0,0 +1,77 @@
+#include "TextureResidency.h"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include "Texture.h"
+
+TextureResidency* TextureResidency::s_Instance = nullptr;
+
+TextureResidency::TextureResidency(size_t budget, int evictedSize)
+    : m_Budget(budget), m_EvictedSize(evictedSize), m_Frame(0), m_ResidentBytes(0), m_OverBudget(false) {
+    ASSERT(s_Instance == nullptr);
+    s_Instance = this;
+}
+
+TextureResidency::~TextureResidency() {
+    for (Texture* texture : m_Textures) {
+        texture->m_Residency = nullptr;
+    }
+    s_Instance = nullptr;
+}
+
+void TextureResidency::Register(Texture* texture) {
+    m_Textures.insert(texture);
+}
+
+void TextureResidency::Unregister(Texture* texture) {
+    m_Textures.erase(texture);
+}
+
+void TextureResidency::Update() {
+    // Anything bound last frame while evicted was drawn blurry, start bringing it back
+    for (Texture* texture : m_Textures) {
+        if (!texture->IsResident() && texture->IsLoaded() && texture->m_LastUsedFrame == m_Frame) {
+            texture->Reload();
+        }
+    }
+
+    m_ResidentBytes = 0;
+    for (Texture* texture : m_Textures) {
+        m_ResidentBytes += texture->GetResidentBytes();
+    }
+
+    if (m_ResidentBytes > m_Budget) {
+        std::vector<Texture*> candidates;
+        for (Texture* texture : m_Textures) {
+            if (texture->IsResident() && texture->IsLoaded() && m_Frame - texture->m_LastUsedFrame >= MIN_IDLE_FRAMES) {
+                candidates.push_back(texture);
+            }
+        }
+        // Least recently used first, the biggest first among equally stale ones
+        std::sort(candidates.begin(), candidates.end(), [](const Texture* a, const Texture* b) {
+            if (a->m_LastUsedFrame != b->m_LastUsedFrame) {
+                return a->m_LastUsedFrame < b->m_LastUsedFrame;
+            }
+            return a->GetResidentBytes() > b->GetResidentBytes();
+        });
+
+        for (Texture* texture : candidates) {
+            if (m_ResidentBytes <= m_Budget) {
+                break;
+            }
+            unsigned int before = texture->GetResidentBytes();
+            if (texture->Evict(m_EvictedSize)) {
+                m_ResidentBytes -= before - texture->GetResidentBytes();
+            }
+        }
+
+        if (m_ResidentBytes > m_Budget && !m_OverBudget) {
+            std::cout << "Warning: textures in use need " << m_ResidentBytes / (1024 * 1024) << " MB, over the "
+                      << m_Budget / (1024 * 1024) << " MB texture budget" << std::endl;
+        }
+    }
+    m_OverBudget = m_ResidentBytes > m_Budget;
+
+    m_Frame++;
+}
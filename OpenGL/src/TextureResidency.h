@@ -0,0 +1,43 @@
+#pragma once
+#include <unordered_set>
+#include <cstddef>
+
+class Texture;
+
+// Keeps the combined GPU memory of every Texture under a budget. Textures remember the frame they were
+// last bound in, and once the total goes over budget Update evicts the least recently used ones down to
+// a small mip (or to the placeholder when they have no mips). An evicted texture that gets bound again
+// draws with what it kept while its file is reloaded in the background.
+// Textures created before this exists, or that don't come from a file, are never evicted.
+class TextureResidency {
+private:
+	// A texture has to sit unused this long before it can be evicted, stops textures that are only
+	// drawn every so often from bouncing between evicted and reloading
+	static const unsigned int MIN_IDLE_FRAMES = 120;
+
+	std::unordered_set<Texture*> m_Textures;
+	size_t m_Budget;
+	int m_EvictedSize;
+	unsigned long long m_Frame;
+	size_t m_ResidentBytes;
+	bool m_OverBudget; // Evicting everything allowed didn't get under budget, warned about once per episode
+
+	static TextureResidency* s_Instance;
+public:
+	// budget is in bytes, evictedSize is the largest width or height an evicted texture keeps
+	TextureResidency(size_t budget = 256 * 1024 * 1024, int evictedSize = 64);
+	~TextureResidency();
+
+	static TextureResidency& Get() { return *s_Instance; }
+	static bool Exists() { return s_Instance != nullptr; }
+
+	void Register(Texture* texture);
+	void Unregister(Texture* texture);
+	// Render thread, once per frame before anything is drawn
+	void Update();
+
+	inline void SetBudget(size_t budget) { m_Budget = budget; }
+	inline size_t GetBudget() const { return m_Budget; }
+	inline size_t GetResidentBytes() const { return m_ResidentBytes; }
+	inline unsigned long long GetFrame() const { return m_Frame; }
+};
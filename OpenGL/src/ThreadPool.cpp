@@ -0,0 +1,71 @@
+#include "ThreadPool.h"
+
+static thread_local bool s_IsWorker = false;
+
+ThreadPool::ThreadPool(unsigned int threadCount) : m_Stopping(false) {
+    // hardware_concurrency is allowed to report 0 when it can't tell
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    for (unsigned int i = 0; i < threadCount; i++) {
+        m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_JobAvailable.notify_all();
+    for (std::thread& worker : m_Workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::Get() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::ParallelFor(unsigned int count, const std::function<void(unsigned int, unsigned int)>& job) {
+    if (count == 0) {
+        return;
+    }
+    if (s_IsWorker) {
+        job(0, count);
+        return;
+    }
+
+    unsigned int chunks = std::min(count, GetThreadCount());
+    unsigned int chunkSize = (count + chunks - 1) / chunks;
+    std::vector<std::future<void>> pending;
+
+    // Calling thread takes the first chunk itself instead of idling on the futures
+    for (unsigned int begin = chunkSize; begin < count; begin += chunkSize) {
+        unsigned int end = std::min(begin + chunkSize, count);
+        pending.push_back(Submit([&job, begin, end]() { job(begin, end); }));
+    }
+    job(0, std::min(chunkSize, count));
+
+    for (std::future<void>& result : pending) {
+        result.get();
+    }
+}
+
+void ThreadPool::WorkerLoop() {
+    s_IsWorker = true;
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_JobAvailable.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+            if (m_Stopping && m_Jobs.empty()) {
+                return;
+            }
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop();
+        }
+        job();
+    }
+}
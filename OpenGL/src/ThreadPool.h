@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <algorithm>
+
+// Fixed set of worker threads pulling from one job queue. Jobs must not touch GL, workers have no context.
+class ThreadPool {
+private:
+	std::vector<std::thread> m_Workers;
+	std::queue<std::function<void()>> m_Jobs;
+	std::mutex m_Mutex;
+	std::condition_variable m_JobAvailable;
+	bool m_Stopping;
+public:
+	ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency());
+	~ThreadPool();
+
+	// Shared pool for loading work, sized to the machine
+	static ThreadPool& Get();
+
+	template<typename F>
+	auto Submit(F job) -> std::future<decltype(job())> {
+		auto task = std::make_shared<std::packaged_task<decltype(job())()>>(std::move(job));
+		std::future<decltype(job())> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Jobs.push([task]() { (*task)(); });
+		}
+		m_JobAvailable.notify_one();
+		return result;
+	}
+
+	// Runs job(begin, end) over [0, count) split into roughly equal chunks and waits for all of them.
+	// From inside a pool job it runs the whole range inline, waiting on sub-jobs could starve every worker
+	void ParallelFor(unsigned int count, const std::function<void(unsigned int, unsigned int)>& job);
+
+	inline unsigned int GetThreadCount() const { return (unsigned int)m_Workers.size(); }
+private:
+	void WorkerLoop();
+};
@@ -0,0 +1,41 @@
+#include "TiledImage.h"
+
+#include <iostream>
+#include <cstring>
+#include "CookedTexture.h"
+
+TiledImage::TiledImage(const std::string& path) : m_Stream(path, std::ios::binary) {
+    memset(&m_Header, 0, sizeof(m_Header));
+    TiledImageHeader header;
+    if (!m_Stream.read((char*)&header, sizeof(header)) || memcmp(header.Magic, TILED_IMAGE_MAGIC, 4) != 0 ||
+        header.Version != TILED_IMAGE_VERSION || !IsCookedTextureFormat(header.GLFormat) || header.TileSize == 0 || header.LevelCount == 0) {
+        std::cout << "Failed to load tiled image " << path << std::endl;
+        return;
+    }
+    m_Header = header;
+
+    unsigned long long offset = sizeof(TiledImageHeader);
+    for (int level = 0; level < GetLevelCount(); level++) {
+        m_LevelOffsets.push_back(offset);
+        offset += (unsigned long long)GetTilesX(level) * GetTilesY(level) * m_Header.TileBytes;
+    }
+}
+
+TiledImage::TiledImage(const TiledImageHeader& header) : m_Header(header) {
+}
+
+TiledImage::~TiledImage() {
+}
+
+bool TiledImage::ReadTile(int level, int x, int y, std::vector<unsigned char>& data) {
+    if (level < 0 || level >= GetLevelCount() || x < 0 || x >= GetTilesX(level) || y < 0 || y >= GetTilesY(level)) {
+        return false;
+    }
+    data.resize(m_Header.TileBytes);
+    unsigned long long offset = m_LevelOffsets[level] + ((unsigned long long)y * GetTilesX(level) + x) * m_Header.TileBytes;
+
+    std::lock_guard<std::mutex> lock(m_StreamMutex);
+    m_Stream.clear();
+    m_Stream.seekg((std::streamoff)offset);
+    return (bool)m_Stream.read((char*)data.data(), m_Header.TileBytes);
+}
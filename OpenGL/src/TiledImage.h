@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+
+// .gltiles container, written offline by TextureCooker --tiles and streamed by VirtualTexture. Holds a mip
+// pyramid cut into square tiles, for images far larger than GL_MAX_TEXTURE_SIZE or than is worth keeping
+// on the GPU. Each tile covers TileSize texels of its level plus Border texels copied from its neighbours
+// (or the clamped edge) on every side, so bilinear filtering inside a tile never needs the next one.
+// Every tile is stored in the same number of bytes, ready for upload like .gltex levels, so a tile's
+// offset is known without an index:
+//
+//	TiledImageHeader
+//	Level 0 (full resolution) to LevelCount - 1, each level's tiles row by row, bottom row first
+
+#define TILED_IMAGE_MAGIC "GLTL"
+#define TILED_IMAGE_VERSION 1
+
+struct TiledImageHeader {
+	char Magic[4];
+	unsigned int Version;
+	unsigned int GLFormat; // GL_RGBA8 or a compressed format
+	unsigned int Width, Height; // Level 0
+	unsigned int TileSize; // Texels each tile covers, not counting the border
+	unsigned int Border;
+	unsigned int LevelCount; // Down to the level that fits in a single tile
+	unsigned int TileBytes; // Stored size of one (TileSize + 2 * Border) squared tile
+	unsigned int Flags; // CookedTextureFlags
+};
+
+// Reads tiles out of a .gltiles. Generated images derive from it and override ReadTile
+class TiledImage {
+protected:
+	TiledImageHeader m_Header;
+private:
+	std::ifstream m_Stream;
+	std::mutex m_StreamMutex;
+	std::vector<unsigned long long> m_LevelOffsets; // File offset of each level's first tile
+public:
+	// IsOpen is false if the file is missing or not a valid container
+	TiledImage(const std::string& path);
+	virtual ~TiledImage();
+
+	// Thread safe, fills data with GetTileBytes bytes. False if the tile can't be read
+	virtual bool ReadTile(int level, int x, int y, std::vector<unsigned char>& data);
+
+	inline bool IsOpen() const { return m_Header.LevelCount > 0; }
+	inline int GetWidth() const { return m_Header.Width; }
+	inline int GetHeight() const { return m_Header.Height; }
+	inline int GetTileSize() const { return m_Header.TileSize; }
+	inline int GetBorder() const { return m_Header.Border; }
+	inline int GetPageSize() const { return m_Header.TileSize + 2 * m_Header.Border; }
+	inline int GetLevelCount() const { return m_Header.LevelCount; }
+	inline unsigned int GetGLFormat() const { return m_Header.GLFormat; }
+	inline unsigned int GetTileBytes() const { return m_Header.TileBytes; }
+	inline int GetTilesX(int level) const { return GetTileCount(m_Header.Width, level, m_Header.TileSize); }
+	inline int GetTilesY(int level) const { return GetTileCount(m_Header.Height, level, m_Header.TileSize); }
+
+	// Tiles across one dimension of a level, levels halve like mips and never go below 1 texel
+	static int GetTileCount(int size, int level, int tileSize) {
+		int levelSize = size >> level > 0 ? size >> level : 1;
+		return (levelSize + tileSize - 1) / tileSize;
+	}
+protected:
+	// For generated images, header describes what ReadTile produces
+	TiledImage(const TiledImageHeader& header);
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include "glm/glm.hpp"
+
+// Compile-time checks that a C++ struct has exactly the memory layout GLSL gives a std140 or std430 block,
+// so it can be memcpy'd straight into a UniformBuffer. Rules are from the GLSL spec, section 7.6.2.2.
+//
+//	struct CameraData {
+//		glm::mat4 ViewProjection;
+//		glm::vec3 Position;
+//		float Time;
+//	};
+//	UNIFORM_BLOCK_FIRST(Std140, CameraData, ViewProjection);
+//	UNIFORM_BLOCK_MEMBER(Std140, CameraData, ViewProjection, Position);
+//	UNIFORM_BLOCK_MEMBER(Std140, CameraData, Position, Time);
+//	UNIFORM_BLOCK_SIZE(Std140, CameraData);
+//
+// A member that GLSL would place further along than C++ does (e.g. a vec4 right after a float) fails to
+// compile. Fix it with an explicit padding member and keep checking against the previous real member,
+// padding itself isn't checked.
+
+enum class BlockLayout {
+	Std140, Std430
+};
+
+namespace BlockRules {
+	constexpr size_t RoundUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// Alignment and size of T inside a block. No primary definition, so an unsupported type
+	// (glm::mat3 with its vec3 columns, bool, double...) is a compile error instead of a silent mismatch.
+	template<BlockLayout L, typename T>
+	struct Member;
+
+	template<size_t A, size_t B>
+	struct Rule {
+		static constexpr size_t Alignment = A;
+		static constexpr size_t Bytes = B;
+	};
+
+	template<BlockLayout L> struct Member<L, float> : Rule<4, 4> {};
+	template<BlockLayout L> struct Member<L, int> : Rule<4, 4> {};
+	template<BlockLayout L> struct Member<L, unsigned int> : Rule<4, 4> {};
+	template<BlockLayout L> struct Member<L, glm::vec2> : Rule<8, 8> {};
+	template<BlockLayout L> struct Member<L, glm::ivec2> : Rule<8, 8> {};
+	// vec3 is aligned like a vec4 but only occupies 12 bytes, a following scalar packs into the gap
+	template<BlockLayout L> struct Member<L, glm::vec3> : Rule<16, 12> {};
+	template<BlockLayout L> struct Member<L, glm::ivec3> : Rule<16, 12> {};
+	template<BlockLayout L> struct Member<L, glm::vec4> : Rule<16, 16> {};
+	template<BlockLayout L> struct Member<L, glm::ivec4> : Rule<16, 16> {};
+	template<BlockLayout L> struct Member<L, glm::mat4> : Rule<16, 64> {};
+
+	// std140 rounds array elements up to a vec4 stride, std430 keeps the element's own alignment
+	template<BlockLayout L, typename T, size_t N>
+	struct Member<L, T[N]> {
+		static constexpr size_t Alignment = L == BlockLayout::Std140 ? RoundUp(Member<L, T>::Alignment, 16) : Member<L, T>::Alignment;
+		static constexpr size_t Stride = RoundUp(Member<L, T>::Bytes, Alignment);
+		static constexpr size_t Bytes = Stride * N;
+		static_assert(Stride == sizeof(T), "Array element stride differs between C++ and GLSL, use a vec4 or padded struct element");
+	};
+}
+
+#define UNIFORM_BLOCK_FIRST(Layout, Struct, member)\
+    static_assert(offsetof(Struct, member) == 0, #Struct "::" #member " must be the first member")
+
+// Checks that member sits exactly where GLSL puts it after prev
+#define UNIFORM_BLOCK_MEMBER(Layout, Struct, prev, member)\
+    static_assert(offsetof(Struct, member) == BlockRules::RoundUp(\
+        offsetof(Struct, prev) + BlockRules::Member<BlockLayout::Layout, decltype(Struct::prev)>::Bytes,\
+        BlockRules::Member<BlockLayout::Layout, decltype(Struct::member)>::Alignment),\
+        #Struct "::" #member " offset doesn't match " #Layout ", add padding before it")
+
+// Structs used in arrays or bound with glBindBufferRange one after another need a vec4 multiple size under std140
+#define UNIFORM_BLOCK_SIZE(Layout, Struct)\
+    static_assert(BlockLayout::Layout != BlockLayout::Std140 || sizeof(Struct) % 16 == 0,\
+        #Struct " size must be a multiple of 16 bytes for " #Layout)
@@ -0,0 +1,69 @@
+#include "UniformBuffer.h"
+
+#include <cstring>
+#include "Renderer.h"
+#include "DeletionQueue.h"
+
+UniformBuffer::UniformBuffer(unsigned int size, const void* data) : m_RendererID(0), m_Size(size) {
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_RendererID));
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW));
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
+
+UniformBuffer::~UniformBuffer() {
+    DeletionQueue::DeleteBuffer(m_RendererID);
+}
+
+void UniformBuffer::SetData(const void* data, unsigned int size, unsigned int offset) {
+    ASSERT(offset + size <= m_Size);
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_RendererID));
+    GLCall(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data));
+}
+
+void UniformBuffer::Bind(unsigned int binding) const {
+    GLCall(glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_RendererID));
+}
+
+void UniformBuffer::BindRange(unsigned int binding, unsigned int offset, unsigned int size) const {
+    GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_RendererID, offset, size));
+}
+
+void UniformBuffer::Unbind() const {
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
+
+UniformRingBuffer::UniformRingBuffer(unsigned int size) : m_Buffer(size), m_Alignment(0), m_Head(0), m_Uploaded(0) {
+    int alignment;
+    GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    m_Alignment = (unsigned int)alignment;
+    m_Staging.resize(size);
+}
+
+unsigned int UniformRingBuffer::Allocate(const void* data, unsigned int size) {
+    unsigned int offset = (m_Head + m_Alignment - 1) / m_Alignment * m_Alignment;
+    // Wrapping mid-frame would orphan storage that draws still to be issued point into, size the ring for a full frame
+    ASSERT(offset + size <= m_Buffer.GetSize());
+
+    memcpy(&m_Staging[offset], data, size);
+    m_Head = offset + size;
+    return offset;
+}
+
+void UniformRingBuffer::Upload() {
+    if (m_Head > m_Uploaded) {
+        m_Buffer.SetData(&m_Staging[m_Uploaded], m_Head - m_Uploaded, m_Uploaded);
+        m_Uploaded = m_Head;
+    }
+}
+
+void UniformRingBuffer::BindRange(unsigned int binding, unsigned int offset, unsigned int size) const {
+    m_Buffer.BindRange(binding, offset, size);
+}
+
+void UniformRingBuffer::Reset() {
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_Buffer.GetRendererID()));
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, m_Buffer.GetSize(), nullptr, GL_DYNAMIC_DRAW));
+    m_Head = 0;
+    m_Uploaded = 0;
+}
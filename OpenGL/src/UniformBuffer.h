@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include "UniformBlockLayout.h"
+
+// Binding points shared between C++ and every shader declaring these blocks, see Shader::SetUniformBlockBinding
+enum UniformBlockBinding : unsigned int {
+	CAMERA_BLOCK_BINDING = 0,
+	DRAW_BLOCK_BINDING = 1,
+	VIRTUAL_TEXTURE_BLOCK_BINDING = 2
+};
+
+// layout(std140) uniform Camera, written once per frame
+struct CameraBlock {
+	glm::mat4 ViewProjection;
+};
+UNIFORM_BLOCK_FIRST(Std140, CameraBlock, ViewProjection);
+UNIFORM_BLOCK_SIZE(Std140, CameraBlock);
+
+// layout(std140) uniform Draw, one per draw out of a UniformRingBuffer
+struct DrawBlock {
+	glm::mat4 Model;
+	glm::vec4 Color;
+};
+UNIFORM_BLOCK_FIRST(Std140, DrawBlock, Model);
+UNIFORM_BLOCK_MEMBER(Std140, DrawBlock, Model, Color);
+UNIFORM_BLOCK_SIZE(Std140, DrawBlock);
+
+// layout(std140) uniform VirtualTexture, written once by each VirtualTexture
+struct VirtualTextureBlock {
+	glm::vec4 ImageInfo; // Level 0 width and height, tile size, border
+	glm::vec4 PhysicalInfo; // Physical texture size, pages per side, level count
+};
+UNIFORM_BLOCK_FIRST(Std140, VirtualTextureBlock, ImageInfo);
+UNIFORM_BLOCK_MEMBER(Std140, VirtualTextureBlock, ImageInfo, PhysicalInfo);
+UNIFORM_BLOCK_SIZE(Std140, VirtualTextureBlock);
+
+class UniformBuffer {
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Size;
+public:
+	UniformBuffer(unsigned int size, const void* data = nullptr);
+	~UniformBuffer();
+
+	void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+	template<typename T>
+	void SetData(const T& block) { SetData(&block, sizeof(T)); }
+
+	// Whole buffer to an indexed binding point
+	void Bind(unsigned int binding) const;
+	void BindRange(unsigned int binding, unsigned int offset, unsigned int size) const;
+	void Unbind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetSize() const { return m_Size; }
+};
+
+// Per-draw uniform data packed into one buffer. Allocate copies blocks into a CPU staging area,
+// Upload sends everything for the frame in a single glBufferSubData and then each draw binds
+// its slice with BindRange. Offsets respect GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+// Reset orphans the storage each frame, so the driver rotates buffers behind it and the previous
+// frame's draws keep reading their own copy without a sync.
+class UniformRingBuffer {
+private:
+	UniformBuffer m_Buffer;
+	std::vector<unsigned char> m_Staging;
+	unsigned int m_Alignment;
+	unsigned int m_Head;
+	unsigned int m_Uploaded; // Bytes of m_Staging already in the GL buffer
+public:
+	UniformRingBuffer(unsigned int size);
+
+	// Returns the offset to hand to BindRange
+	unsigned int Allocate(const void* data, unsigned int size);
+	template<typename T>
+	unsigned int Allocate(const T& block) { return Allocate(&block, sizeof(T)); }
+
+	void Upload();
+	void BindRange(unsigned int binding, unsigned int offset, unsigned int size) const;
+	// Starts the next frame from the beginning, orphaning the old storage so the GPU can keep reading it
+	void Reset();
+};
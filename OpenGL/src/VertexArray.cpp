@@ -8,7 +8,21 @@ VertexArray::VertexArray() {
 	GLCall(glBindVertexArray(m_RendererID));
 }
 
+VertexArray::VertexArray(VertexArray&& other) : m_RendererID(other.m_RendererID) {
+	other.m_RendererID = 0;
+}
+
+VertexArray& VertexArray::operator=(VertexArray&& other) {
+	if (this != &other) {
+		GLCall(glDeleteVertexArrays(1, &m_RendererID));
+		m_RendererID = other.m_RendererID;
+		other.m_RendererID = 0;
+	}
+	return *this;
+}
+
 VertexArray::~VertexArray() {
+	// Deleting 0 is ignored, so moved from arrays need no check
 	GLCall(glDeleteVertexArrays(1, &m_RendererID));
 }
 
@@ -21,15 +35,42 @@ void VertexArray::Unbind() const {
 }
 
 void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) const {
+	const auto& elements = layout.GetElements();
+	AddBuffer(vb, elements.data(), (unsigned int)elements.size(), layout.GetStride());
+}
+
+void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferElement* elements, unsigned int count, unsigned int stride) const {
 	Bind();
 	vb.Bind();
-	const auto& elements = layout.GetElements();
-	unsigned int offset = 0;
-	for (unsigned int i = 0; i < elements.size(); i++) {
+	for (unsigned int i = 0; i < count; i++) {
 		const auto& element = elements[i];
 
 		GLCall(glEnableVertexAttribArray(i));
-		GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(), (const void*)offset));
-		offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
+		if (element.integer) {
+			GLCall(glVertexAttribIPointer(i, element.count, element.type, stride, (const void*)(size_t)element.offset));
+		}
+		else {
+			GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, stride, (const void*)(size_t)element.offset));
+		}
 	}
+}
+
+void VertexArray::SetFormat(const VertexBufferElement* elements, unsigned int count) const {
+	Bind();
+	for (unsigned int i = 0; i < count; i++) {
+		const auto& element = elements[i];
+
+		GLCall(glEnableVertexAttribArray(i));
+		if (element.integer) {
+			GLCall(glVertexAttribIFormat(i, element.count, element.type, element.offset));
+		}
+		else {
+			GLCall(glVertexAttribFormat(i, element.count, element.type, element.normalized, element.offset));
+		}
+		GLCall(glVertexAttribBinding(i, 0));
+	}
+}
+
+void VertexArray::SetVertexBuffer(const VertexBuffer& vb, unsigned int stride) const {
+	GLCall(glBindVertexBuffer(0, vb.GetRendererID(), 0, stride));
 }
\ No newline at end of file
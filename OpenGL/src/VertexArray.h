@@ -1,17 +1,40 @@
 #pragma once
+#include <cstddef>
 #include "VertexBuffer.h"
 
+struct VertexBufferElement;
 class VertexBufferLayout;
+template<typename Vertex, std::size_t N>
+class StaticVertexLayout;
 
 class VertexArray {
 private:
 	unsigned int m_RendererID;
 public:
 	VertexArray();
+	// Move only, the moved from array owns nothing
+	VertexArray(VertexArray&& other);
+	VertexArray& operator=(VertexArray&& other);
+	VertexArray(const VertexArray&) = delete;
+	VertexArray& operator=(const VertexArray&) = delete;
 	~VertexArray();
 
 	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) const;
+	template<typename Vertex, std::size_t N>
+	void AddBuffer(const VertexBuffer& vb, const StaticVertexLayout<Vertex, N>& layout) const {
+		AddBuffer(vb, layout.GetElements(), layout.GetElementCount(), layout.GetStride());
+	}
+	// Attribute locations 0 to count - 1 in element order
+	void AddBuffer(const VertexBuffer& vb, const VertexBufferElement* elements, unsigned int count, unsigned int stride) const;
+
+	// ARB_vertex_attrib_binding: attributes 0 to count - 1 take their format from elements and all read from
+	// binding 0, which SetVertexBuffer points at any buffer with that format afterwards
+	void SetFormat(const VertexBufferElement* elements, unsigned int count) const;
+	// On the bound VAO, which has to be this one
+	void SetVertexBuffer(const VertexBuffer& vb, unsigned int stride) const;
 
 	void Bind() const;
 	void Unbind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
 };
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "VertexArrayCache.h"
+
+#include <algorithm>
+#include "Renderer.h"
+
+VertexArrayCache* VertexArrayCache::s_Instance = nullptr;
+
+size_t VertexArrayCache::BufferSetKeyHash::operator()(const BufferSetKey& key) const {
+    unsigned long long hash = key.LayoutHash;
+    hash = (hash ^ key.VertexBuffer) * 1099511628211ull;
+    hash = (hash ^ key.IndexBuffer) * 1099511628211ull;
+    return (size_t)(hash ^ (hash >> 32));
+}
+
+VertexArrayCache::VertexArrayCache(bool useAttribBinding)
+    : m_AttribBinding(useAttribBinding && IsAttribBindingSupported()), m_CurrentArray(0), m_Stats() {
+    ASSERT(s_Instance == nullptr);
+    s_Instance = this;
+}
+
+VertexArrayCache::~VertexArrayCache() {
+    // The VAOs are deleted with the maps, but nothing should go through the cache from here on
+    s_Instance = nullptr;
+}
+
+bool VertexArrayCache::IsAttribBindingSupported() {
+    return GLEW_VERSION_4_3 || GLEW_ARB_vertex_attrib_binding;
+}
+
+void VertexArrayCache::Bind(const VertexBuffer& vb, const IndexBuffer* ib, const VertexBufferLayout& layout) {
+    const auto& elements = layout.GetElements();
+    Bind(vb, ib, elements.data(), (unsigned int)elements.size(), layout.GetStride(), layout.GetHash());
+}
+
+void VertexArrayCache::Bind(const VertexBuffer& vb, const IndexBuffer* ib, const VertexBufferElement* elements, unsigned int count,
+                            unsigned int stride, unsigned long long hash) {
+    unsigned int vertexBuffer = vb.GetRendererID();
+    unsigned int indexBuffer = ib ? ib->GetRendererID() : 0;
+
+    if (!m_AttribBinding) {
+        // The attribute pointers are baked into the VAO, only the element buffer can be changed from outside
+        BufferSetKey key = { hash, vertexBuffer, indexBuffer };
+        auto found = m_BufferSetArrays.find(key);
+        if (found == m_BufferSetArrays.end()) {
+            CachedArray array = { std::make_unique<VertexArray>(), vertexBuffer, 0 };
+            array.Array->AddBuffer(vb, elements, count, stride);
+            m_Stats.ArraysCreated++;
+            m_CurrentArray = array.Array->GetRendererID();
+            found = m_BufferSetArrays.emplace(key, std::move(array)).first;
+            m_BufferSetsByBuffer[vertexBuffer].push_back(key);
+            if (indexBuffer != 0) {
+                m_BufferSetsByBuffer[indexBuffer].push_back(key);
+            }
+        }
+        BindArray(*found->second.Array);
+        BindIndexBuffer(found->second, ib);
+        return;
+    }
+
+    auto found = m_FormatArrays.find(hash);
+    if (found == m_FormatArrays.end()) {
+        CachedArray array = { std::make_unique<VertexArray>(), 0, 0 };
+        array.Array->SetFormat(elements, count);
+        m_Stats.ArraysCreated++;
+        m_CurrentArray = array.Array->GetRendererID();
+        found = m_FormatArrays.emplace(hash, std::move(array)).first;
+    }
+    CachedArray& array = found->second;
+    BindArray(*array.Array);
+    if (array.VertexBuffer != vertexBuffer) {
+        array.Array->SetVertexBuffer(vb, stride);
+        array.VertexBuffer = vertexBuffer;
+        m_Stats.BufferBinds++;
+    }
+    else {
+        m_Stats.BindsSkipped++;
+    }
+    BindIndexBuffer(array, ib);
+}
+
+void VertexArrayCache::BindArray(const VertexArray& array) {
+    if (m_CurrentArray == array.GetRendererID()) {
+        m_Stats.BindsSkipped++;
+        return;
+    }
+    array.Bind();
+    m_CurrentArray = array.GetRendererID();
+    m_Stats.ArrayBinds++;
+}
+
+void VertexArrayCache::BindIndexBuffer(CachedArray& array, const IndexBuffer* ib) {
+    if (!ib) {
+        return;
+    }
+    if (array.IndexBuffer == ib->GetRendererID()) {
+        m_Stats.BindsSkipped++;
+        return;
+    }
+    ib->Bind();
+    array.IndexBuffer = ib->GetRendererID();
+    m_Stats.BufferBinds++;
+}
+
+void VertexArrayCache::Invalidate() {
+    m_CurrentArray = 0;
+    for (auto& format : m_FormatArrays) {
+        format.second.VertexBuffer = 0;
+        format.second.IndexBuffer = 0;
+    }
+    for (auto& bufferSet : m_BufferSetArrays) {
+        bufferSet.second.IndexBuffer = 0;
+    }
+}
+
+void VertexArrayCache::OnBufferDeleted(unsigned int buffer) {
+    auto keys = m_BufferSetsByBuffer.find(buffer);
+    if (keys != m_BufferSetsByBuffer.end()) {
+        for (const BufferSetKey& key : keys->second) {
+            auto array = m_BufferSetArrays.find(key);
+            if (array != m_BufferSetArrays.end()) {
+                if (m_CurrentArray == array->second.Array->GetRendererID()) {
+                    m_CurrentArray = 0;
+                }
+                m_BufferSetArrays.erase(array);
+            }
+            // The other buffer of the set no longer needs to know about it
+            unsigned int other = key.VertexBuffer == buffer ? key.IndexBuffer : key.VertexBuffer;
+            auto otherKeys = m_BufferSetsByBuffer.find(other);
+            if (other != buffer && otherKeys != m_BufferSetsByBuffer.end()) {
+                std::vector<BufferSetKey>& list = otherKeys->second;
+                list.erase(std::remove(list.begin(), list.end(), key), list.end());
+                if (list.empty()) {
+                    m_BufferSetsByBuffer.erase(otherKeys);
+                }
+            }
+        }
+        m_BufferSetsByBuffer.erase(buffer);
+    }
+    // A format VAO outlives its buffers, but a new buffer could get the deleted one's name and be taken as already bound
+    for (auto& format : m_FormatArrays) {
+        if (format.second.VertexBuffer == buffer) {
+            format.second.VertexBuffer = 0;
+        }
+        if (format.second.IndexBuffer == buffer) {
+            format.second.IndexBuffer = 0;
+        }
+    }
+}
+
+void VertexArrayCache::SetUseAttribBinding(bool useAttribBinding) {
+    useAttribBinding = useAttribBinding && IsAttribBindingSupported();
+    if (useAttribBinding == m_AttribBinding) {
+        return;
+    }
+    m_FormatArrays.clear();
+    m_BufferSetArrays.clear();
+    m_BufferSetsByBuffer.clear();
+    m_CurrentArray = 0;
+    m_AttribBinding = useAttribBinding;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "VertexArray.h"
+#include "VertexBufferLayout.h"
+#include "IndexBuffer.h"
+
+// Hands out VAOs by vertex format instead of each mesh building its own. With ARB_vertex_attrib_binding (core
+// in 4.3) there's one VAO per layout hash, holding only the attribute formats, and drawing another mesh of
+// the same format just points its vertex binding and element buffer elsewhere. Without it there's one VAO
+// per layout and buffer set, still built once and shared by every draw of those buffers.
+// Binds are skipped when the cache already has the VAO or buffer in place. It only knows about its own binds,
+// so Invalidate has to follow anything else binding a VAO or an element buffer, creating an IndexBuffer
+// included, which the main loop does once a frame. Buffers tell the cache when they're deleted, so a VAO
+// built for one is never mistaken for one built for a new buffer given the same name.
+class VertexArrayCache {
+public:
+	struct Stats {
+		unsigned int ArraysCreated;
+		unsigned int ArrayBinds;
+		unsigned int BufferBinds; // Vertex and element buffers
+		unsigned int BindsSkipped; // VAO and buffer binds that were already in place
+	};
+private:
+	struct BufferSetKey {
+		unsigned long long LayoutHash;
+		unsigned int VertexBuffer;
+		unsigned int IndexBuffer;
+
+		bool operator==(const BufferSetKey& other) const {
+			return LayoutHash == other.LayoutHash && VertexBuffer == other.VertexBuffer && IndexBuffer == other.IndexBuffer;
+		}
+	};
+
+	struct BufferSetKeyHash {
+		size_t operator()(const BufferSetKey& key) const;
+	};
+
+	struct CachedArray {
+		std::unique_ptr<VertexArray> Array;
+		// Currently in its vertex binding and element buffer binding as far as the cache knows, 0 when unknown
+		unsigned int VertexBuffer;
+		unsigned int IndexBuffer;
+	};
+
+	bool m_AttribBinding;
+	std::unordered_map<unsigned long long, CachedArray> m_FormatArrays; // By layout hash, with ARB_vertex_attrib_binding
+	std::unordered_map<BufferSetKey, CachedArray, BufferSetKeyHash> m_BufferSetArrays; // Without it
+	std::unordered_map<unsigned int, std::vector<BufferSetKey>> m_BufferSetsByBuffer; // Keys each buffer is part of
+	unsigned int m_CurrentArray; // 0 when unknown
+	Stats m_Stats;
+
+	static VertexArrayCache* s_Instance;
+public:
+	// useAttribBinding false forces the per buffer set path even where the extension is there, for comparison
+	VertexArrayCache(bool useAttribBinding = true);
+	~VertexArrayCache();
+
+	static VertexArrayCache& Get() { return *s_Instance; }
+	static bool Exists() { return s_Instance != nullptr; }
+
+	// Binds a VAO reading vb through layout, with ib as its element buffer when given, ready for glDrawElements
+	void Bind(const VertexBuffer& vb, const IndexBuffer* ib, const VertexBufferLayout& layout);
+	template<typename Vertex, std::size_t N>
+	void Bind(const VertexBuffer& vb, const IndexBuffer* ib, const StaticVertexLayout<Vertex, N>& layout) {
+		Bind(vb, ib, layout.GetElements(), layout.GetElementCount(), layout.GetStride(), layout.GetHash());
+	}
+	// Forgets what's bound, so the next Bind binds everything again
+	void Invalidate();
+	// Drops VAOs referring to the buffer, called by DeletionQueue right before the buffer is really deleted
+	void OnBufferDeleted(unsigned int buffer);
+
+	// Switches between the two paths, dropping every VAO. Ignored without ARB_vertex_attrib_binding
+	void SetUseAttribBinding(bool useAttribBinding);
+	static bool IsAttribBindingSupported();
+	inline bool UsesAttribBinding() const { return m_AttribBinding; }
+	inline size_t GetArrayCount() const { return m_FormatArrays.size() + m_BufferSetArrays.size(); }
+	inline const Stats& GetStats() const { return m_Stats; }
+	inline void ResetStats() { m_Stats = {}; }
+private:
+	void Bind(const VertexBuffer& vb, const IndexBuffer* ib, const VertexBufferElement* elements, unsigned int count,
+			  unsigned int stride, unsigned long long hash);
+	void BindArray(const VertexArray& array);
+	void BindIndexBuffer(CachedArray& array, const IndexBuffer* ib);
+};
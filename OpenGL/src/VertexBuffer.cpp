@@ -2,20 +2,39 @@
 
 #include "Renderer.h"
 
-VertexBuffer::VertexBuffer(const void* data, unsigned int size) {
-    GLCall(glGenBuffers(1, &m_RendererID));
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
-    GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+VertexBuffer::VertexBuffer(const void* data, unsigned int size, BufferUsage usage) : m_Buffer(GL_ARRAY_BUFFER, data, size, usage) {
+}
+
+VertexBuffer::VertexBuffer(unsigned int size, BufferUsage usage) : m_Buffer(GL_ARRAY_BUFFER, nullptr, size, usage) {
 }
 
 VertexBuffer::~VertexBuffer() {
-    GLCall(glDeleteBuffers(1, &m_RendererID));
+}
+
+void VertexBuffer::SetData(const void* data, unsigned int size, unsigned int offset) {
+    m_Buffer.SetData(data, size, offset);
+}
+
+void VertexBuffer::Flush() {
+    m_Buffer.Flush();
+}
+
+void VertexBuffer::Reallocate(const void* data, unsigned int size) {
+    m_Buffer.Reallocate(data, size);
+}
+
+void* VertexBuffer::Map(unsigned int offset, unsigned int size, bool unsynchronized) {
+    return m_Buffer.Map(offset, size, unsynchronized);
+}
+
+void VertexBuffer::Unmap() {
+    m_Buffer.Unmap();
 }
 
 void VertexBuffer::Bind() const {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+    m_Buffer.Bind();
 }
 
 void VertexBuffer::Unbind() const {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
-}
\ No newline at end of file
+    m_Buffer.Unbind();
+}
@@ -1,12 +1,27 @@
 #pragma once
+#include "BufferObject.h"
 
+// Sizes and offsets in bytes. Writes queued with SetData reach the GPU on Flush, see BufferObject
 class VertexBuffer {
 private:
-	unsigned int m_RendererID;
+	BufferObject m_Buffer;
 public:
-	VertexBuffer(const void* data, unsigned int size);
+	VertexBuffer(const void* data, unsigned int size, BufferUsage usage = BufferUsage::Static);
+	// Storage for size bytes to be filled later with SetData or Map
+	VertexBuffer(unsigned int size, BufferUsage usage);
+	VertexBuffer(VertexBuffer&&) = default;
+	VertexBuffer& operator=(VertexBuffer&&) = default;
 	~VertexBuffer();
 
+	void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+	void Flush();
+	void Reallocate(const void* data, unsigned int size);
+	void* Map(unsigned int offset, unsigned int size, bool unsynchronized = false);
+	void Unmap();
+
 	void Bind() const;
 	void Unbind() const;
-};
\ No newline at end of file
+
+	inline unsigned int GetRendererID() const { return m_Buffer.GetRendererID(); }
+	inline unsigned int GetSize() const { return m_Buffer.GetSize(); }
+};
@@ -1,25 +1,149 @@
 #pragma once
+#include <array>
+#include <cstddef>
 #include <vector>
 #include "Renderer.h"
+#include "glm/glm.hpp"
 
 struct VertexBufferElement {
 	unsigned int type;
 	unsigned int count;
 	unsigned char normalized;
+	unsigned char integer; // Read through glVertexAttribIPointer into an int or uint shader input
+	unsigned int offset; // Bytes from the start of the vertex
 
-	static unsigned int GetSizeOfType(unsigned int type) {
+	static constexpr unsigned int GetSizeOfType(unsigned int type) {
 		switch (type) {
 			case GL_FLOAT: return 4;
 			case GL_UNSIGNED_INT: return 4;
+			case GL_INT: return 4;
+			case GL_HALF_FLOAT: return 2;
+			case GL_UNSIGNED_SHORT: return 2;
+			case GL_SHORT: return 2;
 			case GL_UNSIGNED_BYTE: return 1;
+			case GL_BYTE: return 1;
+			// All four components in one 32-bit word
+			case GL_INT_2_10_10_10_REV: return 4;
+			case GL_UNSIGNED_INT_2_10_10_10_REV: return 4;
 		}
 		ASSERT(false);
 		return 0;
 	}
 
-	VertexBufferElement(GLenum glValue, unsigned int count, unsigned char normalized) : type(glValue), count(count), normalized(normalized) {};
+	static constexpr bool IsPacked(unsigned int type) {
+		return type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV;
+	}
+
+	// Bytes the element itself takes
+	constexpr unsigned int GetSize() const {
+		return IsPacked(type) ? GetSizeOfType(type) : count * GetSizeOfType(type);
+	}
+
+	constexpr VertexBufferElement(GLenum glValue, unsigned int count, unsigned char normalized, unsigned char integer = GL_FALSE, unsigned int offset = 0)
+		: type(glValue), count(count), normalized(normalized), integer(integer), offset(offset) {};
+};
+
+// FNV-1a over every element's format and offset and the stride, the same for equal layouts however they were built
+constexpr unsigned long long HashVertexLayout(const VertexBufferElement* elements, std::size_t count, unsigned int stride) {
+	unsigned long long hash = 14695981039346656037ull;
+	for (std::size_t i = 0; i <= count; i++) {
+		unsigned int words[4] = { stride, 0, 0, 0 };
+		if (i < count) {
+			const VertexBufferElement& element = elements[i];
+			words[0] = element.type;
+			words[1] = element.count;
+			words[2] = element.normalized | (unsigned int)element.integer << 8;
+			words[3] = element.offset;
+		}
+		for (unsigned int word : words) {
+			for (int byte = 0; byte < 4; byte++) {
+				hash = (hash ^ ((word >> (byte * 8)) & 0xff)) * 1099511628211ull;
+			}
+		}
+	}
+	return hash;
+}
+
+// The attribute format a C++ type maps to, for Push<T> and VERTEX_ATTRIBUTE. Left undefined for types without one,
+// so using them fails to compile
+template<typename T>
+struct VertexAttributeFormat;
+
+template<unsigned int Type, unsigned int Count, unsigned char Normalized, unsigned char Integer = GL_FALSE>
+struct VertexAttributeFormatOf {
+	static constexpr VertexBufferElement Make(unsigned int offset) {
+		return VertexBufferElement(Type, Count, Normalized, Integer, offset);
+	}
 };
 
+template<> struct VertexAttributeFormat<float> : VertexAttributeFormatOf<GL_FLOAT, 1, GL_FALSE> {};
+// Converted to float, like any other non-integer attribute
+template<> struct VertexAttributeFormat<unsigned int> : VertexAttributeFormatOf<GL_UNSIGNED_INT, 1, GL_FALSE> {};
+// Normalized, these mostly hold colors, texture coordinates and normals
+template<> struct VertexAttributeFormat<unsigned char> : VertexAttributeFormatOf<GL_UNSIGNED_BYTE, 1, GL_TRUE> {};
+template<> struct VertexAttributeFormat<signed char> : VertexAttributeFormatOf<GL_BYTE, 1, GL_TRUE> {};
+template<> struct VertexAttributeFormat<unsigned short> : VertexAttributeFormatOf<GL_UNSIGNED_SHORT, 1, GL_TRUE> {};
+template<> struct VertexAttributeFormat<short> : VertexAttributeFormatOf<GL_SHORT, 1, GL_TRUE> {};
+template<> struct VertexAttributeFormat<glm::vec2> : VertexAttributeFormatOf<GL_FLOAT, 2, GL_FALSE> {};
+template<> struct VertexAttributeFormat<glm::vec3> : VertexAttributeFormatOf<GL_FLOAT, 3, GL_FALSE> {};
+template<> struct VertexAttributeFormat<glm::vec4> : VertexAttributeFormatOf<GL_FLOAT, 4, GL_FALSE> {};
+// Integer vectors are integer shader inputs
+template<> struct VertexAttributeFormat<glm::ivec2> : VertexAttributeFormatOf<GL_INT, 2, GL_FALSE, GL_TRUE> {};
+template<> struct VertexAttributeFormat<glm::ivec3> : VertexAttributeFormatOf<GL_INT, 3, GL_FALSE, GL_TRUE> {};
+template<> struct VertexAttributeFormat<glm::ivec4> : VertexAttributeFormatOf<GL_INT, 4, GL_FALSE, GL_TRUE> {};
+template<> struct VertexAttributeFormat<glm::uvec2> : VertexAttributeFormatOf<GL_UNSIGNED_INT, 2, GL_FALSE, GL_TRUE> {};
+template<> struct VertexAttributeFormat<glm::uvec3> : VertexAttributeFormatOf<GL_UNSIGNED_INT, 3, GL_FALSE, GL_TRUE> {};
+template<> struct VertexAttributeFormat<glm::uvec4> : VertexAttributeFormatOf<GL_UNSIGNED_INT, 4, GL_FALSE, GL_TRUE> {};
+
+// An array of up to four scalars is one attribute of that many components, e.g. unsigned char Color[4]
+template<typename T, std::size_t N>
+struct VertexAttributeFormat<T[N]> {
+	static_assert(N >= 1 && N <= 4, "Vertex attributes have 1 to 4 components");
+
+	static constexpr VertexBufferElement Make(unsigned int offset) {
+		VertexBufferElement element = VertexAttributeFormat<T>::Make(offset);
+		element.count = (unsigned int)N;
+		return element;
+	}
+};
+
+// A layout fixed at compile time from a vertex struct, see MakeVertexLayout. The elements live in the object itself,
+// so a static constexpr one costs nothing to build or pass around, and its hash is known at compile time
+template<typename Vertex, std::size_t N>
+class StaticVertexLayout {
+	static_assert(N > 0, "A vertex layout needs at least one element");
+private:
+	std::array<VertexBufferElement, N> m_Elements;
+	unsigned long long m_Hash;
+public:
+	constexpr StaticVertexLayout(const std::array<VertexBufferElement, N>& elements)
+		: m_Elements(elements), m_Hash(HashVertexLayout(&elements[0], N, (unsigned int)sizeof(Vertex))) {};
+
+	inline constexpr const VertexBufferElement* GetElements() const { return &m_Elements[0]; }
+	inline constexpr unsigned int GetElementCount() const { return (unsigned int)N; }
+	inline constexpr unsigned int GetStride() const { return (unsigned int)sizeof(Vertex); }
+	inline constexpr unsigned long long GetHash() const { return m_Hash; }
+};
+
+// Elements in attribute location order, each a VERTEX_ATTRIBUTE of Vertex's members:
+//	struct SpriteVertex { glm::vec2 Position; glm::vec2 TexCoord; unsigned char Color[4]; };
+//	static constexpr auto layout = MakeVertexLayout<SpriteVertex>(VERTEX_ATTRIBUTE(SpriteVertex, Position),
+//		VERTEX_ATTRIBUTE(SpriteVertex, TexCoord), VERTEX_ATTRIBUTE(SpriteVertex, Color));
+template<typename Vertex, typename... Elements>
+constexpr StaticVertexLayout<Vertex, sizeof...(Elements)> MakeVertexLayout(Elements... elements) {
+	return StaticVertexLayout<Vertex, sizeof...(Elements)>(std::array<VertexBufferElement, sizeof...(Elements)>{ { elements... } });
+}
+
+// The member's format follows from its type through VertexAttributeFormat
+#define VERTEX_ATTRIBUTE(Vertex, member) VertexAttributeFormat<decltype(Vertex::member)>::Make((unsigned int)offsetof(Vertex, member))
+// Any other format, e.g. GL_HALF_FLOAT out of an unsigned short[4] or GL_INT_2_10_10_10_REV out of an unsigned int
+#define VERTEX_ATTRIBUTE_FORMAT(Vertex, member, type, count, normalized) \
+	VertexBufferElement(type, count, (normalized) ? GL_TRUE : GL_FALSE, GL_FALSE, (unsigned int)offsetof(Vertex, member))
+// Integer shader input out of any integer member, e.g. a material index kept in an unsigned short
+#define VERTEX_ATTRIBUTE_INTEGER(Vertex, member, type, count) \
+	VertexBufferElement(type, count, GL_FALSE, GL_TRUE, (unsigned int)offsetof(Vertex, member))
+
+// A layout built up at runtime, for formats only known then, such as VertexQuantization's output
 class VertexBufferLayout {
 private:
 	std::vector<VertexBufferElement> m_Elements;
@@ -28,30 +152,40 @@ public:
 	VertexBufferLayout()
 		: m_Stride(0) {};
 
+	template<typename Vertex, std::size_t N>
+	VertexBufferLayout(const StaticVertexLayout<Vertex, N>& layout)
+		: m_Elements(layout.GetElements(), layout.GetElements() + N), m_Stride(layout.GetStride()) {};
+
+	// float, unsigned int, unsigned char (normalized) and the rest of VertexAttributeFormat's scalars
 	template<typename T>
 	void Push(unsigned int count) {
-		static_assert(false);
+		VertexBufferElement element = VertexAttributeFormat<T>::Make(m_Stride);
+		element.count = count;
+		m_Elements.push_back(element);
+		m_Stride += element.GetSize();
 	}
 
-	template<>
-	void Push<float>(unsigned int count) {
-		m_Elements.push_back({ GL_FLOAT, count, GL_FALSE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_FLOAT);
+	// Any attribute format glVertexAttribPointer takes: GL_HALF_FLOAT, GL_SHORT or GL_UNSIGNED_SHORT normalized
+	// for snorm16 / unorm16, GL_BYTE, GL_INT_2_10_10_10_REV (always count 4, a vec3 input ignores w) and so on
+	void Push(unsigned int type, unsigned int count, bool normalized) {
+		ASSERT(!VertexBufferElement::IsPacked(type) || count == 4);
+		m_Elements.push_back({ type, count, (unsigned char)(normalized ? GL_TRUE : GL_FALSE), GL_FALSE, m_Stride });
+		m_Stride += m_Elements.back().GetSize();
 	}
 
-	template<>
-	void Push<unsigned int>(unsigned int count) {
-		m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_INT);
+	// Integer attribute for an int, uint, ivecN or uvecN shader input, e.g. bone or material indices
+	void PushInteger(unsigned int type, unsigned int count) {
+		ASSERT(type == GL_BYTE || type == GL_UNSIGNED_BYTE || type == GL_SHORT || type == GL_UNSIGNED_SHORT || type == GL_INT || type == GL_UNSIGNED_INT);
+		m_Elements.push_back({ type, count, GL_FALSE, GL_TRUE, m_Stride });
+		m_Stride += m_Elements.back().GetSize();
 	}
 
-	template<>
-	void Push<unsigned char>(unsigned int count) {
-
-		m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE);
+	// Skips bytes after the last element, e.g. to keep the next one 4 byte aligned
+	void Pad(unsigned int bytes) {
+		m_Stride += bytes;
 	}
 
-	inline const std::vector<VertexBufferElement> GetElements() const& { return m_Elements; }
+	inline const std::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
 	inline unsigned int GetStride() const { return m_Stride; }
-};
\ No newline at end of file
+	unsigned long long GetHash() const { return HashVertexLayout(m_Elements.data(), m_Elements.size(), m_Stride); }
+};
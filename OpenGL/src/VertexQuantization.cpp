@@ -0,0 +1,383 @@
+#include "VertexQuantization.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "Renderer.h"
+
+namespace VertexQuantization {
+    namespace {
+        float Clamp(float value, float low, float high) {
+            return std::min(std::max(value, low), high);
+        }
+
+        int Round(float value) {
+            return (int)std::floor(value + 0.5f);
+        }
+
+        float DecodeSnorm(int value, unsigned int bits) {
+            return std::max((float)value / (float)((1 << (bits - 1)) - 1), -1.0f);
+        }
+
+        float DecodeUnorm(unsigned int value, unsigned int bits) {
+            return (float)value / (float)((1u << bits) - 1);
+        }
+
+        bool IsSigned(Encoding encoding) {
+            return encoding == Encoding::Snorm16 || encoding == Encoding::Snorm8 || encoding == Encoding::Snorm1010102;
+        }
+
+        bool IsNormalized(Encoding encoding) {
+            return encoding != Encoding::Float && encoding != Encoding::Half
+                && encoding != Encoding::Octahedral16 && encoding != Encoding::Octahedral8;
+        }
+
+        unsigned int GetEncodedSize(const Attribute& attribute) {
+            switch (attribute.Type) {
+                case Encoding::Float: return 4 * attribute.Components;
+                case Encoding::Half: return 2 * attribute.Components;
+                case Encoding::Snorm16: return 2 * attribute.Components;
+                case Encoding::Unorm16: return 2 * attribute.Components;
+                case Encoding::Snorm8: return attribute.Components;
+                case Encoding::Unorm8: return attribute.Components;
+                case Encoding::Snorm1010102: return 4;
+                case Encoding::Unorm1010102: return 4;
+                case Encoding::Octahedral16: return 4;
+                case Encoding::Octahedral8: return 2;
+            }
+            ASSERT(false);
+            return 0;
+        }
+
+        void PushElement(const Attribute& attribute, VertexBufferLayout& layout) {
+            switch (attribute.Type) {
+                case Encoding::Float: layout.Push(GL_FLOAT, attribute.Components, false); break;
+                case Encoding::Half: layout.Push(GL_HALF_FLOAT, attribute.Components, false); break;
+                case Encoding::Snorm16: layout.Push(GL_SHORT, attribute.Components, true); break;
+                case Encoding::Unorm16: layout.Push(GL_UNSIGNED_SHORT, attribute.Components, true); break;
+                case Encoding::Snorm8: layout.Push(GL_BYTE, attribute.Components, true); break;
+                case Encoding::Unorm8: layout.Push(GL_UNSIGNED_BYTE, attribute.Components, true); break;
+                case Encoding::Snorm1010102: layout.Push(GL_INT_2_10_10_10_REV, 4, true); break;
+                case Encoding::Unorm1010102: layout.Push(GL_UNSIGNED_INT_2_10_10_10_REV, 4, true); break;
+                case Encoding::Octahedral16: layout.Push(GL_SHORT, 2, true); break;
+                case Encoding::Octahedral8: layout.Push(GL_BYTE, 2, true); break;
+            }
+        }
+
+        // Writes one component and returns its decoded value, in the encoding's own [-1, 1] or [0, 1] range
+        float EncodeComponent(float value, Encoding encoding, unsigned char* destination) {
+            switch (encoding) {
+                case Encoding::Float: {
+                    memcpy(destination, &value, 4);
+                    return value;
+                }
+                case Encoding::Half: {
+                    unsigned short half = FloatToHalf(value);
+                    memcpy(destination, &half, 2);
+                    return HalfToFloat(half);
+                }
+                case Encoding::Snorm16: {
+                    short code = FloatToSnorm16(value);
+                    memcpy(destination, &code, 2);
+                    return DecodeSnorm(code, 16);
+                }
+                case Encoding::Unorm16: {
+                    unsigned short code = FloatToUnorm16(value);
+                    memcpy(destination, &code, 2);
+                    return DecodeUnorm(code, 16);
+                }
+                case Encoding::Snorm8: {
+                    signed char code = FloatToSnorm8(value);
+                    memcpy(destination, &code, 1);
+                    return DecodeSnorm(code, 8);
+                }
+                case Encoding::Unorm8: {
+                    unsigned char code = FloatToUnorm8(value);
+                    *destination = code;
+                    return DecodeUnorm(code, 8);
+                }
+                default:
+                    ASSERT(false);
+                    return 0.0f;
+            }
+        }
+    }
+
+    unsigned short FloatToHalf(float value) {
+        unsigned int bits;
+        memcpy(&bits, &value, 4);
+        unsigned int sign = (bits >> 16) & 0x8000;
+        unsigned int exponent = (bits >> 23) & 0xff;
+        unsigned int mantissa = bits & 0x7fffff;
+        if (exponent == 0xff) {
+            // Infinity stays infinity, NaN stays a quiet NaN
+            return (unsigned short)(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+        }
+        int halfExponent = (int)exponent - 127 + 15;
+        if (halfExponent >= 31) {
+            return (unsigned short)(sign | 0x7c00);
+        }
+        if (halfExponent <= 0) {
+            // Denormal, or zero below half the smallest one
+            if (halfExponent < -10) {
+                return (unsigned short)sign;
+            }
+            mantissa |= 0x800000;
+            unsigned int shift = (unsigned int)(14 - halfExponent);
+            unsigned int half = mantissa >> shift;
+            unsigned int rest = mantissa & ((1u << shift) - 1);
+            unsigned int halfway = 1u << (shift - 1);
+            if (rest > halfway || (rest == halfway && (half & 1))) {
+                half++; // Rounding up out of the denormals lands on the smallest normal, as it should
+            }
+            return (unsigned short)(sign | half);
+        }
+        unsigned int half = ((unsigned int)halfExponent << 10) | (mantissa >> 13);
+        unsigned int rest = mantissa & 0x1fff;
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+            half++; // Carries into the exponent, up to infinity
+        }
+        return (unsigned short)(sign | half);
+    }
+
+    float HalfToFloat(unsigned short value) {
+        unsigned int sign = (unsigned int)(value & 0x8000) << 16;
+        unsigned int exponent = (value >> 10) & 0x1f;
+        unsigned int mantissa = value & 0x3ff;
+        if (exponent == 0) {
+            float result = std::ldexp((float)mantissa, -24);
+            return sign ? -result : result;
+        }
+        unsigned int bits = exponent == 31
+            ? sign | 0x7f800000 | (mantissa << 13)
+            : sign | ((exponent + 112) << 23) | (mantissa << 13);
+        float result;
+        memcpy(&result, &bits, 4);
+        return result;
+    }
+
+    short FloatToSnorm16(float value) {
+        return (short)Round(Clamp(value, -1.0f, 1.0f) * 32767.0f);
+    }
+
+    unsigned short FloatToUnorm16(float value) {
+        return (unsigned short)Round(Clamp(value, 0.0f, 1.0f) * 65535.0f);
+    }
+
+    signed char FloatToSnorm8(float value) {
+        return (signed char)Round(Clamp(value, -1.0f, 1.0f) * 127.0f);
+    }
+
+    unsigned char FloatToUnorm8(float value) {
+        return (unsigned char)Round(Clamp(value, 0.0f, 1.0f) * 255.0f);
+    }
+
+    unsigned int PackSnorm1010102(float x, float y, float z, float w) {
+        unsigned int ux = (unsigned int)Round(Clamp(x, -1.0f, 1.0f) * 511.0f) & 0x3ff;
+        unsigned int uy = (unsigned int)Round(Clamp(y, -1.0f, 1.0f) * 511.0f) & 0x3ff;
+        unsigned int uz = (unsigned int)Round(Clamp(z, -1.0f, 1.0f) * 511.0f) & 0x3ff;
+        unsigned int uw = (unsigned int)Round(Clamp(w, -1.0f, 1.0f)) & 0x3;
+        return ux | (uy << 10) | (uz << 20) | (uw << 30);
+    }
+
+    unsigned int PackUnorm1010102(float x, float y, float z, float w) {
+        unsigned int ux = (unsigned int)Round(Clamp(x, 0.0f, 1.0f) * 1023.0f);
+        unsigned int uy = (unsigned int)Round(Clamp(y, 0.0f, 1.0f) * 1023.0f);
+        unsigned int uz = (unsigned int)Round(Clamp(z, 0.0f, 1.0f) * 1023.0f);
+        unsigned int uw = (unsigned int)Round(Clamp(w, 0.0f, 1.0f) * 3.0f);
+        return ux | (uy << 10) | (uz << 20) | (uw << 30);
+    }
+
+    void EncodeOctahedral(const float* normal, float& u, float& v) {
+        float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+        if (length == 0.0f) {
+            u = v = 0.0f;
+            return;
+        }
+        u = normal[0] / length;
+        v = normal[1] / length;
+        if (normal[2] < 0.0f) {
+            // Fold the lower half over the diagonals
+            float foldedU = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+            float foldedV = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+            u = foldedU;
+            v = foldedV;
+        }
+    }
+
+    void DecodeOctahedral(float u, float v, float* normal) {
+        float x = u, y = v, z = 1.0f - std::fabs(u) - std::fabs(v);
+        float t = std::max(-z, 0.0f);
+        x += x >= 0.0f ? -t : t;
+        y += y >= 0.0f ? -t : t;
+        float length = std::sqrt(x * x + y * y + z * z);
+        normal[0] = x / length;
+        normal[1] = y / length;
+        normal[2] = z / length;
+    }
+
+    void EncodeOctahedral(const float* normal, unsigned int bits, int& u, int& v) {
+        int maximum = (1 << (bits - 1)) - 1;
+        float fu, fv;
+        EncodeOctahedral(normal, fu, fv);
+        int baseU = (int)std::floor(fu * maximum);
+        int baseV = (int)std::floor(fv * maximum);
+        float bestDot = -2.0f;
+        for (int i = 0; i < 4; i++) {
+            int cu = std::min(std::max(baseU + (i & 1), -maximum), maximum);
+            int cv = std::min(std::max(baseV + (i >> 1), -maximum), maximum);
+            float decoded[3];
+            DecodeOctahedral((float)cu / maximum, (float)cv / maximum, decoded);
+            float dot = decoded[0] * normal[0] + decoded[1] * normal[1] + decoded[2] * normal[2];
+            if (dot > bestDot) {
+                bestDot = dot;
+                u = cu;
+                v = cv;
+            }
+        }
+    }
+
+    void Quantize(const float* vertices, unsigned int vertexCount, const std::vector<Attribute>& attributes,
+                  std::vector<unsigned char>& destination, VertexBufferLayout& layout, std::vector<AttributeResult>* results) {
+        std::vector<AttributeResult> fitted(attributes.size());
+        std::vector<unsigned int> sourceOffsets(attributes.size());
+        std::vector<unsigned int> offsets(attributes.size());
+        unsigned int sourceStride = 0;
+        unsigned int stride = 0;
+        for (size_t a = 0; a < attributes.size(); a++) {
+            const Attribute& attribute = attributes[a];
+            ASSERT(attribute.Components >= 1 && attribute.Components <= 4);
+            ASSERT((attribute.Type != Encoding::Octahedral16 && attribute.Type != Encoding::Octahedral8) || attribute.Components == 3);
+            ASSERT((attribute.Type != Encoding::Snorm1010102 && attribute.Type != Encoding::Unorm1010102) || attribute.Components >= 3);
+            sourceOffsets[a] = sourceStride;
+            offsets[a] = stride;
+            sourceStride += attribute.Components;
+
+            unsigned int size = GetEncodedSize(attribute);
+            unsigned int padding = (4 - size % 4) % 4;
+            stride += size + padding;
+            PushElement(attribute, layout);
+            if (padding > 0) {
+                layout.Pad(padding);
+            }
+
+            AttributeResult& result = fitted[a];
+            for (unsigned int c = 0; c < 4; c++) {
+                result.Offset[c] = 0.0f;
+                result.Scale[c] = 1.0f;
+            }
+            result.MaxError = 0.0f;
+        }
+
+        // The source stride is only known once every attribute is counted, the ranges are fitted here
+        for (size_t a = 0; a < attributes.size(); a++) {
+            const Attribute& attribute = attributes[a];
+            if (!attribute.FitRange || !IsNormalized(attribute.Type) || vertexCount == 0) {
+                continue;
+            }
+            AttributeResult& result = fitted[a];
+            for (unsigned int c = 0; c < attribute.Components; c++) {
+                float low = vertices[sourceOffsets[a] + c], high = low;
+                for (unsigned int v = 1; v < vertexCount; v++) {
+                    float value = vertices[(size_t)v * sourceStride + sourceOffsets[a] + c];
+                    low = std::min(low, value);
+                    high = std::max(high, value);
+                }
+                if (IsSigned(attribute.Type)) {
+                    result.Offset[c] = (low + high) * 0.5f;
+                    result.Scale[c] = (high - low) * 0.5f;
+                }
+                else {
+                    result.Offset[c] = low;
+                    result.Scale[c] = high - low;
+                }
+                if (result.Scale[c] == 0.0f) {
+                    result.Scale[c] = 1.0f;
+                }
+            }
+        }
+
+        size_t start = destination.size();
+        destination.resize(start + (size_t)vertexCount * stride, 0);
+        for (unsigned int v = 0; v < vertexCount; v++) {
+            unsigned char* vertex = destination.data() + start + (size_t)v * stride;
+            for (size_t a = 0; a < attributes.size(); a++) {
+                const Attribute& attribute = attributes[a];
+                const float* source = vertices + (size_t)v * sourceStride + sourceOffsets[a];
+                unsigned char* target = vertex + offsets[a];
+                AttributeResult& result = fitted[a];
+
+                float normalized[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+                for (unsigned int c = 0; c < attribute.Components; c++) {
+                    normalized[c] = (source[c] - result.Offset[c]) / result.Scale[c];
+                }
+                float decoded[4];
+                switch (attribute.Type) {
+                    case Encoding::Snorm1010102:
+                    case Encoding::Unorm1010102: {
+                        bool isSigned = attribute.Type == Encoding::Snorm1010102;
+                        // A missing w is written as 1, what GL would have filled in
+                        unsigned int packed = isSigned
+                            ? PackSnorm1010102(normalized[0], normalized[1], normalized[2], normalized[3])
+                            : PackUnorm1010102(normalized[0], normalized[1], normalized[2], normalized[3]);
+                        memcpy(target, &packed, 4);
+                        for (unsigned int c = 0; c < 4; c++) {
+                            unsigned int code = (packed >> (10 * c)) & (c < 3 ? 0x3ff : 0x3);
+                            unsigned int bits = c < 3 ? 10 : 2;
+                            if (isSigned) {
+                                int signedCode = (code & (1u << (bits - 1))) ? (int)code - (1 << bits) : (int)code;
+                                decoded[c] = DecodeSnorm(signedCode, bits);
+                            }
+                            else {
+                                decoded[c] = DecodeUnorm(code, bits);
+                            }
+                        }
+                        break;
+                    }
+                    case Encoding::Octahedral16:
+                    case Encoding::Octahedral8: {
+                        unsigned int bits = attribute.Type == Encoding::Octahedral16 ? 16 : 8;
+                        float length = std::sqrt(source[0] * source[0] + source[1] * source[1] + source[2] * source[2]);
+                        float unit[3] = { 0.0f, 0.0f, 1.0f };
+                        if (length > 0.0f) {
+                            unit[0] = source[0] / length;
+                            unit[1] = source[1] / length;
+                            unit[2] = source[2] / length;
+                        }
+                        int u, w;
+                        EncodeOctahedral(unit, bits, u, w);
+                        if (bits == 16) {
+                            short codes[2] = { (short)u, (short)w };
+                            memcpy(target, codes, 4);
+                        }
+                        else {
+                            signed char codes[2] = { (signed char)u, (signed char)w };
+                            memcpy(target, codes, 2);
+                        }
+                        DecodeOctahedral(DecodeSnorm(u, bits), DecodeSnorm(w, bits), decoded);
+                        // Only the direction is kept, the error is measured at the source's length
+                        for (unsigned int c = 0; c < 3; c++) {
+                            decoded[c] *= length;
+                        }
+                        break;
+                    }
+                    default: {
+                        unsigned int componentSize = GetEncodedSize(attribute) / attribute.Components;
+                        for (unsigned int c = 0; c < attribute.Components; c++) {
+                            decoded[c] = EncodeComponent(normalized[c], attribute.Type, target + c * componentSize);
+                        }
+                        break;
+                    }
+                }
+                for (unsigned int c = 0; c < attribute.Components; c++) {
+                    float error = std::fabs(decoded[c] * result.Scale[c] + result.Offset[c] - source[c]);
+                    result.MaxError = std::max(result.MaxError, error);
+                }
+            }
+        }
+
+        if (results) {
+            *results = fitted;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include "VertexBufferLayout.h"
+
+// Compact vertex formats for data cooked from float meshes: each attribute is converted to a smaller GL
+// format and the error that introduced is measured, so a caller can check it against what the mesh can take.
+// Normalized formats decode the way GL 4.2 and later define it, max(c / (2^(b-1) - 1), -1) for signed, which
+// is also what current drivers do in a 3.3 context.
+// Octahedral normals need decoding in the vertex shader:
+//	vec3 OctDecode(vec2 e) {
+//		vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+//		float t = max(-n.z, 0.0);
+//		n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+//		return normalize(n);
+//	}
+namespace VertexQuantization {
+	enum class Encoding {
+		Float,        // Kept as is
+		Half,         // GL_HALF_FLOAT, 11 significant bits, fine for positions of small meshes
+		Snorm16,      // GL_SHORT normalized
+		Unorm16,      // GL_UNSIGNED_SHORT normalized, texture coordinates
+		Snorm8,       // GL_BYTE normalized
+		Unorm8,       // GL_UNSIGNED_BYTE normalized, colors
+		Snorm1010102, // GL_INT_2_10_10_10_REV, three or four components in 4 bytes, w gets 2 bits
+		Unorm1010102, // GL_UNSIGNED_INT_2_10_10_10_REV
+		Octahedral16, // Unit vector of three floats as two snorm16 in 4 bytes
+		Octahedral8   // Unit vector as two snorm8, 2 bytes and padded to 4
+	};
+
+	struct Attribute {
+		unsigned int Components; // Floats in the source vertex
+		Encoding Type;
+		// Normalized encodings store (value - Offset) / Scale per component, fitted to the attribute's
+		// range over the mesh, instead of clamping to [-1, 1] or [0, 1]. The shader or the model matrix
+		// then has to undo it
+		bool FitRange;
+	};
+
+	struct AttributeResult {
+		float Offset[4]; // Decoded value times Scale plus Offset gives back the source value, 0 and 1 unless FitRange
+		float Scale[4];
+		float MaxError; // Largest difference of any decoded component from the source, in source units
+	};
+
+	unsigned short FloatToHalf(float value);
+	float HalfToFloat(unsigned short value);
+
+	short FloatToSnorm16(float value);
+	unsigned short FloatToUnorm16(float value);
+	signed char FloatToSnorm8(float value);
+	unsigned char FloatToUnorm8(float value);
+	// x in the lowest 10 bits, w in the highest 2
+	unsigned int PackSnorm1010102(float x, float y, float z, float w = 0.0f);
+	unsigned int PackUnorm1010102(float x, float y, float z, float w = 0.0f);
+
+	// Maps a unit vector onto the [-1, 1] square
+	void EncodeOctahedral(const float* normal, float& u, float& v);
+	void DecodeOctahedral(float u, float v, float* normal);
+	// Quantized with bits per component, also trying the neighbouring codes for the one closest to normal
+	void EncodeOctahedral(const float* normal, unsigned int bits, int& u, int& v);
+
+	// Converts vertexCount interleaved float vertices, each the attributes' components in order, into
+	// destination. Every attribute starts 4 byte aligned. layout gets the matching elements pushed and
+	// results, when given, one entry per attribute
+	void Quantize(const float* vertices, unsigned int vertexCount, const std::vector<Attribute>& attributes,
+				  std::vector<unsigned char>& destination, VertexBufferLayout& layout, std::vector<AttributeResult>* results = nullptr);
+}
@@ -0,0 +1,232 @@
+#include "VirtualTexture.h"
+
+#include <algorithm>
+#include <cmath>
+#include "Renderer.h"
+#include "Texture.h"
+#include "SamplerCache.h"
+#include "ThreadPool.h"
+#include "DeletionQueue.h"
+
+static const unsigned long long NO_TILE = ~0ull;
+
+static unsigned long long GetTileKey(int level, int x, int y) {
+    return ((unsigned long long)level << 48) | ((unsigned long long)y << 24) | (unsigned long long)x;
+}
+
+static void GetTileCoordinates(unsigned long long key, int& level, int& x, int& y) {
+    level = (int)(key >> 48);
+    y = (int)((key >> 24) & 0xFFFFFF);
+    x = (int)(key & 0xFFFFFF);
+}
+
+static int NextPowerOfTwo(int value) {
+    int result = 1;
+    while (result < value) {
+        result *= 2;
+    }
+    return result;
+}
+
+VirtualTexture::VirtualTexture(std::shared_ptr<TiledImage> image, int pagesPerSide, unsigned int maxLoading, unsigned int maxUploadsPerFrame)
+    : m_Image(std::move(image)), m_PhysicalID(0), m_IndirectionID(0), m_Frame(0), m_MaxLoading(maxLoading), m_MaxUploadsPerFrame(maxUploadsPerFrame) {
+    ASSERT(m_Image->IsOpen());
+    int pageSize = m_Image->GetPageSize();
+    int maxTextureSize;
+    GLCall(glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize));
+    // Indirection entries hold page + 1 in 16 bits
+    m_PagesPerSide = std::max(1, std::min(std::min(pagesPerSide, maxTextureSize / pageSize), 255));
+    m_PageOwners.assign(m_PagesPerSide * m_PagesPerSide, NO_TILE);
+
+    m_PhysicalID = Texture::CreateStorage(m_Image->GetGLFormat(), m_PagesPerSide * pageSize, m_PagesPerSide * pageSize, 1);
+
+    // Power of two so every level's tile grid fits in the matching mip of the indirection texture
+    int width = NextPowerOfTwo(m_Image->GetTilesX(0)), height = NextPowerOfTwo(m_Image->GetTilesY(0));
+    m_IndirectionID = Texture::CreateStorage(GL_RG8, width, height, m_Image->GetLevelCount());
+    std::vector<unsigned char> zeros((size_t)(width * 2 + 3) / 4 * 4 * height, 0);
+    for (int level = 0; level < m_Image->GetLevelCount(); level++) {
+        GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, std::max(1, width >> level), std::max(1, height >> level), GL_RG, GL_UNSIGNED_BYTE, zeros.data()));
+    }
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+    SamplerState physical;
+    physical.Filter = SamplerFilter::Linear;
+    m_PhysicalSamplerID = SamplerCache::Get().GetSampler(physical);
+    SamplerState indirection;
+    indirection.Filter = SamplerFilter::Nearest;
+    m_IndirectionSamplerID = SamplerCache::Get().GetSampler(indirection);
+
+    VirtualTextureBlock info;
+    info.ImageInfo = glm::vec4(m_Image->GetWidth(), m_Image->GetHeight(), m_Image->GetTileSize(), m_Image->GetBorder());
+    info.PhysicalInfo = glm::vec4(m_PagesPerSide * pageSize, m_PagesPerSide, m_Image->GetLevelCount(), 0.0f);
+    m_InfoBuffer = std::make_unique<UniformBuffer>(sizeof(VirtualTextureBlock), &info);
+}
+
+VirtualTexture::~VirtualTexture() {
+    // Loads still running only hold on to the image, their results are dropped with the futures
+    DeletionQueue::DeleteTexture(m_PhysicalID);
+    DeletionQueue::DeleteTexture(m_IndirectionID);
+}
+
+int VirtualTexture::GetLevel(float texelsPerPixel) const {
+    int level = (int)std::floor(std::log2(std::max(texelsPerPixel, 1.0f)));
+    return std::min(level, m_Image->GetLevelCount() - 1);
+}
+
+void VirtualTexture::Update(float u0, float v0, float u1, float v1, float texelsPerPixel) {
+    m_Frame++;
+
+    // Everything covering the view from the top level down to the one the screen needs, coarsest first so
+    // the fallbacks arrive before the detail. Marking resident tiles used keeps them from being evicted below
+    std::vector<unsigned long long> wanted;
+    int topLevel = m_Image->GetLevelCount() - 1;
+    for (int level = topLevel; level >= GetLevel(texelsPerPixel); level--) {
+        float tilesPerU = (float)std::max(1, m_Image->GetWidth() >> level) / m_Image->GetTileSize();
+        float tilesPerV = (float)std::max(1, m_Image->GetHeight() >> level) / m_Image->GetTileSize();
+        int lastX = m_Image->GetTilesX(level) - 1, lastY = m_Image->GetTilesY(level) - 1;
+        int x0 = std::min(std::max((int)std::floor(u0 * tilesPerU), 0), lastX), x1 = std::min(std::max((int)std::floor(u1 * tilesPerU), 0), lastX);
+        int y0 = std::min(std::max((int)std::floor(v0 * tilesPerV), 0), lastY), y1 = std::min(std::max((int)std::floor(v1 * tilesPerV), 0), lastY);
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                unsigned long long key = GetTileKey(level, x, y);
+                auto resident = m_Resident.find(key);
+                auto decoded = m_Decoded.find(key);
+                if (resident != m_Resident.end()) {
+                    resident->second.LastUsedFrame = m_Frame;
+                }
+                else if (decoded != m_Decoded.end()) {
+                    decoded->second.LastWantedFrame = m_Frame;
+                }
+                else if (m_Loading.find(key) == m_Loading.end() && m_Failed.find(key) == m_Failed.end()) {
+                    wanted.push_back(key);
+                }
+            }
+        }
+    }
+
+    // Tiles that found every page in use go first while they're still in view, ones that scrolled away are
+    // dropped and read again if they come back. Once a page can't be found none will be this frame
+    unsigned int uploads = 0;
+    bool full = false;
+    for (auto decoded = m_Decoded.begin(); decoded != m_Decoded.end();) {
+        if (decoded->second.LastWantedFrame != m_Frame) {
+            decoded = m_Decoded.erase(decoded);
+        }
+        else if (full || uploads == m_MaxUploadsPerFrame) {
+            decoded++;
+        }
+        else if (Upload(decoded->first, decoded->second.Data)) {
+            uploads++;
+            decoded = m_Decoded.erase(decoded);
+        }
+        else {
+            full = true;
+            decoded++;
+        }
+    }
+
+    for (auto loading = m_Loading.begin(); loading != m_Loading.end() && uploads < m_MaxUploadsPerFrame;) {
+        if (loading->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            loading++;
+            continue;
+        }
+        std::vector<unsigned char> data = loading->second.get();
+        if (data.empty()) {
+            m_Failed.insert(loading->first);
+        }
+        else if (!full && Upload(loading->first, data)) {
+            uploads++;
+        }
+        else {
+            full = true;
+            m_Decoded[loading->first] = { std::move(data), m_Frame };
+        }
+        loading = m_Loading.erase(loading);
+    }
+
+    for (unsigned long long key : wanted) {
+        if (m_Loading.size() + m_Decoded.size() >= m_MaxLoading) {
+            break; // Whatever is still wanted next frame is asked for then
+        }
+        Request(key);
+    }
+}
+
+void VirtualTexture::Bind(unsigned int slot) const {
+    GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+    GLCall(glBindSampler(slot, m_PhysicalSamplerID));
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_PhysicalID));
+    GLCall(glActiveTexture(GL_TEXTURE0 + slot + 1));
+    GLCall(glBindSampler(slot + 1, m_IndirectionSamplerID));
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_IndirectionID));
+    m_InfoBuffer->Bind(VIRTUAL_TEXTURE_BLOCK_BINDING);
+}
+
+void VirtualTexture::Request(unsigned long long key) {
+    int level, x, y;
+    GetTileCoordinates(key, level, x, y);
+    // Holds its own reference, so a load can outlive this
+    std::shared_ptr<TiledImage> image = m_Image;
+    m_Loading[key] = ThreadPool::Get().Submit([image, level, x, y]() {
+        std::vector<unsigned char> data;
+        if (!image->ReadTile(level, x, y, data)) {
+            data.clear();
+        }
+        return data;
+    });
+}
+
+int VirtualTexture::AllocatePage() {
+    int leastRecent = -1;
+    unsigned long long leastRecentFrame = m_Frame;
+    for (int page = 0; page < (int)m_PageOwners.size(); page++) {
+        unsigned long long key = m_PageOwners[page];
+        if (key == NO_TILE) {
+            return page;
+        }
+        // The top level is what every miss falls back to, it stays
+        const ResidentTile& tile = m_Resident[key];
+        if ((int)(key >> 48) != m_Image->GetLevelCount() - 1 && tile.LastUsedFrame < leastRecentFrame) {
+            leastRecent = page;
+            leastRecentFrame = tile.LastUsedFrame;
+        }
+    }
+    if (leastRecent >= 0) {
+        unsigned long long key = m_PageOwners[leastRecent];
+        SetIndirection(key, 0);
+        m_Resident.erase(key);
+        m_PageOwners[leastRecent] = NO_TILE;
+    }
+    return leastRecent;
+}
+
+bool VirtualTexture::Upload(unsigned long long key, const std::vector<unsigned char>& data) {
+    int page = AllocatePage();
+    if (page < 0) {
+        return false; // Everything resident is on screen
+    }
+
+    int pageSize = m_Image->GetPageSize();
+    int x = page % m_PagesPerSide * pageSize, y = page / m_PagesPerSide * pageSize;
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_PhysicalID));
+    if (m_Image->GetGLFormat() == GL_RGBA8) {
+        GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, pageSize, pageSize, GL_RGBA, GL_UNSIGNED_BYTE, data.data()));
+    }
+    else {
+        GLCall(glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, x, y, pageSize, pageSize, m_Image->GetGLFormat(), (GLsizei)data.size(), data.data()));
+    }
+
+    m_PageOwners[page] = key;
+    m_Resident[key] = { page, m_Frame };
+    SetIndirection(key, page + 1);
+    return true;
+}
+
+void VirtualTexture::SetIndirection(unsigned long long key, int value) {
+    int level, x, y;
+    GetTileCoordinates(key, level, x, y);
+    unsigned char entry[2] = { (unsigned char)(value & 0xFF), (unsigned char)(value >> 8) };
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_IndirectionID));
+    GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, x, y, 1, 1, GL_RG, GL_UNSIGNED_BYTE, entry));
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
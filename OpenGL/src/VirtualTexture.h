@@ -0,0 +1,71 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
+#include "TiledImage.h"
+#include "UniformBuffer.h"
+
+// Draws a TiledImage of any size through a fixed GPU page cache. Only the tiles covering the visible part
+// of the image at the level the screen needs are loaded, on the thread pool, and copied into free pages of
+// one physical texture, the least recently used ones making room once it's full.
+// An indirection texture with a level per pyramid level maps each tile to its page, 0 while not resident;
+// the shader falls back to the next coarser resident level, and the single tile of the top level is
+// always kept, so something is drawn while finer tiles are still on their way.
+// Every sample is bilinear inside one tile, there's no filtering between levels.
+class VirtualTexture {
+private:
+	struct ResidentTile {
+		int Page;
+		unsigned long long LastUsedFrame;
+	};
+
+	// Loaded while every page was in use, kept until one frees up rather than read again
+	struct DecodedTile {
+		std::vector<unsigned char> Data;
+		unsigned long long LastWantedFrame;
+	};
+
+	std::shared_ptr<TiledImage> m_Image;
+	unsigned int m_PhysicalID;
+	unsigned int m_IndirectionID;
+	int m_PagesPerSide;
+	std::vector<unsigned long long> m_PageOwners; // Tile key in each physical page, NO_TILE when free
+	std::unordered_map<unsigned long long, ResidentTile> m_Resident;
+	std::unordered_map<unsigned long long, std::future<std::vector<unsigned char>>> m_Loading;
+	std::unordered_map<unsigned long long, DecodedTile> m_Decoded; // Counts against maxLoading too
+	std::unordered_set<unsigned long long> m_Failed; // Not asked for again
+	unsigned long long m_Frame;
+	unsigned int m_MaxLoading;
+	unsigned int m_MaxUploadsPerFrame;
+	unsigned int m_PhysicalSamplerID;
+	unsigned int m_IndirectionSamplerID;
+	std::unique_ptr<UniformBuffer> m_InfoBuffer; // VirtualTextureBlock
+public:
+	// pagesPerSide squared tiles fit in the physical texture, clamped to GL_MAX_TEXTURE_SIZE
+	VirtualTexture(std::shared_ptr<TiledImage> image, int pagesPerSide = 16, unsigned int maxLoading = 32, unsigned int maxUploadsPerFrame = 8);
+	~VirtualTexture();
+
+	// Render thread, once per frame before drawing. The visible part of the image is [u0, u1] x [v0, v1], and
+	// texelsPerPixel is how many level 0 texels land on one screen pixel, which picks the level the same way
+	// the shader does
+	void Update(float u0, float v0, float u1, float v1, float texelsPerPixel);
+	// Binds the physical texture to slot, the indirection to slot + 1 and the VirtualTexture uniform block,
+	// for a shader doing VirtualTexture.shader's lookup with its samplers on those slots
+	void Bind(unsigned int slot = 0) const;
+
+	inline const TiledImage& GetImage() const { return *m_Image; }
+	inline int GetPageCount() const { return m_PagesPerSide * m_PagesPerSide; }
+	inline int GetResidentCount() const { return (int)m_Resident.size(); }
+	inline int GetLoadingCount() const { return (int)m_Loading.size(); }
+	int GetLevel(float texelsPerPixel) const;
+private:
+	void Request(unsigned long long key);
+	// Finds a free page or evicts the least recently used tile not needed this frame, -1 if every page is in use
+	int AllocatePage();
+	// False, with nothing uploaded, when AllocatePage finds no page
+	bool Upload(unsigned long long key, const std::vector<unsigned char>& data);
+	// value is the page + 1, 0 when the tile isn't resident
+	void SetIndirection(unsigned long long key, int value);
+};
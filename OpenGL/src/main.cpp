@@ -11,7 +11,14 @@
 #include "IndexBuffer.h"
 #include "VertexArray.h"
 #include "Shader.h"
+#include "ShaderLibrary.h"
 #include "Texture.h"
+#include "TextureLoader.h"
+#include "TextureResidency.h"
+#include "SamplerCache.h"
+#include "VertexArrayCache.h"
+#include "GpuResources.h"
+#include "DeletionQueue.h"
 
 // Math libraries
 #include "glm/glm.hpp"
@@ -22,6 +29,14 @@
 
 #include "tests/TestClearColor.h"
 #include "tests/TestTexture2D.h"
+#include "tests/TestTextureArray.h"
+#include "tests/TestSpriteAtlas.h"
+#include "tests/TestVirtualTexture.h"
+#include "tests/TestDynamicGeometry.h"
+#include "tests/TestMeshHeap.h"
+#include "tests/TestMeshOptimizer.h"
+#include "tests/TestVertexArrayCache.h"
+#include "tests/TestStaticGeometry.h"
 
 int main(void) {
     GLFWwindow* window;
@@ -59,6 +74,17 @@ int main(void) {
         GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
         Renderer renderer;
+        // First, so it outlives everything that queues deletions
+        DeletionQueue deletionQueue;
+        ShaderLibrary shaderLibrary;
+        // Variants used last run get compiled in the background while the rest of startup happens
+        shaderLibrary.StartWarmUp("res/shaders/warmup.txt", window);
+        SamplerCache samplerCache;
+        TextureLoader textureLoader;
+        TextureResidency textureResidency;
+        VertexArrayCache vertexArrayCache;
+        GpuResources gpuResources;
+
         // Setup ImGui binding
         ImGui::CreateContext();
         ImGui_ImplGlfwGL3_Init(window, true);
@@ -70,12 +96,25 @@ int main(void) {
 
         testMenu->RegisterTest<test::TestClearColor>("Clear Color");
         testMenu->RegisterTest<test::TestTexture2D>("2D Texture");
+        testMenu->RegisterTest<test::TestTextureArray>("Texture Array");
+        testMenu->RegisterTest<test::TestSpriteAtlas>("Sprite Atlas");
+        testMenu->RegisterTest<test::TestVirtualTexture>("Virtual Texture");
+        testMenu->RegisterTest<test::TestDynamicGeometry>("Dynamic Geometry");
+        testMenu->RegisterTest<test::TestMeshHeap>("Mesh Heap");
+        testMenu->RegisterTest<test::TestMeshOptimizer>("Mesh Optimizer");
+        testMenu->RegisterTest<test::TestVertexArrayCache>("Vertex Array Cache");
+        testMenu->RegisterTest<test::TestStaticGeometry>("Static Geometry");
 
         while (!glfwWindowShouldClose(window)) {
             /* Render here */
             GLCall(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
             renderer.Clear();
             ImGui_ImplGlfwGL3_NewFrame();
+            shaderLibrary.PollBatch();
+            textureLoader.Update();
+            textureResidency.Update();
+            // ImGui bound its own VAO last frame
+            vertexArrayCache.Invalidate();
 
             if (currentTest != nullptr) {
                 currentTest->OnUpdate(0.0f);
@@ -94,6 +133,7 @@ int main(void) {
 
             /* Swap front and back buffers */
             glfwSwapBuffers(window);
+            deletionQueue.EndFrame();
 
             /* Poll for and process events */
             glfwPollEvents();
@@ -102,6 +142,8 @@ int main(void) {
         if (currentTest != testMenu) {
             delete testMenu;
         }
+        shaderLibrary.WaitForWarmUp();
+        shaderLibrary.SaveWarmUpList("res/shaders/warmup.txt");
     }
 
     // Cleanup
@@ -0,0 +1,131 @@
+#include "TestDynamicGeometry.h"
+#include "ShaderLibrary.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <cmath>
+
+namespace test {
+	// Position, texture coordinates and color, matching Basic.shader's attributes
+	static const int VERTEX_FLOATS = 8;
+
+	TestDynamicGeometry::TestDynamicGeometry()
+		: m_Proj(glm::ortho(0.0f, 640.0f, 0.0f, 960.0f, -1.0f, 1.0f)), m_Resolution(64), m_Time(0.0f), m_UseMap(true), m_Strips(false) {
+		m_Shader = ShaderLibrary::Get().GetShader("res/shaders/Basic.shader", { "VERTEX_COLOR" });
+		m_Shader->Bind();
+		m_Shader->SetUniformBlockBinding("Camera", CAMERA_BLOCK_BINDING);
+		m_Shader->SetUniformBlockBinding("Draw", DRAW_BLOCK_BINDING);
+		m_Shader->Unbind();
+
+		m_CameraBuffer = std::make_unique<UniformBuffer>(sizeof(CameraBlock));
+		m_DrawBuffer = std::make_unique<UniformBuffer>(sizeof(DrawBlock));
+		m_DrawBuffer->SetData(DrawBlock{ glm::mat4(1.0f), glm::vec4(1.0f) });
+
+		// Sized by Resize, the contents are written every frame
+		m_VAO = std::make_unique<VertexArray>();
+		m_VertexBuffer = std::make_unique<VertexBuffer>(0, BufferUsage::Stream);
+		VertexBufferLayout layout;
+		layout.Push<float>(2); // vertex positions
+		layout.Push<float>(2); // texture coordinates
+		layout.Push<float>(4); // vertex colors
+		m_VAO->AddBuffer(*m_VertexBuffer, layout);
+		m_IndexBuffer = std::make_unique<IndexBuffer>(0, BufferUsage::Static);
+		m_VAO->Unbind();
+		m_IndexBuffer->Unbind();
+
+		Resize();
+	}
+	TestDynamicGeometry::~TestDynamicGeometry() {
+	}
+	void TestDynamicGeometry::Resize() {
+		int side = m_Resolution + 1;
+		m_VertexBuffer->Reallocate(nullptr, side * side * VERTEX_FLOATS * sizeof(float));
+		m_Row.resize(side * VERTEX_FLOATS);
+
+		std::vector<unsigned int> indices;
+		for (int y = 0; y < m_Resolution; y++) {
+			if (m_Strips) {
+				// Zigzags up the row, a third of the indices triangles need
+				if (y > 0) {
+					indices.push_back(IndexBuffer::RESTART);
+				}
+				for (int x = 0; x < side; x++) {
+					indices.push_back(y * side + x);
+					indices.push_back((y + 1) * side + x);
+				}
+				continue;
+			}
+			for (int x = 0; x < m_Resolution; x++) {
+				unsigned int first = y * side + x;
+				unsigned int quad[] = { first, first + 1, first + side + 1, first + side + 1, first + side, first };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+		m_IndexBuffer->Reallocate(indices.data(), (unsigned int)indices.size());
+	}
+	void TestDynamicGeometry::WriteVertices(float* vertices, int row) {
+		int side = m_Resolution + 1;
+		float size = 560.0f / m_Resolution;
+		for (int x = 0; x < side; x++) {
+			float u = (float)x / m_Resolution, v = (float)row / m_Resolution;
+			float wave = std::sin(u * 9.0f + m_Time * 2.0f) * std::cos(v * 7.0f - m_Time * 1.3f);
+			float* vertex = vertices + x * VERTEX_FLOATS;
+			vertex[0] = 40.0f + x * size + wave * 6.0f;
+			vertex[1] = 200.0f + row * size + wave * 18.0f;
+			vertex[2] = u;
+			vertex[3] = v;
+			vertex[4] = 0.5f + 0.5f * wave;
+			vertex[5] = 0.3f + 0.4f * v;
+			vertex[6] = 1.0f - 0.5f * (0.5f + 0.5f * wave);
+			vertex[7] = 1.0f;
+		}
+	}
+	void TestDynamicGeometry::OnUpdate(float deltaTime) {
+		// The test menu passes no frame time
+		m_Time += 1.0f / 60.0f;
+	}
+	void TestDynamicGeometry::OnRender() {
+		GLCall(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+		int side = m_Resolution + 1;
+		if (m_UseMap) {
+			// Mapping the whole buffer orphans it, last frame's draw keeps its own copy
+			float* vertices = (float*)m_VertexBuffer->Map(0, m_VertexBuffer->GetSize());
+			if (vertices) {
+				for (int row = 0; row < side; row++) {
+					WriteVertices(vertices + row * side * VERTEX_FLOATS, row);
+				}
+				m_VertexBuffer->Unmap();
+			}
+		}
+		else {
+			// The rows touch, so Flush sends them as one run covering the buffer, which orphans it too
+			unsigned int rowBytes = (unsigned int)(m_Row.size() * sizeof(float));
+			for (int row = 0; row < side; row++) {
+				WriteVertices(m_Row.data(), row);
+				m_VertexBuffer->SetData(m_Row.data(), rowBytes, row * rowBytes);
+			}
+			m_VertexBuffer->Flush();
+		}
+
+		m_CameraBuffer->SetData(CameraBlock{ m_Proj });
+		m_CameraBuffer->Bind(CAMERA_BLOCK_BINDING);
+		m_DrawBuffer->Bind(DRAW_BLOCK_BINDING);
+
+		Renderer renderer;
+		renderer.Draw(*m_VAO, *m_IndexBuffer, *m_Shader, m_Strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES);
+	}
+	void TestDynamicGeometry::OnImGuiRender() {
+		if (ImGui::SliderInt("Resolution", &m_Resolution, 1, 256)) {
+			Resize();
+		}
+		if (ImGui::Checkbox("Triangle strips", &m_Strips)) {
+			Resize();
+		}
+		ImGui::Checkbox("Map (else SetData per row)", &m_UseMap);
+		ImGui::Text("%d vertices rewritten per frame", (m_Resolution + 1) * (m_Resolution + 1));
+		ImGui::Text("%u %d-bit indices, %.1f KB", m_IndexBuffer->GetCount(), m_IndexBuffer->GetIndexSize() * 8,
+					m_IndexBuffer->GetCount() * m_IndexBuffer->GetIndexSize() / 1024.0f);
+		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "IndexBuffer.h"
+#include "UniformBuffer.h"
+#include "Test.h"
+#include <memory>
+#include <vector>
+
+namespace test {
+	// A waving grid whose vertices are all rewritten every frame into the same streaming VertexBuffer,
+	// either through Map or through one SetData per row that Flush merges into a single upload.
+	// Changing the resolution reallocates the buffers in place instead of recreating them. The grid is
+	// indexed as triangles or as one strip per row separated by primitive restarts, 16-bit either way up
+	// to 255x255 quads
+	class TestDynamicGeometry : public Test {
+	private:
+		std::unique_ptr<VertexArray> m_VAO;
+		std::unique_ptr<VertexBuffer> m_VertexBuffer;
+		std::unique_ptr<IndexBuffer> m_IndexBuffer;
+		std::shared_ptr<Shader> m_Shader;
+		std::unique_ptr<UniformBuffer> m_CameraBuffer;
+		std::unique_ptr<UniformBuffer> m_DrawBuffer;
+		std::vector<float> m_Row; // One row of vertices for the SetData path
+
+		glm::mat4 m_Proj;
+		int m_Resolution; // Quads along each side
+		float m_Time;
+		bool m_UseMap;
+		bool m_Strips;
+
+		void Resize();
+		void WriteVertices(float* vertices, int row);
+	public:
+		TestDynamicGeometry();
+		~TestDynamicGeometry();
+
+		void OnUpdate(float deltaTime) override;
+		void OnRender() override;
+		void OnImGuiRender() override;
+	};
+}
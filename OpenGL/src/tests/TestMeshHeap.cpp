@@ -0,0 +1,120 @@
+#include "TestMeshHeap.h"
+#include "ShaderLibrary.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <cmath>
+
+namespace test {
+	// Matching Basic.shader's attributes
+	struct PolygonVertex {
+		glm::vec2 Position;
+		glm::vec2 TexCoord;
+		glm::vec4 Color;
+	};
+
+	static constexpr auto POLYGON_LAYOUT = MakeVertexLayout<PolygonVertex>(
+		VERTEX_ATTRIBUTE(PolygonVertex, Position),
+		VERTEX_ATTRIBUTE(PolygonVertex, TexCoord),
+		VERTEX_ATTRIBUTE(PolygonVertex, Color));
+
+	TestMeshHeap::TestMeshHeap()
+		: m_Random(12345), m_Proj(glm::ortho(0.0f, 640.0f, 0.0f, 960.0f, -1.0f, 1.0f)), m_MultiDraw(true), m_Churn(false), m_DefragmentKB(64) {
+		m_Shader = ShaderLibrary::Get().GetShader("res/shaders/Basic.shader", { "VERTEX_COLOR" });
+		m_Shader->Bind();
+		m_Shader->SetUniformBlockBinding("Camera", CAMERA_BLOCK_BINDING);
+		m_Shader->SetUniformBlockBinding("Draw", DRAW_BLOCK_BINDING);
+		m_Shader->Unbind();
+
+		m_CameraBuffer = std::make_unique<UniformBuffer>(sizeof(CameraBlock));
+		m_DrawBuffer = std::make_unique<UniformBuffer>(sizeof(DrawBlock));
+		m_DrawBuffer->SetData(DrawBlock{ glm::mat4(1.0f), glm::vec4(1.0f) });
+
+		// Deliberately small, the first batch already makes it grow
+		m_Heap = std::make_unique<MeshHeap>(POLYGON_LAYOUT, 4096, 12288);
+
+		AddPolygons(2000);
+	}
+	TestMeshHeap::~TestMeshHeap() {
+	}
+	float TestMeshHeap::NextRandom() {
+		m_Random = m_Random * 1664525u + 1013904223u;
+		return (m_Random >> 8) / 16777216.0f;
+	}
+	void TestMeshHeap::AddPolygons(int count) {
+		std::vector<PolygonVertex> vertices;
+		std::vector<unsigned int> indices;
+		for (int i = 0; i < count; i++) {
+			// Triangle fans from 3 to 48 sides, so ranges of very different sizes come and go
+			int sides = 3 + (int)(NextRandom() * NextRandom() * 46.0f);
+			float x = 20.0f + NextRandom() * 600.0f, y = 20.0f + NextRandom() * 920.0f;
+			float radius = 4.0f + NextRandom() * 10.0f;
+			glm::vec4 color(0.3f + 0.7f * NextRandom(), 0.3f + 0.7f * NextRandom(), 0.3f + 0.7f * NextRandom(), 1.0f);
+
+			vertices.clear();
+			for (int side = 0; side < sides; side++) {
+				float angle = 6.2831853f * side / sides;
+				glm::vec2 direction(std::cos(angle), std::sin(angle));
+				vertices.push_back({ glm::vec2(x, y) + direction * radius, 0.5f + 0.5f * direction, color });
+			}
+			indices.clear();
+			for (int side = 1; side + 1 < sides; side++) {
+				unsigned int triangle[] = { 0, (unsigned int)side, (unsigned int)side + 1 };
+				indices.insert(indices.end(), triangle, triangle + 3);
+			}
+			m_Meshes.push_back(m_Heap->Add(vertices.data(), sides, indices.data(), (unsigned int)indices.size()));
+		}
+	}
+	void TestMeshHeap::RemovePolygons(int count) {
+		for (int i = 0; i < count && !m_Meshes.empty(); i++) {
+			int index = (int)(NextRandom() * m_Meshes.size());
+			m_Heap->Remove(m_Meshes[index]);
+			m_Meshes[index] = m_Meshes.back();
+			m_Meshes.pop_back();
+		}
+	}
+	void TestMeshHeap::OnUpdate(float deltaTime) {
+		if (m_Churn) {
+			RemovePolygons(20);
+			AddPolygons(20);
+		}
+		m_Heap->Defragment(m_DefragmentKB * 1024);
+	}
+	void TestMeshHeap::OnRender() {
+		GLCall(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+		m_CameraBuffer->SetData(CameraBlock{ m_Proj });
+		m_CameraBuffer->Bind(CAMERA_BLOCK_BINDING);
+		m_DrawBuffer->Bind(DRAW_BLOCK_BINDING);
+
+		if (m_MultiDraw) {
+			m_Heap->Draw(m_Meshes, *m_Shader);
+		}
+		else {
+			for (int mesh : m_Meshes) {
+				m_Heap->Draw(mesh, *m_Shader);
+			}
+		}
+	}
+	void TestMeshHeap::OnImGuiRender() {
+		if (ImGui::Button("Add 1000")) {
+			AddPolygons(1000);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Remove half")) {
+			RemovePolygons((int)m_Meshes.size() / 2);
+		}
+		ImGui::Checkbox("Churn", &m_Churn);
+		ImGui::SameLine();
+		ImGui::Checkbox("Multi-draw", &m_MultiDraw);
+		ImGui::SliderInt("Defragment KB per frame", &m_DefragmentKB, 0, 1024);
+
+		const OffsetAllocator& vertices = m_Heap->GetVertexAllocator();
+		const OffsetAllocator& indices = m_Heap->GetIndexAllocator();
+		ImGui::Text("%u meshes, %d draw calls", m_Heap->GetMeshCount(), m_MultiDraw ? 1 : (int)m_Meshes.size());
+		ImGui::Text("Vertices: %u of %u free, largest free range %u", vertices.GetFreeSize(), vertices.GetSize(), vertices.GetLargestFreeSize());
+		ImGui::Text("Indices: %u of %u free, largest free range %u", indices.GetFreeSize(), indices.GetSize(), indices.GetLargestFreeSize());
+		ImGui::Text("Defragment moved %.1f KB in total", m_Heap->GetMovedBytes() / 1024.0f);
+		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+	}
+}
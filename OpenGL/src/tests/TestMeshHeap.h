@@ -0,0 +1,38 @@
+#pragma once
+
+#include "MeshHeap.h"
+#include "UniformBuffer.h"
+#include "Test.h"
+#include <memory>
+#include <vector>
+
+namespace test {
+	// Thousands of small polygons of varying size living in one MeshHeap. Adding and removing them at
+	// random fragments the heap, which Defragment closes up a budget at a time, and all of them go out in
+	// a single multi-draw or, for comparison, one draw each
+	class TestMeshHeap : public Test {
+	private:
+		std::unique_ptr<MeshHeap> m_Heap;
+		std::shared_ptr<Shader> m_Shader;
+		std::unique_ptr<UniformBuffer> m_CameraBuffer;
+		std::unique_ptr<UniformBuffer> m_DrawBuffer;
+		std::vector<int> m_Meshes;
+		unsigned int m_Random;
+
+		glm::mat4 m_Proj;
+		bool m_MultiDraw;
+		bool m_Churn; // Swaps some meshes every frame
+		int m_DefragmentKB; // Per frame
+
+		float NextRandom();
+		void AddPolygons(int count);
+		void RemovePolygons(int count);
+	public:
+		TestMeshHeap();
+		~TestMeshHeap();
+
+		void OnUpdate(float deltaTime) override;
+		void OnRender() override;
+		void OnImGuiRender() override;
+	};
+}
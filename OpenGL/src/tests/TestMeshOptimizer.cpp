@@ -0,0 +1,183 @@
+#include "TestMeshOptimizer.h"
+#include "ShaderLibrary.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace test {
+	// Matching Basic.shader's attributes
+	struct TorusVertex {
+		glm::vec3 Position;
+		glm::vec2 TexCoord;
+		glm::vec4 Color;
+	};
+
+	static constexpr auto TORUS_LAYOUT = MakeVertexLayout<TorusVertex>(
+		VERTEX_ATTRIBUTE(TorusVertex, Position),
+		VERTEX_ATTRIBUTE(TorusVertex, TexCoord),
+		VERTEX_ATTRIBUTE(TorusVertex, Color));
+	static const int RINGS = 384;
+	static const int SIDES = 96;
+
+	TestMeshOptimizer::TestMeshOptimizer() : m_PositionError(0.0f), m_Current(1), m_Instances(4), m_Angle(0.0f) {
+		m_Shader = ShaderLibrary::Get().GetShader("res/shaders/Basic.shader", { "VERTEX_COLOR" });
+		m_Shader->Bind();
+		m_Shader->SetUniformBlockBinding("Camera", CAMERA_BLOCK_BINDING);
+		m_Shader->SetUniformBlockBinding("Draw", DRAW_BLOCK_BINDING);
+		m_Shader->Unbind();
+		m_CameraBuffer = std::make_unique<UniformBuffer>(sizeof(CameraBlock));
+		m_DrawBuffer = std::make_unique<UniformRingBuffer>(64 * 1024);
+
+		std::vector<TorusVertex> vertices;
+		for (int ring = 0; ring < RINGS; ring++) {
+			float u = 6.2831853f * ring / RINGS;
+			for (int side = 0; side < SIDES; side++) {
+				float v = 6.2831853f * side / SIDES;
+				glm::vec3 normal(std::cos(u) * std::cos(v), std::sin(v), std::sin(u) * std::cos(v));
+				glm::vec3 position = glm::vec3(std::cos(u), 0.0f, std::sin(u)) + normal * 0.35f;
+				float light = 0.25f + 0.75f * std::max(0.0f, glm::dot(normal, glm::normalize(glm::vec3(0.4f, 0.8f, 0.6f))));
+				vertices.push_back({ position, glm::vec2((float)ring / RINGS, (float)side / SIDES),
+									 glm::vec4(light * 0.9f, light * 0.6f, light * 0.3f, 1.0f) });
+			}
+		}
+		std::vector<unsigned int> indices;
+		for (int ring = 0; ring < RINGS; ring++) {
+			for (int side = 0; side < SIDES; side++) {
+				unsigned int a = ring * SIDES + side, b = ring * SIDES + (side + 1) % SIDES;
+				unsigned int c = (ring + 1) % RINGS * SIDES + side, d = (ring + 1) % RINGS * SIDES + (side + 1) % SIDES;
+				unsigned int quad[] = { a, b, d, d, c, a };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+
+		// Shuffles the triangles and renumbers the vertices at random
+		unsigned int vertexCount = (unsigned int)vertices.size();
+		std::mt19937 random(7);
+		std::vector<unsigned int> order(indices.size() / 3);
+		for (unsigned int i = 0; i < order.size(); i++) {
+			order[i] = i;
+		}
+		std::shuffle(order.begin(), order.end(), random);
+		std::vector<unsigned int> renumber(vertexCount);
+		for (unsigned int i = 0; i < vertexCount; i++) {
+			renumber[i] = i;
+		}
+		std::shuffle(renumber.begin(), renumber.end(), random);
+		std::vector<unsigned int> shuffledIndices;
+		for (unsigned int triangle : order) {
+			for (int corner = 0; corner < 3; corner++) {
+				shuffledIndices.push_back(renumber[indices[triangle * 3 + corner]]);
+			}
+		}
+		std::vector<TorusVertex> shuffledVertices(vertices.size());
+		for (unsigned int i = 0; i < vertexCount; i++) {
+			shuffledVertices[renumber[i]] = vertices[i];
+		}
+		Upload(m_Meshes[0], shuffledVertices.data(), vertexCount, TORUS_LAYOUT, shuffledIndices);
+		m_Meshes[0].Milliseconds = 0.0f;
+
+		std::vector<unsigned char> optimizedVertices((const unsigned char*)shuffledVertices.data(),
+													 (const unsigned char*)(shuffledVertices.data() + shuffledVertices.size()));
+		auto start = std::chrono::steady_clock::now();
+		MeshOptimizer::Optimize(shuffledIndices, optimizedVertices, sizeof(TorusVertex), offsetof(TorusVertex, Position));
+		float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		unsigned int optimizedCount = (unsigned int)(optimizedVertices.size() / sizeof(TorusVertex));
+		Upload(m_Meshes[1], optimizedVertices.data(), optimizedCount, TORUS_LAYOUT, shuffledIndices);
+		m_Meshes[1].Milliseconds = milliseconds;
+
+		// Positions fitted to the torus's bounds, which the draw's model matrix undoes
+		std::vector<VertexQuantization::Attribute> attributes = {
+			{ 3, VertexQuantization::Encoding::Unorm16, true },
+			{ 2, VertexQuantization::Encoding::Unorm16, false },
+			{ 4, VertexQuantization::Encoding::Unorm8, false }
+		};
+		std::vector<float> optimized(optimizedVertices.size() / sizeof(float));
+		memcpy(optimized.data(), optimizedVertices.data(), optimizedVertices.size());
+		std::vector<unsigned char> quantized;
+		VertexBufferLayout quantizedLayout;
+		std::vector<VertexQuantization::AttributeResult> results;
+		VertexQuantization::Quantize(optimized.data(), optimizedCount, attributes, quantized, quantizedLayout, &results);
+		Upload(m_Meshes[2], quantized.data(), optimizedCount, quantizedLayout, shuffledIndices);
+		const float* offset = results[0].Offset;
+		const float* scale = results[0].Scale;
+		m_Meshes[2].Dequantize = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(offset[0], offset[1], offset[2])),
+											glm::vec3(scale[0], scale[1], scale[2]));
+		m_Meshes[2].Milliseconds = milliseconds;
+		m_PositionError = results[0].MaxError;
+	}
+	TestMeshOptimizer::~TestMeshOptimizer() {
+		GLCall(glDisable(GL_DEPTH_TEST));
+	}
+	void TestMeshOptimizer::Upload(Mesh& mesh, const void* vertices, unsigned int vertexCount, const VertexBufferLayout& layout,
+								   const std::vector<unsigned int>& indices) {
+		mesh.VertexSize = layout.GetStride();
+		mesh.Dequantize = glm::mat4(1.0f);
+		mesh.Cache = MeshOptimizer::AnalyzeVertexCache(indices.data(), (unsigned int)indices.size(), vertexCount);
+		mesh.Fetch = MeshOptimizer::AnalyzeVertexFetch(indices.data(), (unsigned int)indices.size(), vertexCount, mesh.VertexSize);
+
+		mesh.VAO = std::make_unique<VertexArray>();
+		mesh.Vertices = std::make_unique<VertexBuffer>(vertices, vertexCount * mesh.VertexSize);
+		mesh.VAO->AddBuffer(*mesh.Vertices, layout);
+		mesh.Indices = std::make_unique<IndexBuffer>(indices.data(), (unsigned int)indices.size());
+		mesh.VAO->Unbind();
+		mesh.Indices->Unbind();
+	}
+	void TestMeshOptimizer::OnUpdate(float deltaTime) {
+		// The test menu passes no frame time
+		m_Angle += 0.01f;
+	}
+	void TestMeshOptimizer::OnRender() {
+		GLCall(glClearColor(0.05f, 0.05f, 0.08f, 1.0f));
+		GLCall(glEnable(GL_DEPTH_TEST));
+		GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+		int viewport[4];
+		GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+		float extent = m_Instances * 1.5f;
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)viewport[2] / viewport[3], 0.1f, 100.0f);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f, extent * 0.6f, extent * 1.6f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		m_CameraBuffer->SetData(CameraBlock{ projection * view });
+		m_CameraBuffer->Bind(CAMERA_BLOCK_BINDING);
+
+		// Each instance is its own draw, all of them out of the same buffers
+		m_DrawBuffer->Reset();
+		const Mesh& mesh = m_Meshes[m_Current];
+		std::vector<unsigned int> draws;
+		for (int z = 0; z < m_Instances; z++) {
+			for (int x = 0; x < m_Instances; x++) {
+				glm::vec3 offset((x - (m_Instances - 1) * 0.5f) * 3.0f, 0.0f, (z - (m_Instances - 1) * 0.5f) * 3.0f);
+				glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), offset), m_Angle + x + z, glm::vec3(1.0f, 0.3f, 0.0f));
+				draws.push_back(m_DrawBuffer->Allocate(DrawBlock{ model * mesh.Dequantize, glm::vec4(1.0f) }));
+			}
+		}
+		m_DrawBuffer->Upload();
+
+		Renderer renderer;
+		for (unsigned int draw : draws) {
+			m_DrawBuffer->BindRange(DRAW_BLOCK_BINDING, draw, sizeof(DrawBlock));
+			renderer.Draw(*mesh.VAO, *mesh.Indices, *m_Shader);
+		}
+	}
+	void TestMeshOptimizer::OnImGuiRender() {
+		ImGui::RadioButton("Shuffled", &m_Current, 0);
+		ImGui::SameLine();
+		ImGui::RadioButton("Optimized", &m_Current, 1);
+		ImGui::SameLine();
+		ImGui::RadioButton("Quantized", &m_Current, 2);
+		ImGui::SliderInt("Instances per side", &m_Instances, 1, 12);
+
+		const char* names[] = { "Shuffled", "Optimized", "Quantized" };
+		for (int i = 0; i < 3; i++) {
+			const Mesh& mesh = m_Meshes[i];
+			ImGui::Text("%s: %u byte vertices, ACMR %.3f, ATVR %.3f, overfetch %.2f", names[i], mesh.VertexSize,
+						mesh.Cache.ACMR, mesh.Cache.ATVR, mesh.Fetch.Overfetch);
+		}
+		ImGui::Text("Quantized positions are off by at most %.6f", m_PositionError);
+		ImGui::Text("%d triangles per instance, optimized in %.1f ms", RINGS * SIDES * 2, m_Meshes[1].Milliseconds);
+		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+	}
+}
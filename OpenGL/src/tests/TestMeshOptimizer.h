@@ -0,0 +1,48 @@
+#pragma once
+
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "IndexBuffer.h"
+#include "MeshOptimizer.h"
+#include "VertexQuantization.h"
+#include "UniformBuffer.h"
+#include "Test.h"
+#include <memory>
+
+namespace test {
+	// A dense torus with its triangles and vertices shuffled, as meshes out of some exporters are, drawn many
+	// times over next to the same mesh after MeshOptimizer::Optimize, with each one's ACMR, ATVR and overfetch.
+	// The quantized copy is the optimized one with 16-bit positions and texture coordinates and 8-bit colors
+	class TestMeshOptimizer : public Test {
+	private:
+		struct Mesh {
+			std::unique_ptr<VertexArray> VAO;
+			std::unique_ptr<VertexBuffer> Vertices;
+			std::unique_ptr<IndexBuffer> Indices;
+			MeshOptimizer::VertexCacheStats Cache;
+			MeshOptimizer::VertexFetchStats Fetch;
+			unsigned int VertexSize;
+			glm::mat4 Dequantize; // Scale and offset of the quantized positions, applied before the model matrix
+			float Milliseconds; // Spent optimizing
+		};
+
+		Mesh m_Meshes[3]; // Shuffled, optimized, optimized and quantized
+		float m_PositionError;
+		std::shared_ptr<Shader> m_Shader;
+		std::unique_ptr<UniformBuffer> m_CameraBuffer;
+		std::unique_ptr<UniformRingBuffer> m_DrawBuffer;
+		int m_Current;
+		int m_Instances; // Per side of the grid
+		float m_Angle;
+
+		void Upload(Mesh& mesh, const void* vertices, unsigned int vertexCount, const VertexBufferLayout& layout,
+					const std::vector<unsigned int>& indices);
+	public:
+		TestMeshOptimizer();
+		~TestMeshOptimizer();
+
+		void OnUpdate(float deltaTime) override;
+		void OnRender() override;
+		void OnImGuiRender() override;
+	};
+}
@@ -0,0 +1,148 @@
+#include "TestSpriteAtlas.h"
+#include "ShaderLibrary.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace test {
+	static const float VIEW_WIDTH = 640.0f;
+	static const float VIEW_HEIGHT = 960.0f;
+	static const float SPACING = 8.0f;
+
+	TestSpriteAtlas::TestSpriteAtlas() : m_NextSprite(0), m_SearchName(), m_Proj(glm::ortho(0.0f, VIEW_WIDTH, 0.0f, VIEW_HEIGHT, -1.0f, 1.0f)) {
+		m_Shader = ShaderLibrary::Get().GetShader("res/shaders/Sprite.shader");
+		m_Shader->Bind();
+		m_Shader->SetUniformBlockBinding("Camera", CAMERA_BLOCK_BINDING);
+		m_Shader->SetUniform1i("u_Textures", 0);
+		m_Shader->Unbind();
+
+		m_CameraBuffer = std::make_unique<UniformBuffer>(sizeof(CameraBlock));
+
+		m_Atlas = SpriteAtlas::Load("res/textures/sprites.atlas");
+		m_SourceName = "res/textures/sprites.atlas";
+		if (!m_Atlas) {
+			// Small pages so a few rounds of adding open new ones
+			m_Atlas = std::make_unique<SpriteAtlas>(256, 4);
+			m_SourceName = "Generated sprites";
+			AddSprites(24);
+		}
+		BuildSprites();
+	}
+	TestSpriteAtlas::~TestSpriteAtlas() {
+	}
+	void TestSpriteAtlas::AddSprites(int count) {
+		// Soft edged discs and rings of assorted sizes and colors, straight alpha like anything added at runtime
+		std::vector<unsigned char> rgba;
+		for (int i = 0; i < count; i++) {
+			int sprite = m_NextSprite++;
+			int width = 16 + sprite * 37 % 80, height = 16 + sprite * 53 % 80;
+			unsigned char color[3] = { (unsigned char)(sprite * 97 + 40), (unsigned char)(sprite * 57 + 120), (unsigned char)(sprite * 31 + 200) };
+			bool ring = sprite % 3 == 0;
+			rgba.resize((size_t)width * height * 4);
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					float dx = (x + 0.5f) / width * 2.0f - 1.0f, dy = (y + 0.5f) / height * 2.0f - 1.0f;
+					float distance = std::sqrt(dx * dx + dy * dy);
+					float coverage = ring ? 1.0f - std::abs(distance - 0.75f) * 8.0f : (1.0f - distance) * 8.0f;
+					unsigned char* texel = &rgba[((size_t)y * width + x) * 4];
+					for (int c = 0; c < 3; c++) {
+						texel[c] = color[c];
+					}
+					texel[3] = (unsigned char)(std::min(1.0f, std::max(0.0f, coverage)) * 255.0f);
+				}
+			}
+			m_Atlas->Add(width, height, rgba.data());
+		}
+		// One upload for the whole burst
+		m_Atlas->Upload();
+	}
+	void TestSpriteAtlas::BuildSprites() {
+		// Left to right, bottom to top, each sprite at its texel size scaled down to fit the view's width
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+		float x = SPACING, y = SPACING, rowHeight = 0.0f;
+		for (int i = 0; i < m_Atlas->GetRegionCount(); i++) {
+			const AtlasBuilder::Region& region = m_Atlas->GetRegion(i);
+			float scale = std::min(1.0f, (VIEW_WIDTH - 2.0f * SPACING) / region.Width);
+			float width = region.Width * scale, height = region.Height * scale;
+			if (x + width > VIEW_WIDTH - SPACING) {
+				x = SPACING;
+				y += rowHeight + SPACING;
+				rowHeight = 0.0f;
+			}
+			float layer = (float)region.Page;
+			unsigned int first = (unsigned int)vertices.size() / 5;
+			float quad[] = {
+				x,         y,          region.U0, region.V0, layer,
+				x + width, y,          region.U1, region.V0, layer,
+				x + width, y + height, region.U1, region.V1, layer,
+				x,         y + height, region.U0, region.V1, layer
+			};
+			vertices.insert(vertices.end(), quad, quad + 20);
+			unsigned int quadIndices[] = { first, first + 1, first + 2, first + 2, first + 3, first };
+			indices.insert(indices.end(), quadIndices, quadIndices + 6);
+			x += width + SPACING;
+			rowHeight = std::max(rowHeight, height);
+		}
+
+		m_VAO = std::make_unique<VertexArray>();
+		m_VertexBuffer = std::make_unique<VertexBuffer>(vertices.data(), (unsigned int)(vertices.size() * sizeof(float)));
+		VertexBufferLayout layout;
+		layout.Push<float>(2); // vertex positions
+		layout.Push<float>(2); // texture coordinates
+		layout.Push<float>(1); // atlas page
+		m_VAO->AddBuffer(*m_VertexBuffer, layout);
+		m_IndexBuffer = std::make_unique<IndexBuffer>(indices.data(), (unsigned int)indices.size());
+
+		m_VAO->Unbind();
+		m_IndexBuffer->Unbind();
+	}
+	void TestSpriteAtlas::OnUpdate(float deltaTime) {
+	}
+	void TestSpriteAtlas::OnRender() {
+		GLCall(glClearColor(0.1f, 0.1f, 0.1f, 1.0f));
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		if (m_IndexBuffer->GetCount() == 0) {
+			return;
+		}
+
+		Renderer renderer;
+
+		m_CameraBuffer->SetData(CameraBlock{ m_Proj });
+		m_CameraBuffer->Bind(CAMERA_BLOCK_BINDING);
+
+		// Cooked pages come premultiplied, generated ones don't
+		bool premultiplied = m_Atlas->GetTextureArray().IsPremultiplied();
+		if (premultiplied) {
+			GLCall(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+		}
+		m_Atlas->Bind();
+		renderer.Draw(*m_VAO, *m_IndexBuffer, *m_Shader);
+		if (premultiplied) {
+			GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+		}
+	}
+	void TestSpriteAtlas::OnImGuiRender() {
+		ImGui::Text("Source: %s", m_SourceName.c_str());
+		if (m_Atlas->IsCooked()) {
+			// Names are the image paths as given to TextureCooker
+			ImGui::InputText("Sprite name", m_SearchName, sizeof(m_SearchName));
+			int index = m_Atlas->Find(m_SearchName);
+			if (index >= 0) {
+				const AtlasBuilder::Region& region = m_Atlas->GetRegion(index);
+				ImGui::Text("Page %d at %d, %d, %dx%d", region.Page, region.X, region.Y, region.Width, region.Height);
+			}
+			else if (m_SearchName[0]) {
+				ImGui::Text("Not in the atlas");
+			}
+		}
+		else if (ImGui::Button("Add sprites")) {
+			AddSprites(8);
+			BuildSprites();
+		}
+		ImGui::Text("%d sprites on %d pages, 1 draw call", m_Atlas->GetRegionCount(), m_Atlas->GetPageCount());
+		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+	}
+}
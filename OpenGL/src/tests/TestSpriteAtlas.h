@@ -0,0 +1,40 @@
+#pragma once
+
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "IndexBuffer.h"
+#include "SpriteAtlas.h"
+#include "UniformBuffer.h"
+#include "Test.h"
+#include <memory>
+#include <string>
+
+namespace test {
+	// Every sprite of an atlas laid out at its own size and drawn with one bind and one draw call.
+	// Shows res/textures/sprites.atlas from TextureCooker --atlas when there is one, else generated sprites
+	// packed at runtime, which more can be added to
+	class TestSpriteAtlas : public Test {
+	private:
+		std::unique_ptr<VertexArray> m_VAO;
+		std::unique_ptr<VertexBuffer> m_VertexBuffer;
+		std::unique_ptr<IndexBuffer> m_IndexBuffer;
+		std::shared_ptr<Shader> m_Shader;
+		std::unique_ptr<UniformBuffer> m_CameraBuffer;
+		std::unique_ptr<SpriteAtlas> m_Atlas;
+		std::string m_SourceName;
+		int m_NextSprite;
+		char m_SearchName[256]; // Cooked sprite to look up by name
+
+		glm::mat4 m_Proj;
+
+		void AddSprites(int count);
+		void BuildSprites();
+	public:
+		TestSpriteAtlas();
+		~TestSpriteAtlas();
+
+		void OnUpdate(float deltaTime) override;
+		void OnRender() override;
+		void OnImGuiRender() override;
+	};
+}
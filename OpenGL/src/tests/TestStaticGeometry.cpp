@@ -0,0 +1,166 @@
+#include "TestStaticGeometry.h"
+#include "ShaderLibrary.h"
+#include "VertexArrayCache.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <chrono>
+#include <cmath>
+
+namespace test {
+	static const float WORLD_WIDTH = 2560.0f;
+	static const float WORLD_HEIGHT = 3840.0f;
+	static const float CELL_SIZE = 320.0f;
+	// The per object path allocates a draw block for each, at most 256 bytes apart
+	static const int MAX_OBJECTS = 40000;
+
+	// Tint of each material, multiplied with the vertex colors
+	static const glm::vec4 MATERIAL_COLORS[] = {
+		glm::vec4(1.0f, 0.55f, 0.4f, 1.0f),
+		glm::vec4(0.45f, 0.9f, 0.5f, 1.0f),
+		glm::vec4(0.5f, 0.65f, 1.0f, 1.0f)
+	};
+
+	// Unit sized fan around the origin, radius alternating between outer and inner for stars, lighter in the middle
+	static std::shared_ptr<StaticMesh> MakeShape(int points, float inner) {
+		auto mesh = std::make_shared<StaticMesh>();
+		mesh->Vertices.push_back({ glm::vec3(0.0f), glm::vec2(0.5f), glm::vec4(1.0f) });
+		int corners = inner < 1.0f ? points * 2 : points;
+		for (int corner = 0; corner < corners; corner++) {
+			float angle = 6.2831853f * corner / corners;
+			float radius = corner % 2 == 1 && inner < 1.0f ? inner : 1.0f;
+			glm::vec2 direction(std::cos(angle), std::sin(angle));
+			mesh->Vertices.push_back({ glm::vec3(direction * radius, 0.0f), 0.5f + 0.5f * direction, glm::vec4(0.6f, 0.6f, 0.6f, 1.0f) });
+			unsigned int triangle[] = { 0, 1 + (unsigned int)corner, 1 + (unsigned int)((corner + 1) % corners) };
+			mesh->Indices.insert(mesh->Indices.end(), triangle, triangle + 3);
+		}
+		return mesh;
+	}
+
+	TestStaticGeometry::TestStaticGeometry()
+		: m_Random(777), m_Baked(true), m_Camera(0.0f), m_Zoom(1.0f), m_DrawCalls(0), m_RebuildMilliseconds(0.0f), m_LastRebuild() {
+		m_Shader = ShaderLibrary::Get().GetShader("res/shaders/Basic.shader", { "VERTEX_COLOR" });
+		m_Shader->Bind();
+		m_Shader->SetUniformBlockBinding("Camera", CAMERA_BLOCK_BINDING);
+		m_Shader->SetUniformBlockBinding("Draw", DRAW_BLOCK_BINDING);
+		m_Shader->Unbind();
+
+		m_CameraBuffer = std::make_unique<UniformBuffer>(sizeof(CameraBlock));
+		m_DrawBuffer = std::make_unique<UniformRingBuffer>((MAX_OBJECTS + 3) * 256);
+
+		m_Shapes[0].Mesh = MakeShape(6, 1.0f);
+		m_Shapes[1].Mesh = MakeShape(4, 1.0f);
+		m_Shapes[2].Mesh = MakeShape(5, 0.45f);
+		for (Shape& shape : m_Shapes) {
+			shape.VAO = std::make_unique<VertexArray>();
+			shape.Vertices = std::make_unique<VertexBuffer>(shape.Mesh->Vertices.data(), (unsigned int)(shape.Mesh->Vertices.size() * sizeof(StaticVertex)));
+			shape.VAO->AddBuffer(*shape.Vertices, STATIC_VERTEX_LAYOUT);
+			shape.Indices = std::make_unique<IndexBuffer>(shape.Mesh->Indices.data(), (unsigned int)shape.Mesh->Indices.size());
+			shape.VAO->Unbind();
+		}
+
+		m_Geometry = std::make_unique<StaticGeometry>(CELL_SIZE);
+		AddObjects(20000);
+	}
+	TestStaticGeometry::~TestStaticGeometry() {
+	}
+	float TestStaticGeometry::NextRandom() {
+		m_Random = m_Random * 1664525u + 1013904223u;
+		return (m_Random >> 8) / 16777216.0f;
+	}
+	void TestStaticGeometry::AddObjects(int count) {
+		for (int i = 0; i < count && m_Objects.size() < MAX_OBJECTS; i++) {
+			Placed object;
+			object.Shape = (int)(NextRandom() * 3.0f) % 3;
+			object.Material = (unsigned int)(NextRandom() * 3.0f) % 3;
+			glm::vec3 position(NextRandom() * WORLD_WIDTH, NextRandom() * WORLD_HEIGHT, 0.0f);
+			object.Transform = glm::translate(glm::mat4(1.0f), position);
+			object.Transform = glm::rotate(object.Transform, NextRandom() * 6.2831853f, glm::vec3(0.0f, 0.0f, 1.0f));
+			object.Transform = glm::scale(object.Transform, glm::vec3(4.0f + NextRandom() * 8.0f));
+			object.Handle = m_Geometry->Add(m_Shapes[object.Shape].Mesh, object.Transform, object.Material);
+			m_Objects.push_back(object);
+		}
+	}
+	void TestStaticGeometry::RemoveObjects(int count) {
+		for (int i = 0; i < count && !m_Objects.empty(); i++) {
+			int index = (int)(NextRandom() * m_Objects.size());
+			m_Geometry->Remove(m_Objects[index].Handle);
+			m_Objects[index] = m_Objects.back();
+			m_Objects.pop_back();
+		}
+	}
+	void TestStaticGeometry::OnUpdate(float deltaTime) {
+		m_Geometry->ResetStats();
+		auto start = std::chrono::steady_clock::now();
+		m_Geometry->Rebuild();
+		const StaticGeometry::Stats& stats = m_Geometry->GetStats();
+		if (stats.BatchesRebuilt > 0) {
+			m_RebuildMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+			m_LastRebuild = stats;
+		}
+	}
+	void TestStaticGeometry::OnRender() {
+		GLCall(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+		glm::mat4 viewProjection = glm::ortho(m_Camera.x, m_Camera.x + 640.0f * m_Zoom, m_Camera.y, m_Camera.y + 960.0f * m_Zoom, -1.0f, 1.0f);
+		m_CameraBuffer->SetData(CameraBlock{ viewProjection });
+		m_CameraBuffer->Bind(CAMERA_BLOCK_BINDING);
+		m_DrawBuffer->Reset();
+		m_DrawCalls = 0;
+
+		Renderer renderer;
+		if (m_Baked) {
+			unsigned int materials[3];
+			for (unsigned int material = 0; material < 3; material++) {
+				materials[material] = m_DrawBuffer->Allocate(DrawBlock{ glm::mat4(1.0f), MATERIAL_COLORS[material] });
+			}
+			m_DrawBuffer->Upload();
+
+			m_Visible.clear();
+			m_Geometry->Cull(viewProjection, m_Visible);
+			unsigned int bound = 0xffffffff;
+			for (const StaticGeometry::Batch* batch : m_Visible) {
+				// Sorted by material, so this changes at most twice
+				if (batch->Material != bound) {
+					m_DrawBuffer->BindRange(DRAW_BLOCK_BINDING, materials[batch->Material], sizeof(DrawBlock));
+					bound = batch->Material;
+				}
+				m_Geometry->Draw(*batch, *m_Shader);
+				m_DrawCalls++;
+			}
+			return;
+		}
+
+		std::vector<unsigned int> draws;
+		draws.reserve(m_Objects.size());
+		for (const Placed& object : m_Objects) {
+			draws.push_back(m_DrawBuffer->Allocate(DrawBlock{ object.Transform, MATERIAL_COLORS[object.Material] }));
+		}
+		m_DrawBuffer->Upload();
+		for (size_t i = 0; i < m_Objects.size(); i++) {
+			const Shape& shape = m_Shapes[m_Objects[i].Shape];
+			m_DrawBuffer->BindRange(DRAW_BLOCK_BINDING, draws[i], sizeof(DrawBlock));
+			renderer.Draw(*shape.VAO, *shape.Indices, *m_Shader);
+			m_DrawCalls++;
+		}
+		// Renderer::Draw bound VAOs behind the cache's back
+		VertexArrayCache::Get().Invalidate();
+	}
+	void TestStaticGeometry::OnImGuiRender() {
+		ImGui::Checkbox("Baked", &m_Baked);
+		ImGui::SliderFloat("Camera X", &m_Camera.x, 0.0f, WORLD_WIDTH - 640.0f);
+		ImGui::SliderFloat("Camera Y", &m_Camera.y, 0.0f, WORLD_HEIGHT - 960.0f);
+		ImGui::SliderFloat("Zoom", &m_Zoom, 0.25f, 4.0f);
+		if (ImGui::Button("Add 1000")) {
+			AddObjects(1000);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Remove 1000")) {
+			RemoveObjects(1000);
+		}
+
+		ImGui::Text("%u objects in %u batches, %u draw calls", m_Geometry->GetObjectCount(), m_Geometry->GetBatchCount(), m_DrawCalls);
+		ImGui::Text("Last rebuild: %u batches, %u vertices in %.3f ms", m_LastRebuild.BatchesRebuilt, m_LastRebuild.VerticesBaked, m_RebuildMilliseconds);
+		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "StaticGeometry.h"
+#include "VertexArray.h"
+#include "UniformBuffer.h"
+#include "Test.h"
+#include <memory>
+#include <vector>
+
+namespace test {
+	// A field of thousands of static shapes in three materials, much larger than the screen, drawn either
+	// one draw per object or baked by StaticGeometry into a few draws per visible cell. Adding and removing
+	// objects only rebakes the batches they're in
+	class TestStaticGeometry : public Test {
+	private:
+		struct Shape {
+			std::shared_ptr<StaticMesh> Mesh;
+			std::unique_ptr<VertexArray> VAO; // Its own buffers, for drawing per object
+			std::unique_ptr<VertexBuffer> Vertices;
+			std::unique_ptr<IndexBuffer> Indices;
+		};
+
+		struct Placed {
+			StaticGeometry::ObjectHandle Handle;
+			int Shape;
+			glm::mat4 Transform;
+			unsigned int Material;
+		};
+
+		Shape m_Shapes[3];
+		std::unique_ptr<StaticGeometry> m_Geometry;
+		std::vector<Placed> m_Objects;
+		std::vector<const StaticGeometry::Batch*> m_Visible;
+		std::shared_ptr<Shader> m_Shader;
+		std::unique_ptr<UniformBuffer> m_CameraBuffer;
+		std::unique_ptr<UniformRingBuffer> m_DrawBuffer;
+		unsigned int m_Random;
+
+		bool m_Baked;
+		glm::vec2 m_Camera; // Bottom left corner of the view in world units
+		float m_Zoom;
+		unsigned int m_DrawCalls; // Last frame
+		float m_RebuildMilliseconds; // Last OnUpdate
+		StaticGeometry::Stats m_LastRebuild;
+
+		float NextRandom();
+		void AddObjects(int count);
+		void RemoveObjects(int count);
+	public:
+		TestStaticGeometry();
+		~TestStaticGeometry();
+
+		void OnUpdate(float deltaTime) override;
+		void OnRender() override;
+		void OnImGuiRender() override;
+	};
+}
@@ -1,4 +1,6 @@
 #include "TestTexture2D.h"
+#include "ShaderLibrary.h"
+#include "TextureLoader.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
@@ -23,31 +25,43 @@ namespace test {
         GLCall(glEnable(GL_BLEND));
         GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
-        m_VAO = std::make_unique<VertexArray>();
+        GpuResources& resources = GpuResources::Get();
+        m_VAO = resources.GetVertexArrays().Create();
+        VertexArray& vao = resources.GetVertexArrays()[m_VAO];
 
-        m_VertexBuffer = std::make_unique<VertexBuffer>(positions, 4 * 4 * sizeof(float));
+        m_VertexBuffer = resources.GetVertexBuffers().Create(positions, 4 * 4 * sizeof(float));
         VertexBufferLayout layout;
         layout.Push<float>(2); // vertex positions
         layout.Push<float>(2); // texture coordinates
-        m_VAO->AddBuffer(*m_VertexBuffer, layout);
+        vao.AddBuffer(resources.GetVertexBuffers()[m_VertexBuffer], layout);
 
-        m_IndexBuffer = std::make_unique<IndexBuffer>(indices, 6);
+        m_IndexBuffer = resources.GetIndexBuffers().Create(indices, 6);
 
         std::string filepath = "res/shaders/Basic.shader";
-        m_Shader = std::make_unique<Shader>(filepath);
+        m_Shader = ShaderLibrary::Get().GetShader(filepath, { "TEXTURED" });
         m_Shader->Bind();
-        m_Shader->SetUniform4f("u_Color", 0.8f, 0.3f, 0.8f, 1.0f);
+        m_Shader->SetUniformBlockBinding("Camera", CAMERA_BLOCK_BINDING);
+        m_Shader->SetUniformBlockBinding("Draw", DRAW_BLOCK_BINDING);
 
-        m_Texture = std::make_unique<Texture>("res/textures/dragonball.png");
-        m_Texture->Bind();
+        m_CameraBuffer = std::make_unique<UniformBuffer>(sizeof(CameraBlock));
+        m_DrawBuffer = std::make_unique<UniformRingBuffer>(64 * 1024);
+
+        // Draws with the placeholder for the first few frames while the PNG decodes
+        m_Texture = resources.GetTextures().Create("res/textures/dragonball.png", TextureLoader::Get());
+        resources.GetTextures()[m_Texture].Bind();
 
         m_Shader->SetUniform1i("u_Texture", 0);
 
-        m_VAO->Unbind();
-        m_IndexBuffer->Unbind();
+        vao.Unbind();
+        resources.GetIndexBuffers()[m_IndexBuffer].Unbind();
         m_Shader->Unbind();
 	}
 	TestTexture2D::~TestTexture2D() {
+        GpuResources& resources = GpuResources::Get();
+        resources.GetVertexArrays().Destroy(m_VAO);
+        resources.GetIndexBuffers().Destroy(m_IndexBuffer);
+        resources.GetTextures().Destroy(m_Texture);
+        resources.GetVertexBuffers().Destroy(m_VertexBuffer);
 	}
 	void TestTexture2D::OnUpdate(float deltaTime) {
 	}
@@ -57,19 +71,23 @@ namespace test {
 
         Renderer renderer;
 
+        // View projection is shared by every draw, the GPU does the per-draw multiply with the model matrix
+        m_CameraBuffer->SetData(CameraBlock{ m_Proj * m_View });
+        m_CameraBuffer->Bind(CAMERA_BLOCK_BINDING);
+
+        m_DrawBuffer->Reset();
+        glm::vec4 color(0.8f, 0.3f, 0.8f, 1.0f);
+        unsigned int drawA = m_DrawBuffer->Allocate(DrawBlock{ glm::translate(glm::mat4(1.0f), m_TranslationA), color });
+        unsigned int drawB = m_DrawBuffer->Allocate(DrawBlock{ glm::translate(glm::mat4(1.0f), m_TranslationB), color });
+        m_DrawBuffer->Upload();
+
         m_Shader->Bind();
-        {
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), m_TranslationA);
-            glm::mat4 mvp = m_Proj * m_View * model;
-            m_Shader->SetUniformMat4f("u_MVP", mvp);
-            renderer.Draw(*m_VAO, *m_IndexBuffer, *m_Shader);
-        }
-        {
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), m_TranslationB);
-            glm::mat4 mvp = m_Proj * m_View * model;
-            m_Shader->SetUniformMat4f("u_MVP", mvp);
-            renderer.Draw(*m_VAO, *m_IndexBuffer, *m_Shader);
-        }
+        // Rebound every frame so the real texture replaces the placeholder once it has streamed in
+        GpuResources::Get().GetTextures()[m_Texture].Bind();
+        m_DrawBuffer->BindRange(DRAW_BLOCK_BINDING, drawA, sizeof(DrawBlock));
+        renderer.Draw(m_VAO, m_IndexBuffer, *m_Shader);
+        m_DrawBuffer->BindRange(DRAW_BLOCK_BINDING, drawB, sizeof(DrawBlock));
+        renderer.Draw(m_VAO, m_IndexBuffer, *m_Shader);
 	}
 	void TestTexture2D::OnImGuiRender() {
         ImGui::SliderFloat3("Translation A", &m_TranslationA.x, 0.0f, 640.0f);
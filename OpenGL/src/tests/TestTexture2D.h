@@ -1,19 +1,22 @@
 #pragma once
 
-#include "VertexBuffer.h"
+#include "GpuResources.h"
 #include "VertexBufferLayout.h"
-#include "Texture.h"
+#include "UniformBuffer.h"
 #include "Test.h"
 #include <memory>
 
 namespace test {
 	class TestTexture2D : public Test {
 	private:
-		std::unique_ptr<VertexArray> m_VAO;
-		std::unique_ptr<IndexBuffer> m_IndexBuffer;
-		std::unique_ptr<Shader> m_Shader;
-		std::unique_ptr<Texture> m_Texture;
-		std::unique_ptr<VertexBuffer> m_VertexBuffer;
+		// Owned by GpuResources, destroyed through it
+		VertexArrayHandle m_VAO;
+		IndexBufferHandle m_IndexBuffer;
+		std::shared_ptr<Shader> m_Shader;
+		TextureHandle m_Texture;
+		VertexBufferHandle m_VertexBuffer;
+		std::unique_ptr<UniformBuffer> m_CameraBuffer;
+		std::unique_ptr<UniformRingBuffer> m_DrawBuffer;
 
 		glm::mat4 m_Proj;
 		glm::mat4 m_View;
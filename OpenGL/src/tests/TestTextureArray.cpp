@@ -0,0 +1,118 @@
+#include "TestTextureArray.h"
+#include "ShaderLibrary.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+namespace test {
+	static const int PATTERN_SIZE = 64;
+	static const int SPRITE_COLUMNS = 8;
+	static const int SPRITE_ROWS = 12;
+
+	TestTextureArray::TestTextureArray() : m_NextPattern(0), m_Proj(glm::ortho(0.0f, 640.0f, 0.0f, 960.0f, -1.0f, 1.0f)) {
+		m_Shader = ShaderLibrary::Get().GetShader("res/shaders/Sprite.shader");
+		m_Shader->Bind();
+		m_Shader->SetUniformBlockBinding("Camera", CAMERA_BLOCK_BINDING);
+		m_Shader->SetUniform1i("u_Textures", 0);
+		m_Shader->Unbind();
+
+		m_CameraBuffer = std::make_unique<UniformBuffer>(sizeof(CameraBlock));
+
+		// Starts small so adding a few more patterns shows the array growing
+		m_Textures = std::make_unique<TextureArray>(PATTERN_SIZE, PATTERN_SIZE, 4);
+		for (int i = 0; i < 3; i++) {
+			AddPattern();
+		}
+		BuildSprites();
+	}
+	TestTextureArray::~TestTextureArray() {
+	}
+	void TestTextureArray::AddPattern() {
+		// Checkerboard in a different color for every pattern
+		int pattern = m_NextPattern++;
+		unsigned char color[3] = { (unsigned char)(pattern * 97 + 40), (unsigned char)(pattern * 57 + 120), (unsigned char)(pattern * 31 + 200) };
+		std::vector<unsigned char> rgba(PATTERN_SIZE * PATTERN_SIZE * 4);
+		int cell = PATTERN_SIZE / (2 + pattern % 4 * 2);
+		for (int y = 0; y < PATTERN_SIZE; y++) {
+			for (int x = 0; x < PATTERN_SIZE; x++) {
+				unsigned char* texel = &rgba[(y * PATTERN_SIZE + x) * 4];
+				bool lit = ((x / cell) + (y / cell)) % 2 == 0;
+				for (int c = 0; c < 3; c++) {
+					texel[c] = lit ? color[c] : color[c] / 4;
+				}
+				texel[3] = 255;
+			}
+		}
+		m_Layers.push_back(m_Textures->Add(rgba.data()));
+	}
+	void TestTextureArray::BuildSprites() {
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+		float size = 640.0f / SPRITE_COLUMNS;
+		for (int row = 0; row < SPRITE_ROWS; row++) {
+			for (int column = 0; column < SPRITE_COLUMNS; column++) {
+				float layer = m_Layers.empty() ? 0.0f : (float)m_Layers[(row * SPRITE_COLUMNS + column) % m_Layers.size()];
+				float x = column * size + 4.0f, y = row * size + 4.0f, extent = size - 8.0f;
+				unsigned int first = (unsigned int)vertices.size() / 5;
+				float quad[] = {
+					x,          y,          0.0f, 0.0f, layer,
+					x + extent, y,          1.0f, 0.0f, layer,
+					x + extent, y + extent, 1.0f, 1.0f, layer,
+					x,          y + extent, 0.0f, 1.0f, layer
+				};
+				vertices.insert(vertices.end(), quad, quad + 20);
+				unsigned int quadIndices[] = { first, first + 1, first + 2, first + 2, first + 3, first };
+				indices.insert(indices.end(), quadIndices, quadIndices + 6);
+			}
+		}
+
+		unsigned int bytes = (unsigned int)(vertices.size() * sizeof(float));
+		if (m_VertexBuffer) {
+			// Same sprites, only their layers change, so the buffers are rewritten rather than recreated
+			m_VertexBuffer->SetData(vertices.data(), bytes);
+			m_VertexBuffer->Flush();
+			return;
+		}
+
+		m_VAO = std::make_unique<VertexArray>();
+		m_VertexBuffer = std::make_unique<VertexBuffer>(vertices.data(), bytes, BufferUsage::Dynamic);
+		VertexBufferLayout layout;
+		layout.Push<float>(2); // vertex positions
+		layout.Push<float>(2); // texture coordinates
+		layout.Push<float>(1); // texture array layer
+		m_VAO->AddBuffer(*m_VertexBuffer, layout);
+		m_IndexBuffer = std::make_unique<IndexBuffer>(indices.data(), (unsigned int)indices.size());
+
+		m_VAO->Unbind();
+		m_IndexBuffer->Unbind();
+	}
+	void TestTextureArray::OnUpdate(float deltaTime) {
+	}
+	void TestTextureArray::OnRender() {
+		GLCall(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+		Renderer renderer;
+
+		m_CameraBuffer->SetData(CameraBlock{ m_Proj });
+		m_CameraBuffer->Bind(CAMERA_BLOCK_BINDING);
+
+		// One bind and one draw however many patterns the sprites use
+		m_Textures->Bind();
+		renderer.Draw(*m_VAO, *m_IndexBuffer, *m_Shader);
+	}
+	void TestTextureArray::OnImGuiRender() {
+		if (ImGui::Button("Add pattern")) {
+			AddPattern();
+			BuildSprites();
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Remove pattern") && m_Layers.size() > 1) {
+			m_Textures->Remove(m_Layers.back());
+			m_Layers.pop_back();
+			BuildSprites();
+		}
+		ImGui::Text("%d patterns in %d layers, %d sprites in 1 draw call", m_Textures->GetLayerCount(), m_Textures->GetLayerCapacity(),
+					SPRITE_COLUMNS * SPRITE_ROWS);
+		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "IndexBuffer.h"
+#include "TextureArray.h"
+#include "UniformBuffer.h"
+#include "Test.h"
+#include <memory>
+#include <vector>
+
+namespace test {
+	// A grid of sprites using several different textures drawn with a single draw call,
+	// each sprite's vertices carry the TextureArray layer it samples
+	class TestTextureArray : public Test {
+	private:
+		std::unique_ptr<VertexArray> m_VAO;
+		std::unique_ptr<VertexBuffer> m_VertexBuffer;
+		std::unique_ptr<IndexBuffer> m_IndexBuffer;
+		std::shared_ptr<Shader> m_Shader;
+		std::unique_ptr<UniformBuffer> m_CameraBuffer;
+		std::unique_ptr<TextureArray> m_Textures;
+		std::vector<int> m_Layers; // In the order they were added
+		int m_NextPattern;
+
+		glm::mat4 m_Proj;
+
+		void AddPattern();
+		void BuildSprites();
+	public:
+		TestTextureArray();
+		~TestTextureArray();
+
+		void OnUpdate(float deltaTime) override;
+		void OnRender() override;
+		void OnImGuiRender() override;
+	};
+}
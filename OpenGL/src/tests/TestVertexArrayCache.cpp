@@ -0,0 +1,179 @@
+#include "TestVertexArrayCache.h"
+#include "ShaderLibrary.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <chrono>
+#include <cmath>
+
+namespace test {
+	static const int MESH_COUNT = 4000;
+
+	// Two formats Basic.shader reads the same way, colors as floats or as normalized bytes
+	struct FloatVertex {
+		glm::vec2 Position;
+		glm::vec2 TexCoord;
+		glm::vec4 Color;
+	};
+
+	struct PackedVertex {
+		glm::vec2 Position;
+		glm::vec2 TexCoord;
+		unsigned char Color[4];
+	};
+
+	static constexpr auto FLOAT_LAYOUT = MakeVertexLayout<FloatVertex>(
+		VERTEX_ATTRIBUTE(FloatVertex, Position),
+		VERTEX_ATTRIBUTE(FloatVertex, TexCoord),
+		VERTEX_ATTRIBUTE(FloatVertex, Color));
+
+	static constexpr auto PACKED_LAYOUT = MakeVertexLayout<PackedVertex>(
+		VERTEX_ATTRIBUTE(PackedVertex, Position),
+		VERTEX_ATTRIBUTE(PackedVertex, TexCoord),
+		VERTEX_ATTRIBUTE(PackedVertex, Color));
+
+	static float NextRandom(unsigned int& state) {
+		state = state * 1664525u + 1013904223u;
+		return (state >> 8) / 16777216.0f;
+	}
+
+	TestVertexArrayCache::TestVertexArrayCache()
+		: m_Proj(glm::ortho(0.0f, 640.0f, 0.0f, 960.0f, -1.0f, 1.0f)), m_UseCache(true),
+		  m_AttribBinding(VertexArrayCache::Get().UsesAttribBinding()), m_SortByFormat(true), m_DrawMilliseconds(0.0f), m_VAOBinds(0) {
+		m_Shader = ShaderLibrary::Get().GetShader("res/shaders/Basic.shader", { "VERTEX_COLOR" });
+		m_Shader->Bind();
+		m_Shader->SetUniformBlockBinding("Camera", CAMERA_BLOCK_BINDING);
+		m_Shader->SetUniformBlockBinding("Draw", DRAW_BLOCK_BINDING);
+		m_Shader->Unbind();
+
+		m_CameraBuffer = std::make_unique<UniformBuffer>(sizeof(CameraBlock));
+		m_DrawBuffer = std::make_unique<UniformBuffer>(sizeof(DrawBlock));
+		m_DrawBuffer->SetData(DrawBlock{ glm::mat4(1.0f), glm::vec4(1.0f) });
+
+		unsigned int random = 2024;
+		std::vector<FloatVertex> floatVertices;
+		std::vector<PackedVertex> packedVertices;
+		std::vector<unsigned int> indices;
+		for (int i = 0; i < MESH_COUNT; i++) {
+			int sides = 3 + (int)(NextRandom(random) * 10.0f);
+			glm::vec2 center(10.0f + NextRandom(random) * 620.0f, 10.0f + NextRandom(random) * 940.0f);
+			float radius = 3.0f + NextRandom(random) * 6.0f;
+			glm::vec4 color(0.3f + 0.7f * NextRandom(random), 0.3f + 0.7f * NextRandom(random), 0.3f + 0.7f * NextRandom(random), 1.0f);
+
+			Mesh mesh;
+			mesh.Packed = i % 2 == 1;
+			floatVertices.clear();
+			packedVertices.clear();
+			for (int side = 0; side < sides; side++) {
+				float angle = 6.2831853f * side / sides;
+				glm::vec2 direction(std::cos(angle), std::sin(angle));
+				glm::vec2 position = center + direction * radius;
+				glm::vec2 texCoord = 0.5f + 0.5f * direction;
+				if (mesh.Packed) {
+					packedVertices.push_back({ position, texCoord, { (unsigned char)(color.r * 255.0f), (unsigned char)(color.g * 255.0f),
+																	 (unsigned char)(color.b * 255.0f), 255 } });
+				}
+				else {
+					floatVertices.push_back({ position, texCoord, color });
+				}
+			}
+			indices.clear();
+			for (int side = 1; side + 1 < sides; side++) {
+				unsigned int triangle[] = { 0, (unsigned int)side, (unsigned int)side + 1 };
+				indices.insert(indices.end(), triangle, triangle + 3);
+			}
+
+			if (mesh.Packed) {
+				mesh.Vertices = std::make_unique<VertexBuffer>(packedVertices.data(), (unsigned int)(packedVertices.size() * sizeof(PackedVertex)));
+			}
+			else {
+				mesh.Vertices = std::make_unique<VertexBuffer>(floatVertices.data(), (unsigned int)(floatVertices.size() * sizeof(FloatVertex)));
+			}
+			mesh.Indices = std::make_unique<IndexBuffer>(indices.data(), (unsigned int)indices.size());
+			mesh.VAO = std::make_unique<VertexArray>();
+			if (mesh.Packed) {
+				mesh.VAO->AddBuffer(*mesh.Vertices, PACKED_LAYOUT);
+			}
+			else {
+				mesh.VAO->AddBuffer(*mesh.Vertices, FLOAT_LAYOUT);
+			}
+			mesh.Indices->Bind();
+			mesh.VAO->Unbind();
+			m_Meshes.push_back(std::move(mesh));
+		}
+
+		// Meshes alternate formats by index, so index order switches format every draw
+		for (unsigned int i = 0; i < m_Meshes.size(); i++) {
+			m_Alternating.push_back(i);
+			if (!m_Meshes[i].Packed) {
+				m_Sorted.push_back(i);
+			}
+		}
+		for (unsigned int i = 0; i < m_Meshes.size(); i++) {
+			if (m_Meshes[i].Packed) {
+				m_Sorted.push_back(i);
+			}
+		}
+	}
+	TestVertexArrayCache::~TestVertexArrayCache() {
+	}
+	void TestVertexArrayCache::OnRender() {
+		GLCall(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+		m_CameraBuffer->SetData(CameraBlock{ m_Proj });
+		m_CameraBuffer->Bind(CAMERA_BLOCK_BINDING);
+		m_DrawBuffer->Bind(DRAW_BLOCK_BINDING);
+
+		VertexArrayCache& cache = VertexArrayCache::Get();
+		cache.SetUseAttribBinding(m_AttribBinding);
+		cache.ResetStats();
+		m_VAOBinds = 0;
+
+		Renderer renderer;
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned int index : m_SortByFormat ? m_Sorted : m_Alternating) {
+			const Mesh& mesh = m_Meshes[index];
+			if (!m_UseCache) {
+				renderer.Draw(*mesh.VAO, *mesh.Indices, *m_Shader);
+				m_VAOBinds++;
+			}
+			else {
+				if (mesh.Packed) {
+					cache.Bind(*mesh.Vertices, mesh.Indices.get(), PACKED_LAYOUT);
+				}
+				else {
+					cache.Bind(*mesh.Vertices, mesh.Indices.get(), FLOAT_LAYOUT);
+				}
+				renderer.Draw(*mesh.Indices, *m_Shader);
+			}
+		}
+		m_DrawMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		// Renderer::Draw bound VAOs behind the cache's back
+		if (!m_UseCache) {
+			cache.Invalidate();
+		}
+	}
+	void TestVertexArrayCache::OnImGuiRender() {
+		ImGui::Checkbox("Vertex array cache", &m_UseCache);
+		if (VertexArrayCache::IsAttribBindingSupported()) {
+			ImGui::SameLine();
+			ImGui::Checkbox("ARB_vertex_attrib_binding", &m_AttribBinding);
+		}
+		else {
+			ImGui::Text("ARB_vertex_attrib_binding not supported, one VAO per buffer set");
+		}
+		ImGui::Checkbox("Sort draws by vertex format", &m_SortByFormat);
+
+		const VertexArrayCache& cache = VertexArrayCache::Get();
+		const VertexArrayCache::Stats& stats = cache.GetStats();
+		if (m_UseCache) {
+			ImGui::Text("%u cached VAOs, %u created this frame", (unsigned int)cache.GetArrayCount(), stats.ArraysCreated);
+			ImGui::Text("VAO binds %u, buffer binds %u, binds skipped %u", stats.ArrayBinds, stats.BufferBinds, stats.BindsSkipped);
+		}
+		else {
+			ImGui::Text("%d VAOs, one per mesh, VAO binds %u", MESH_COUNT, m_VAOBinds);
+		}
+		ImGui::Text("%d meshes, draw loop %.3f ms", MESH_COUNT, m_DrawMilliseconds);
+		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+	}
+}
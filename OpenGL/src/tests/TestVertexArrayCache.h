@@ -0,0 +1,42 @@
+#pragma once
+
+#include "VertexArrayCache.h"
+#include "UniformBuffer.h"
+#include "Test.h"
+#include <memory>
+#include <vector>
+
+namespace test {
+	// Thousands of small meshes, each with its own vertex and index buffer, in two vertex formats. They're drawn
+	// either through a VAO built per mesh or through VertexArrayCache, with ARB_vertex_attrib_binding or without,
+	// in format order or alternating between the two formats, with the VAO and buffer binds each way costs
+	class TestVertexArrayCache : public Test {
+	private:
+		struct Mesh {
+			std::unique_ptr<VertexBuffer> Vertices;
+			std::unique_ptr<IndexBuffer> Indices;
+			std::unique_ptr<VertexArray> VAO; // Its own, for drawing without the cache
+			bool Packed; // Which vertex format
+		};
+
+		std::vector<Mesh> m_Meshes;
+		std::vector<unsigned int> m_Sorted; // Mesh order grouped by format
+		std::vector<unsigned int> m_Alternating; // Mesh order switching format every draw
+		std::shared_ptr<Shader> m_Shader;
+		std::unique_ptr<UniformBuffer> m_CameraBuffer;
+		std::unique_ptr<UniformBuffer> m_DrawBuffer;
+		glm::mat4 m_Proj;
+
+		bool m_UseCache;
+		bool m_AttribBinding;
+		bool m_SortByFormat;
+		float m_DrawMilliseconds; // CPU time of the last frame's draw loop
+		unsigned int m_VAOBinds; // Last frame, without the cache
+	public:
+		TestVertexArrayCache();
+		~TestVertexArrayCache();
+
+		void OnRender() override;
+		void OnImGuiRender() override;
+	};
+}
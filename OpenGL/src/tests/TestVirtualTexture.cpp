@@ -0,0 +1,156 @@
+#include "TestVirtualTexture.h"
+#include "ShaderLibrary.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace test {
+	// Stand-in for real imagery, every tile is computed on demand so it can be as big as the format allows
+	class MandelbrotImage : public TiledImage {
+	public:
+		MandelbrotImage(int size, int tileSize, int border) : TiledImage(MakeHeader(size, tileSize, border)) {
+		}
+
+		bool ReadTile(int level, int x, int y, std::vector<unsigned char>& data) override {
+			int levelSize = std::max(1, GetWidth() >> level);
+			int pageSize = GetPageSize();
+			// Coarse levels show the whole set, fine ones need more iterations to resolve the boundary
+			int maxIterations = std::min(128 + 48 * (GetLevelCount() - 1 - level), 1024);
+			data.resize(GetTileBytes());
+			for (int py = 0; py < pageSize; py++) {
+				int ty = std::min(std::max(y * GetTileSize() - GetBorder() + py, 0), levelSize - 1);
+				double ci = -1.5 + (ty + 0.5) / levelSize * 3.0;
+				for (int px = 0; px < pageSize; px++) {
+					int tx = std::min(std::max(x * GetTileSize() - GetBorder() + px, 0), levelSize - 1);
+					double cr = -2.2 + (tx + 0.5) / levelSize * 3.0;
+					double zr = 0.0, zi = 0.0;
+					int iteration = 0;
+					while (iteration < maxIterations && zr * zr + zi * zi < 4.0) {
+						double temp = zr * zr - zi * zi + cr;
+						zi = 2.0 * zr * zi + ci;
+						zr = temp;
+						iteration++;
+					}
+					unsigned char* texel = &data[((size_t)py * pageSize + px) * 4];
+					float t = iteration == maxIterations ? -1.0f : (float)iteration / 64.0f;
+					for (int c = 0; c < 3; c++) {
+						texel[c] = t < 0.0f ? 0 : (unsigned char)(127.5f + 127.5f * std::cos(6.2831853f * (t + c / 3.0f)));
+					}
+					texel[3] = 255;
+				}
+			}
+			return true;
+		}
+	private:
+		static TiledImageHeader MakeHeader(int size, int tileSize, int border) {
+			TiledImageHeader header = {};
+			memcpy(header.Magic, TILED_IMAGE_MAGIC, 4);
+			header.Version = TILED_IMAGE_VERSION;
+			header.GLFormat = GL_RGBA8;
+			header.Width = header.Height = size;
+			header.TileSize = tileSize;
+			header.Border = border;
+			header.LevelCount = 1;
+			while ((size >> (header.LevelCount - 1)) > tileSize) {
+				header.LevelCount++;
+			}
+			header.TileBytes = (tileSize + 2 * border) * (tileSize + 2 * border) * 4;
+			return header;
+		}
+	};
+
+	TestVirtualTexture::TestVirtualTexture() : m_Center(0.0f), m_Zoom(1.0f) {
+		std::shared_ptr<TiledImage> image = std::make_shared<TiledImage>("res/textures/virtual.gltiles");
+		m_SourceName = "res/textures/virtual.gltiles";
+		if (!image->IsOpen()) {
+			// 131072 squared, about 17 gigapixels
+			image = std::make_shared<MandelbrotImage>(1 << 17, 248, 4);
+			m_SourceName = "Mandelbrot set";
+		}
+		m_VirtualTexture = std::make_unique<VirtualTexture>(image);
+
+		// One quad over the whole image in level 0 texels, the camera does the panning and zooming
+		float width = (float)image->GetWidth(), height = (float)image->GetHeight();
+		float positions[] = {
+			0.0f,  0.0f,   0.0f, 0.0f,
+			width, 0.0f,   1.0f, 0.0f,
+			width, height, 1.0f, 1.0f,
+			0.0f,  height, 0.0f, 1.0f
+		};
+		unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
+
+		m_VAO = std::make_unique<VertexArray>();
+		m_VertexBuffer = std::make_unique<VertexBuffer>(positions, sizeof(positions));
+		VertexBufferLayout layout;
+		layout.Push<float>(2); // vertex positions
+		layout.Push<float>(2); // texture coordinates
+		m_VAO->AddBuffer(*m_VertexBuffer, layout);
+		m_IndexBuffer = std::make_unique<IndexBuffer>(indices, 6);
+		m_VAO->Unbind();
+		m_IndexBuffer->Unbind();
+
+		m_Shader = ShaderLibrary::Get().GetShader("res/shaders/VirtualTexture.shader");
+		m_Shader->Bind();
+		m_Shader->SetUniformBlockBinding("Camera", CAMERA_BLOCK_BINDING);
+		m_Shader->SetUniformBlockBinding("VirtualTexture", VIRTUAL_TEXTURE_BLOCK_BINDING);
+		m_Shader->SetUniform1i("u_Physical", 0);
+		m_Shader->SetUniform1i("u_Indirection", 1);
+		m_Shader->Unbind();
+
+		m_CameraBuffer = std::make_unique<UniformBuffer>(sizeof(CameraBlock));
+
+		// Whole image in view to start with
+		int viewport[4];
+		GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+		m_Center = glm::vec2(width, height) * 0.5f;
+		m_Zoom = std::max(width / viewport[2], height / viewport[3]);
+	}
+	TestVirtualTexture::~TestVirtualTexture() {
+	}
+	void TestVirtualTexture::OnUpdate(float deltaTime) {
+		ImGuiIO& io = ImGui::GetIO();
+		if (io.WantCaptureMouse) {
+			return;
+		}
+		if (ImGui::IsMouseDragging(0)) {
+			// Screen y grows downwards, the image's upwards
+			m_Center.x -= io.MouseDelta.x * m_Zoom;
+			m_Center.y += io.MouseDelta.y * m_Zoom;
+		}
+		if (io.MouseWheel != 0.0f) {
+			m_Zoom *= std::pow(0.8f, io.MouseWheel);
+		}
+		float maxZoom = (float)std::max(m_VirtualTexture->GetImage().GetWidth(), m_VirtualTexture->GetImage().GetHeight()) / 64.0f;
+		m_Zoom = std::min(std::max(m_Zoom, 1.0f / 16.0f), maxZoom);
+	}
+	void TestVirtualTexture::OnRender() {
+		GLCall(glClearColor(0.1f, 0.1f, 0.1f, 1.0f));
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+		int viewport[4];
+		GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+		glm::vec2 half = glm::vec2(viewport[2], viewport[3]) * 0.5f * m_Zoom;
+		glm::vec2 minimum = m_Center - half, maximum = m_Center + half;
+		m_CameraBuffer->SetData(CameraBlock{ glm::ortho(minimum.x, maximum.x, minimum.y, maximum.y, -1.0f, 1.0f) });
+		m_CameraBuffer->Bind(CAMERA_BLOCK_BINDING);
+
+		const TiledImage& image = m_VirtualTexture->GetImage();
+		m_VirtualTexture->Update(minimum.x / image.GetWidth(), minimum.y / image.GetHeight(),
+								 maximum.x / image.GetWidth(), maximum.y / image.GetHeight(), m_Zoom);
+
+		Renderer renderer;
+		m_VirtualTexture->Bind();
+		renderer.Draw(*m_VAO, *m_IndexBuffer, *m_Shader);
+	}
+	void TestVirtualTexture::OnImGuiRender() {
+		const TiledImage& image = m_VirtualTexture->GetImage();
+		ImGui::Text("%s, %dx%d in %d levels", m_SourceName.c_str(), image.GetWidth(), image.GetHeight(), image.GetLevelCount());
+		ImGui::Text("Drag to pan, scroll to zoom");
+		ImGui::Text("%.3f texels per pixel, level %d", m_Zoom, m_VirtualTexture->GetLevel(m_Zoom));
+		ImGui::Text("%d of %d pages resident, %d tiles loading", m_VirtualTexture->GetResidentCount(), m_VirtualTexture->GetPageCount(),
+					m_VirtualTexture->GetLoadingCount());
+		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "IndexBuffer.h"
+#include "VirtualTexture.h"
+#include "UniformBuffer.h"
+#include "Test.h"
+#include <memory>
+
+namespace test {
+	// Pan (drag) and zoom (wheel) around a tiled image far bigger than any texture, streamed through a VirtualTexture.
+	// Shows res/textures/virtual.gltiles from TextureCooker --tiles when there is one, else a generated Mandelbrot set
+	class TestVirtualTexture : public Test {
+	private:
+		std::unique_ptr<VertexArray> m_VAO;
+		std::unique_ptr<VertexBuffer> m_VertexBuffer;
+		std::unique_ptr<IndexBuffer> m_IndexBuffer;
+		std::shared_ptr<Shader> m_Shader;
+		std::unique_ptr<UniformBuffer> m_CameraBuffer;
+		std::unique_ptr<VirtualTexture> m_VirtualTexture;
+		std::string m_SourceName;
+
+		glm::vec2 m_Center; // Level 0 texels
+		float m_Zoom; // Level 0 texels per screen pixel
+	public:
+		TestVirtualTexture();
+		~TestVirtualTexture();
+
+		void OnUpdate(float deltaTime) override;
+		void OnRender() override;
+		void OnImGuiRender() override;
+	};
+}
@@ -0,0 +1,222 @@
+"""Pre-build step: validates every .shader under a directory with glslangValidator and
+embeds the parsed stages into a generated header, so Shader never touches the disk for them.
+
+usage: embed_shaders.py <shader dir> <output header> [--no-validate] [--spirv]
+
+Every keyword permutation is compiled when a file declares few enough keywords, otherwise
+the base variant and each keyword on its own. Any compile error fails the build.
+
+With --spirv each stage is also compiled once to an OpenGL SPIR-V module (ARB_gl_spirv) where
+keyword i is "layout(constant_id = i) const bool", and the words are embedded next to the GLSL.
+The header then defines EMBEDDED_SHADERS_SPIRV, which is what builds Shader's SPIR-V path, so
+that path is opt-in: the project's pre-build step doesn't pass --spirv.
+
+glslangValidator comes with the Vulkan SDK and has to be on PATH, a missing one fails the build
+like a shader error would. Only an explicit --no-validate embeds the GLSL without it, skipping
+--spirv with a warning.
+"""
+import itertools
+import os
+import struct
+import shutil
+import subprocess
+import sys
+import tempfile
+
+MAX_EXHAUSTIVE_KEYWORDS = 4
+STAGE_EXTENSIONS = {'vertex': 'vert', 'fragment': 'frag'}
+
+
+def parse_shader(path):
+    # Mirrors Shader::ParseShader, keep the two in sync
+    keywords = []
+    stages = {'vertex': [], 'fragment': []}
+    current = None
+    with open(path, 'r') as f:
+        for line in f.read().splitlines():
+            if '#keywords' in line:
+                keywords += line[line.index('#keywords') + len('#keywords'):].split()
+            elif '#shader' in line:
+                if 'vertex' in line:
+                    current = 'vertex'
+                elif 'fragment' in line:
+                    current = 'fragment'
+            elif current:
+                stages[current].append(line + '\n')
+    return keywords, {stage: ''.join(lines) for stage, lines in stages.items()}
+
+
+def insert_after_version(source, block):
+    version = source.find('#version')
+    if version == -1:
+        return block + source
+    line_end = source.find('\n', version)
+    if line_end == -1:
+        return source + '\n' + block
+    return source[:line_end + 1] + block + source[line_end + 1:]
+
+
+def inject_keywords(source, keywords, enabled):
+    # Mirrors Shader::InjectKeywords
+    if not keywords:
+        return source
+    block = ''.join('const bool %s = %s;\n' % (keyword, 'true' if keyword in enabled else 'false') for keyword in keywords)
+    return insert_after_version(source, block)
+
+
+def spirv_prelude(source, keywords):
+    # Binding qualifiers need 420pack on a #version 330 source
+    block = '#extension GL_ARB_shading_language_420pack : enable\n'
+    block += ''.join('layout(constant_id = %d) const bool %s = false;\n' % (i, keyword) for i, keyword in enumerate(keywords))
+    return insert_after_version(source, block)
+
+
+def permutations(keywords):
+    if len(keywords) <= MAX_EXHAUSTIVE_KEYWORDS:
+        for count in range(len(keywords) + 1):
+            for combination in itertools.combinations(keywords, count):
+                yield list(combination)
+    else:
+        yield []
+        for keyword in keywords:
+            yield [keyword]
+
+
+def validate(validator, name, keywords, stages, workdir):
+    ok = True
+    for enabled in permutations(keywords):
+        for stage, source in stages.items():
+            stage_file = os.path.join(workdir, 'shader.' + STAGE_EXTENSIONS[stage])
+            with open(stage_file, 'w') as f:
+                f.write(inject_keywords(source, keywords, enabled))
+            result = subprocess.run([validator, stage_file], capture_output=True, text=True)
+            if result.returncode != 0:
+                print('%s(%s) failed to compile [%s]:' % (name, stage, ' '.join(enabled) or 'no keywords'))
+                print(result.stdout + result.stderr)
+                ok = False
+    return ok
+
+
+def compile_spirv(validator, name, keywords, stages, workdir):
+    modules = {}
+    for stage, source in stages.items():
+        stage_file = os.path.join(workdir, 'shader.' + STAGE_EXTENSIONS[stage])
+        module_file = stage_file + '.spv'
+        with open(stage_file, 'w') as f:
+            f.write(spirv_prelude(source, keywords))
+        result = subprocess.run([validator, '-G', '--auto-map-locations', '-o', module_file, stage_file], capture_output=True, text=True)
+        if result.returncode != 0:
+            print('%s(%s) failed to compile to SPIR-V:' % (name, stage))
+            print(result.stdout + result.stderr)
+            return None
+        with open(module_file, 'rb') as f:
+            data = f.read()
+        modules[stage] = list(struct.unpack('<%dI' % (len(data) // 4), data))
+    return modules
+
+
+def word_array(identifier, words):
+    lines = ['constexpr unsigned int %s[] = {' % identifier]
+    for i in range(0, len(words), 8):
+        lines.append('\t' + ', '.join('0x%08x' % word for word in words[i:i + 8]) + ',')
+    lines.append('};')
+    return lines
+
+
+def raw_string(text):
+    # Raw literal delimiter can't appear in GLSL, which has no use for ')glsl"'
+    return 'R"glsl(' + text + ')glsl"'
+
+
+def main():
+    args = [arg for arg in sys.argv[1:] if not arg.startswith('--')]
+    if len(args) != 2:
+        print(__doc__)
+        return 1
+    shader_dir, output = args
+    no_validate = '--no-validate' in sys.argv
+    spirv = '--spirv' in sys.argv
+
+    validator = shutil.which('glslangValidator')
+    if not validator:
+        # Formatted so MSBuild lists them as a build error or warning
+        if not no_validate:
+            print('embed_shaders.py : error : glslangValidator not found on PATH, install the Vulkan SDK '
+                  'or pass --no-validate to embed the shaders unchecked')
+            return 1
+        if spirv:
+            print('embed_shaders.py : warning : glslangValidator not found on PATH, embedding the GLSL without SPIR-V')
+            spirv = False
+
+    # Shaders are looked up by the same relative path the code opens them with, e.g. res/shaders/Basic.shader
+    project_dir = os.path.dirname(os.path.dirname(os.path.abspath(shader_dir.rstrip('/\\'))))
+    entries = []
+    ok = True
+    with tempfile.TemporaryDirectory() as workdir:
+        for filename in sorted(os.listdir(shader_dir)):
+            if not filename.endswith('.shader'):
+                continue
+            path = os.path.join(shader_dir, filename)
+            name = os.path.relpath(os.path.abspath(path), project_dir).replace('\\', '/')
+            keywords, stages = parse_shader(path)
+            if validator and not no_validate:
+                ok = validate(validator, name, keywords, stages, workdir) and ok
+            modules = None
+            if spirv:
+                modules = compile_spirv(validator, name, keywords, stages, workdir)
+                ok = modules is not None and ok
+            entries.append((name, keywords, stages, modules))
+    if not ok:
+        return 1
+
+    lines = [
+        '// Generated by tools/embed_shaders.py from res/shaders, do not edit.',
+        '#pragma once',
+        '',
+        'struct EmbeddedShader {',
+        '\tconst char* Filepath;',
+        '\tconst char* Keywords; // Space separated, same order as the #keywords line',
+        '\tconst char* VertexSource;',
+        '\tconst char* FragmentSource;',
+        '\tconst unsigned int* VertexSpirv; // nullptr unless built with --spirv',
+        '\tunsigned int VertexSpirvWords;',
+        '\tconst unsigned int* FragmentSpirv;',
+        '\tunsigned int FragmentSpirvWords;',
+        '};',
+        '',
+    ]
+    if any(modules for (name, keywords, stages, modules) in entries):
+        lines += ['#define EMBEDDED_SHADERS_SPIRV', '']
+    spirv_refs = []
+    for index, (name, keywords, stages, modules) in enumerate(entries):
+        if modules:
+            vertex, fragment = 's_Spirv%dVertex' % index, 's_Spirv%dFragment' % index
+            lines += word_array(vertex, modules['vertex']) + word_array(fragment, modules['fragment']) + ['']
+            spirv_refs.append('%s, %d, %s, %d' % (vertex, len(modules['vertex']), fragment, len(modules['fragment'])))
+        else:
+            spirv_refs.append('nullptr, 0, nullptr, 0')
+
+    lines.append('constexpr EmbeddedShader s_EmbeddedShaders[] = {')
+    for (name, keywords, stages, modules), spirv_ref in zip(entries, spirv_refs):
+        lines.append('\t{')
+        lines.append('\t\t"%s",' % name)
+        lines.append('\t\t"%s",' % ' '.join(keywords))
+        lines.append('\t\t' + raw_string(stages['vertex']) + ',')
+        lines.append('\t\t' + raw_string(stages['fragment']) + ',')
+        lines.append('\t\t' + spirv_ref)
+        lines.append('\t},')
+    lines.append('};')
+    text = '\n'.join(lines) + '\n'
+
+    # Only touch the header when something changed so the pre-build step doesn't force a rebuild of Shader.cpp
+    if os.path.exists(output):
+        with open(output, 'r') as f:
+            if f.read() == text:
+                return 0
+    with open(output, 'w', newline='\n') as f:
+        f.write(text)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,342 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "BlockCompression.h"
+#include "CookedTexture.h"
+#include "ImageOps.h"
+#include "AtlasBuilder.h"
+#include "TiledImage.h"
+#include "stb_image/stb_image.h"
+
+// Turns a source image into a .gltex container that Texture uploads without any processing:
+//	TextureCooker <input image> <output .gltex> [--format bc1|bc3|bc5|bc7|rgba8] [--quality fast|normal|high] [--no-mips] [--straight-alpha]
+// or packs many small images into atlas pages, written as <output>0.gltex, <output>1.gltex, ... with the UV table in <output>.atlas:
+//	TextureCooker --atlas <output> <input images...> [--page-size N] [--padding N] and the same options as above
+// (padding rounds up to a multiple of 4, pages get mips down to log2(padding) since lower levels would bleed)
+// or cuts a large image into a tiled mip pyramid (.gltiles) for VirtualTexture:
+//	TextureCooker --tiles <input image> <output .gltiles> [--tile-size N] [--border N] and the same options as above
+
+struct Image {
+    int Width, Height;
+    std::vector<unsigned char> Pixels; // RGBA8
+};
+
+static bool ParseFormat(const std::string& name, BlockCompression::Format& format, bool& compressed) {
+    compressed = true;
+    if (name == "bc1") format = BlockCompression::Format::BC1;
+    else if (name == "bc3") format = BlockCompression::Format::BC3;
+    else if (name == "bc5") format = BlockCompression::Format::BC5;
+    else if (name == "bc7") format = BlockCompression::Format::BC7;
+    else if (name == "rgba8") compressed = false;
+    else return false;
+    return true;
+}
+
+static bool ParseQuality(const std::string& name, BlockCompression::Quality& quality) {
+    if (name == "fast") quality = BlockCompression::Quality::Fast;
+    else if (name == "normal") quality = BlockCompression::Quality::Normal;
+    else if (name == "high") quality = BlockCompression::Quality::High;
+    else return false;
+    return true;
+}
+
+struct CookSettings {
+    std::string FormatName; // Picked from the image's alpha when empty
+    BlockCompression::Quality Quality;
+    bool Mips;
+    int MipCount; // Caps the chain when Mips is set, 0 for all of it
+    bool Premultiply;
+};
+
+static bool LoadImage(const std::string& path, Image& image) {
+    int channels;
+    // Decoded straight into the vector rather than into stb_image's own allocation and copied over
+    if (stbi_info(path.c_str(), &image.Width, &image.Height, &channels)) {
+        image.Pixels.resize((size_t)image.Width * image.Height * 4);
+    }
+    if (image.Pixels.empty() || !stbi_load_into(path.c_str(), image.Pixels.data(), image.Pixels.size(), &image.Width, &image.Height, &channels, 4)) {
+        std::cout << "Failed to load " << path << ": " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+    // Flipped here once so Texture never has to
+    ImageOps::FlipVertical(image.Pixels.data(), image.Width, image.Height);
+    return true;
+}
+
+// Picks the format and premultiplies the image if it should be
+static bool PrepareImage(Image& image, const CookSettings& settings, BlockCompression::Format& format, bool& compressed, bool& premultiply) {
+    bool hasAlpha = false;
+    for (size_t i = 3; i < image.Pixels.size() && !hasAlpha; i += 4) {
+        hasAlpha = image.Pixels[i] != 255;
+    }
+
+    // Default to the smallest format that keeps the alpha channel the image actually uses
+    format = hasAlpha ? BlockCompression::Format::BC3 : BlockCompression::Format::BC1;
+    compressed = true;
+    if (!settings.FormatName.empty() && !ParseFormat(settings.FormatName, format, compressed)) {
+        std::cout << "Unknown format " << settings.FormatName << std::endl;
+        return false;
+    }
+
+    // Premultiplying before the mips are built is what stops dark fringes around transparent edges
+    premultiply = settings.Premultiply && !(format == BlockCompression::Format::BC5 && compressed);
+    if (premultiply) {
+        ImageOps::PremultiplyAlpha(image.Pixels.data(), image.Width, image.Height);
+    }
+    return true;
+}
+
+static bool CookTexture(Image image, const std::string& outputPath, const CookSettings& settings, const std::string& inputName) {
+    BlockCompression::Format format;
+    bool compressed, premultiply;
+    if (!PrepareImage(image, settings, format, compressed, premultiply)) {
+        return false;
+    }
+
+    std::vector<Image> levels = { image };
+    if (settings.Mips) {
+        // Normal maps hold vectors, not colors, so only color data is filtered in linear space
+        bool srgb = !(compressed && format == BlockCompression::Format::BC5);
+        std::vector<std::vector<unsigned char>> chain = ImageOps::GenerateMips(image.Pixels.data(), image.Width, image.Height,
+                                                                               ImageOps::MipFilter::Kaiser, srgb, settings.MipCount);
+        for (unsigned int level = 1; level <= chain.size(); level++) {
+            levels.push_back({ std::max(1, image.Width >> level), std::max(1, image.Height >> level), std::move(chain[level - 1]) });
+        }
+    }
+
+    CookedTextureHeader header;
+    memcpy(header.Magic, COOKED_TEXTURE_MAGIC, 4);
+    header.Version = COOKED_TEXTURE_VERSION;
+    header.GLFormat = compressed ? BlockCompression::GetGLFormat(format) : GL_RGBA8;
+    header.Width = image.Width;
+    header.Height = image.Height;
+    header.MipCount = (unsigned int)levels.size();
+    header.Flags = COOKED_FLIPPED | (premultiply ? (unsigned)COOKED_PREMULTIPLIED_ALPHA : 0u);
+
+    std::ofstream stream(outputPath, std::ios::binary);
+    stream.write((const char*)&header, sizeof(header));
+    size_t total = 0;
+    for (const Image& level : levels) {
+        std::vector<unsigned char> data;
+        if (compressed) {
+            data.resize(BlockCompression::GetCompressedSize(format, level.Width, level.Height));
+            BlockCompression::CompressImageParallel(format, level.Pixels.data(), level.Width, level.Height, data.data(), settings.Quality);
+        }
+        else {
+            data = level.Pixels;
+        }
+        unsigned int size = (unsigned int)data.size();
+        stream.write((const char*)&size, sizeof(size));
+        stream.write((const char*)data.data(), size);
+        total += size;
+    }
+    if (!stream) {
+        std::cout << "Failed to write " << outputPath << std::endl;
+        return false;
+    }
+
+    std::cout << inputName << " -> " << outputPath << ": " << image.Width << "x" << image.Height << ", " << levels.size()
+              << " mips, " << total << " bytes (" << (size_t)image.Width * image.Height * 4 << " as RGBA8)" << std::endl;
+    return true;
+}
+
+static int CookAtlas(const std::vector<std::string>& inputs, const std::string& output, int pageSize, int padding, const CookSettings& settings) {
+    std::vector<Image> images(inputs.size());
+    std::vector<int> widths, heights;
+    std::vector<const unsigned char*> pixels;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (!LoadImage(inputs[i], images[i])) {
+            return 1;
+        }
+        widths.push_back(images[i].Width);
+        heights.push_back(images[i].Height);
+        pixels.push_back(images[i].Pixels.data());
+    }
+
+    // One batch, so the packer sees every image at once and fills the pages tallest first
+    AtlasBuilder builder(pageSize, padding);
+    std::vector<int> regions = builder.Add(widths, heights, pixels);
+
+    AtlasBuilder::Table table;
+    table.PageSize = builder.GetPageSize();
+    // Below the levels the gutter covers, sprites would bleed into their neighbours
+    CookSettings pageSettings = settings;
+    pageSettings.MipCount = builder.GetMipCount();
+    for (int page = 0; page < builder.GetPageCount(); page++) {
+        std::string pagePath = output + std::to_string(page) + ".gltex";
+        Image pageImage = { builder.GetPageSize(), builder.GetPageSize(),
+                            std::vector<unsigned char>(builder.GetPage(page), builder.GetPage(page) + (size_t)table.PageSize * table.PageSize * 4) };
+        if (!CookTexture(std::move(pageImage), pagePath, pageSettings, "atlas page " + std::to_string(page))) {
+            return 1;
+        }
+        // Relative to the table, which sits next to the pages
+        table.PageFiles.push_back(pagePath.substr(pagePath.find_last_of("/\\") + 1));
+    }
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (regions[i] < 0) {
+            return 1;
+        }
+        table.Names.push_back(inputs[i]);
+        table.Regions.push_back(builder.GetRegion(regions[i]));
+    }
+    if (!AtlasBuilder::WriteTable(output + ".atlas", table)) {
+        std::cout << "Failed to write " << output << ".atlas" << std::endl;
+        return 1;
+    }
+    std::cout << inputs.size() << " images packed into " << builder.GetPageCount() << " " << table.PageSize << "x" << table.PageSize
+              << " pages, table in " << output << ".atlas" << std::endl;
+    return 0;
+}
+
+static int CookTiles(const std::string& input, const std::string& output, int tileSize, int border, const CookSettings& settings) {
+    // The whole image is decoded at once, so this tops out at what stb_image and memory allow
+    Image image;
+    if (!LoadImage(input, image)) {
+        return 1;
+    }
+    BlockCompression::Format format;
+    bool compressed, premultiply;
+    if (!PrepareImage(image, settings, format, compressed, premultiply)) {
+        return 1;
+    }
+    int pageSize = tileSize + 2 * border;
+    if (tileSize <= 0 || border < 0 || (compressed && pageSize % 4 != 0)) {
+        std::cout << "Tile size plus twice the border has to be a multiple of 4 for block compressed tiles" << std::endl;
+        return 1;
+    }
+
+    TiledImageHeader header;
+    memcpy(header.Magic, TILED_IMAGE_MAGIC, 4);
+    header.Version = TILED_IMAGE_VERSION;
+    header.GLFormat = compressed ? BlockCompression::GetGLFormat(format) : GL_RGBA8;
+    header.Width = image.Width;
+    header.Height = image.Height;
+    header.TileSize = tileSize;
+    header.Border = border;
+    header.LevelCount = 1;
+    while (std::max(image.Width, image.Height) >> (header.LevelCount - 1) > tileSize) {
+        header.LevelCount++;
+    }
+    header.TileBytes = compressed ? BlockCompression::GetCompressedSize(format, pageSize, pageSize) : pageSize * pageSize * 4;
+    header.Flags = COOKED_FLIPPED | (premultiply ? (unsigned)COOKED_PREMULTIPLIED_ALPHA : 0u);
+
+    std::ofstream stream(output, std::ios::binary);
+    stream.write((const char*)&header, sizeof(header));
+    bool srgb = !(compressed && format == BlockCompression::Format::BC5);
+    std::vector<unsigned char> page((size_t)pageSize * pageSize * 4), data(header.TileBytes);
+    size_t tileCount = 0;
+    for (unsigned int level = 0; level < header.LevelCount; level++) {
+        int tilesX = TiledImage::GetTileCount(image.Width, 0, tileSize), tilesY = TiledImage::GetTileCount(image.Height, 0, tileSize);
+        for (int tileY = 0; tileY < tilesY; tileY++) {
+            for (int tileX = 0; tileX < tilesX; tileX++) {
+                // Border texels come from the neighbouring tiles, or repeat the edge of the image
+                for (int y = 0; y < pageSize; y++) {
+                    int sourceY = std::min(std::max(tileY * tileSize - border + y, 0), image.Height - 1);
+                    for (int x = 0; x < pageSize; x++) {
+                        int sourceX = std::min(std::max(tileX * tileSize - border + x, 0), image.Width - 1);
+                        memcpy(&page[((size_t)y * pageSize + x) * 4], &image.Pixels[((size_t)sourceY * image.Width + sourceX) * 4], 4);
+                    }
+                }
+                if (compressed) {
+                    BlockCompression::CompressImageParallel(format, page.data(), pageSize, pageSize, data.data(), settings.Quality);
+                }
+                else {
+                    data = page;
+                }
+                stream.write((const char*)data.data(), header.TileBytes);
+                tileCount++;
+            }
+        }
+
+        if (level + 1 < header.LevelCount) {
+            // Same filtering as Texture's mips, each level built from the one before
+            Image next{};
+            next.Width = std::max(1, image.Width / 2);
+            next.Height = std::max(1, image.Height / 2);
+            next.Pixels.resize((size_t)next.Width * next.Height * 4);
+            ImageOps::Downsample(image.Pixels.data(), image.Width, image.Height, next.Pixels.data(), ImageOps::MipFilter::Kaiser, srgb);
+            image = std::move(next);
+        }
+    }
+    if (!stream) {
+        std::cout << "Failed to write " << output << std::endl;
+        return 1;
+    }
+
+    std::cout << input << " -> " << output << ": " << header.Width << "x" << header.Height << ", " << header.LevelCount << " levels, "
+              << tileCount << " tiles of " << pageSize << "x" << pageSize << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> positional;
+    // Cooking happens once per asset, so spend the time
+    CookSettings settings = { "", BlockCompression::Quality::High, true, 0, true };
+    bool atlas = false, tiles = false;
+    int pageSize = 1024, padding = 4, tileSize = 248, border = 4;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            settings.FormatName = argv[++i];
+        }
+        else if (arg == "--quality" && i + 1 < argc) {
+            if (!ParseQuality(argv[++i], settings.Quality)) {
+                std::cout << "Unknown quality " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--no-mips") {
+            settings.Mips = false;
+        }
+        else if (arg == "--straight-alpha") {
+            settings.Premultiply = false;
+        }
+        else if (arg == "--atlas") {
+            atlas = true;
+        }
+        else if (arg == "--tiles") {
+            tiles = true;
+        }
+        else if (arg == "--tile-size" && i + 1 < argc) {
+            tileSize = std::stoi(argv[++i]);
+        }
+        else if (arg == "--border" && i + 1 < argc) {
+            border = std::stoi(argv[++i]);
+        }
+        else if (arg == "--page-size" && i + 1 < argc) {
+            pageSize = std::stoi(argv[++i]);
+        }
+        else if (arg == "--padding" && i + 1 < argc) {
+            padding = std::stoi(argv[++i]);
+        }
+        else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (atlas && positional.size() >= 2) {
+        return CookAtlas(std::vector<std::string>(positional.begin() + 1, positional.end()), positional[0], pageSize, padding, settings);
+    }
+    if (tiles && positional.size() == 2) {
+        return CookTiles(positional[0], positional[1], tileSize, border, settings);
+    }
+    if (atlas || tiles || positional.size() != 2) {
+        std::cout << "usage: TextureCooker <input image> <output .gltex> [--format bc1|bc3|bc5|bc7|rgba8] [--quality fast|normal|high] "
+                     "[--no-mips] [--straight-alpha]" << std::endl;
+        std::cout << "       TextureCooker --atlas <output> <input images...> [--page-size N] [--padding N] [same options]" << std::endl;
+        std::cout << "       TextureCooker --tiles <input image> <output .gltiles> [--tile-size N] [--border N] [same options]" << std::endl;
+        return 1;
+    }
+
+    Image image;
+    if (!LoadImage(positional[0], image)) {
+        return 1;
+    }
+    return CookTexture(std::move(image), positional[1], settings, positional[0]) ? 0 : 1;
+}